@@ -4,13 +4,176 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include "gsharebase.h"
+#include "../Trace Tools/traceio.h"
+#include "taskpool.h"
+#include "predictors.h"
+#include "profile.h"
+#include "frontend.h"
+
+#define TRACE_BATCH 4096
+
+// One (M, N) point of a design-space sweep
+typedef struct GridPoint {
+    int tableOffset, regSize;
+    long long int missed;
+} GridPoint;
+
+// Shared, read-only input of a sweep plus its result slots
+typedef struct SweepContext {
+    Branch *branches;
+    long long int count;
+    GridPoint *points;
+} SweepContext;
+
+// Chunked run of one predictor: chunk k is simulated from a fresh predictor warmed on the
+// warmup branches before it, so chunks are independent tasks. Optionally the exact serial run
+// is one more task, recording its misses at every chunk boundary for comparison
+typedef struct ChunkContext {
+    Branch *branches;
+    long long int count, warmup;
+    char *spec;
+    int chunks, exact;
+    long long int *missed;          // Per chunk, chunked run
+    long long int *exactMissed;     // Per chunk, serial run (when exact)
+} ChunkContext;
+
+// Width in bits of every prediction counter (-bits, default 2)
+int counterBits = 2;
+
+// Checkpointing (-checkpoint <File>:<Every>[:stop]): full predictor state plus the trace position
+// is written every <Every> branches, through a temporary file so a pre-empted run always leaves
+// a whole checkpoint behind. With stop, the run ends at the first checkpoint (a warm prefix to
+// resume or fork from)
+#define CHECKPOINT_MAGIC "BPCKPT01"
+#define MODE_SINGLE 0
+#define MODE_COMPARE 1
+typedef struct Checkpointing {
+    char *path;
+    long long int every;
+    int stop;
+} Checkpointing;
+Checkpointing checkpointing = {NULL, 0, 0};
+
+// Profiling (-profile <File>[:<Top>]): every predictor of the run counts executions, outcomes,
+// mispredictions and aliasing per static branch; the top branches by mispredictions go to a CSV
+typedef struct Profiling {
+    char *path;
+    int top;
+} Profiling;
+Profiling profiling = {NULL, PROFILE_DEFAULT_TOP};
+
+Predictor *createGShareSpec(int tableOffset, int regSize);
+void runGridPoint(int task, void *context);
+int sweepMain(int argc, char *argv[]);
+int compareMain(int argc, char *argv[]);
+long long int chunkStart(ChunkContext *context, int chunk);
+void runChunk(int task, void *context);
+int chunkMain(int argc, char *argv[]);
+int frontEndMain(int argc, char *argv[]);
+void printComparison(Predictor **predictors, long long int *missed, int count, long long int total);
+
+// Checkpoint Functions
+int parseCheckpointing(char *spec);
+int runPredictors(Predictor **predictors, long long int *missed, int count, TraceReader *trace, char *traceFile, int mode, long long int *total);
+int saveCheckpoint(Predictor **predictors, long long int *missed, int count, char *traceFile, int mode, long long int total, unsigned long long int offset);
+int resumeMain(int argc, char *argv[]);
+int parseProfiling(char *spec);
+int writeProfiles(Predictor **predictors, Profile **profiles, int count);
 
 // argc # of arguments, start at 1 b/c 0 is program name 
 // argv <GPB> <RB> <Trace_File>
 // GPB = # of bits to index history table, RB = size in bits of global register
+// Sweep: -sweep <GPB Min> <GPB Max> <RB Min> <RB Max> <Trace_File> [<Threads>]
+//        every (GPB, RB <= GPB) point from one in-memory copy of the trace
+// Chunked: -chunk <Chunks> <Warmup> <Predictor> <Trace_File> [<Threads> [exact]]
+//          splits the trace into chunks simulated in parallel, each warmed on the <Warmup>
+//          branches before it; exact also runs the serial simulation and reports the deviation
+//          (Threads 0 = every processor)
+// Compare: -p <Predictor> [<Predictor>...] <Trace_File>
+//          any mix of predictor specs (see predictors.h), e.g. -p gshare:14:10 tage:8 perceptron:8
+// Front end: -frontend <GPB> <RB> <BTB Entries> <BTB Ways> <RAS Depth> <Delay> <spec|norepair|retire> <Trace_File>
+//            gshare behind a BTB and return address stack on an extended trace (see traceio.h),
+//            conditional branches resolving <Delay> branches after prediction, with speculative
+//            history repaired on a misprediction, not repaired, or updated only at resolve
+// Resume: -resume <Checkpoint> [<Trace_File>]
+//         continues a checkpointed single or compare run (on its own trace unless one is given)
+// The single, sweep and front end forms may be preceded by -bits <1-4> to change the counter width (default 2 bit);
+// predictor specs give their own width (see predictors.h), so the other forms reject it
+// The single, compare and resume forms may be preceded by -checkpoint <File>:<Every>[:stop]
+// The single and compare forms may be preceded by -profile <CSV>[:<Top>] to write the <Top>
+// (default 20) most mispredicted branches of each predictor, with their aliasing counts
+// Any form may be preceded by -time to report elapsed time and branches per second on stderr
+// Trace_File may be "-" for stdin or a FIFO, and may be gzip or zstd compressed
 int main(int argc, char* argv[]) {
 
+    // Counter width, checkpoint, profile and timing options
+    int bitsGiven = 0;
+    while(argc > 2 && (strcmp(argv[1], "-bits") == 0 || strcmp(argv[1], "-checkpoint") == 0 || strcmp(argv[1], "-profile") == 0 || strcmp(argv[1], "-time") == 0)) {
+        if(strcmp(argv[1], "-time") == 0) {
+            startTraceTimer();
+            argv[1] = argv[0];
+            argc--;
+            argv++;
+            continue;
+        }
+        if(strcmp(argv[1], "-bits") == 0) {
+            counterBits = (int) strtol(argv[2], NULL, 0);
+            if(counterBits < 1 || counterBits > 4) {
+                printf("Bad counter width.\n");
+                return 1;
+            }
+            bitsGiven = 1;
+        }
+        else if(strcmp(argv[1], "-profile") == 0) {
+            if(!parseProfiling(argv[2])) {
+                printf("Bad profile.\n");
+                return 1;
+            }
+        }
+        else if(!parseCheckpointing(argv[2])) {
+            printf("Bad checkpoint.\n");
+            return 1;
+        }
+        argv[2] = argv[0];
+        argc -= 2;
+        argv += 2;
+    }
+
+    // Compare and chunk specs carry their own counter width, and a resumed run keeps its checkpoint's
+    if(bitsGiven && argc > 1 && (strcmp(argv[1], "-p") == 0 || strcmp(argv[1], "-chunk") == 0 || strcmp(argv[1], "-resume") == 0)) {
+        printf("Counter width needs the single, sweep or front end form.\n");
+        return 1;
+    }
+
+    // Only the single, compare and resume forms can be checkpointed
+    if(checkpointing.path != NULL && argc > 1 && (strcmp(argv[1], "-sweep") == 0 || strcmp(argv[1], "-chunk") == 0 || strcmp(argv[1], "-frontend") == 0)) {
+        printf("Checkpointing needs the single, compare or resume form.\n");
+        return 1;
+    }
+
+    // Profiles cover one whole run of the trace
+    if(profiling.path != NULL && argc > 1 && (strcmp(argv[1], "-sweep") == 0 || strcmp(argv[1], "-chunk") == 0 || strcmp(argv[1], "-frontend") == 0 || strcmp(argv[1], "-resume") == 0)) {
+        printf("Profiling needs the single or compare form.\n");
+        return 1;
+    }
+
+    // Sweep mode: decode once, evaluate the whole grid on a thread pool
+    if(argc > 1 && strcmp(argv[1], "-sweep") == 0) return sweepMain(argc, argv);
+
+    // Chunked mode: one predictor over trace chunks in parallel, with warmup overlap
+    if(argc > 1 && strcmp(argv[1], "-chunk") == 0) return chunkMain(argc, argv);
+
+    // Front-end mode: direction, BTB and RAS with pipelined resolution
+    if(argc > 1 && strcmp(argv[1], "-frontend") == 0) return frontEndMain(argc, argv);
+
+    // Compare mode: several predictors driven by one pass over the trace
+    if(argc > 1 && strcmp(argv[1], "-p") == 0) return compareMain(argc, argv);
+
+    // Resume mode: pick up a checkpointed run where it stopped
+    if(argc > 1 && strcmp(argv[1], "-resume") == 0) return resumeMain(argc, argv);
+
     // Ensure valid # of arguments given
     if(argc != 4) {
         printf("Invalid number of arguments.\n");
@@ -19,10 +182,10 @@ int main(int argc, char* argv[]) {
 
     // Read file
     char *traceFile = argv[3];
-    FILE *file = fopen(traceFile, "r");
+    TraceReader *trace = openTrace(traceFile);
 
     // Validate Path
-    if(!file) {
+    if(!trace) {
         printf("Bad Path.\n");
         return 1;
     }
@@ -32,28 +195,434 @@ int main(int argc, char* argv[]) {
     int regSize = (int) strtol(argv[2], NULL, 0);
 
     // Begin simulation
-    char outcome;
-    unsigned long long int address;
-    int missed = 0, predicted = 0, total = 0;
-    Register *globalBranchHistoryRegister = createRegister(regSize);
-    PredTable *BranchHistoryPredictionTable = createTable(tableOffset);
-
-    while(!feof(file)) {
-        fscanf(file, " %llx %c ", &address, &outcome);
-        int res = simulateGShare(outcome, address, globalBranchHistoryRegister, BranchHistoryPredictionTable);
-        if(res == 1) predicted++;
-        else if (res == 0) missed++;
-        total++;
+    Predictor *gshare = createGShareSpec(tableOffset, regSize);
+    if(!gshare) {
+        printf("Bad predictor parameters.\n");
+        closeTrace(trace);
+        return 1;
     }
+    long long int missed = 0, total = 0;
+    int finished = runPredictors(&gshare, &missed, 1, trace, traceFile, MODE_SINGLE, &total);
 
     // End Simulation
-    deleteRegister(globalBranchHistoryRegister);
-    deleteTable(BranchHistoryPredictionTable);
-    fclose(file);
+    deletePredictor(gshare);
+    closeTrace(trace);
+    if(!finished) return 0;
     
     // Calculate missed prediction ratio and output results
-    double missRatio = (double) missed / (double) total;
+    double missRatio = (total > 0) ? (double) missed / (double) total : 0.0;
     printf("%d %d %.5f", regSize, tableOffset, missRatio);
 
     return 0;
-}
\ No newline at end of file
+}
+
+// The gshare predictor for an (M, N) pair at the current counter width, NULL if N > M
+Predictor *createGShareSpec(int tableOffset, int regSize) {
+    char spec[64];
+    snprintf(spec, sizeof(spec), "gshare:%d:%d:%d", tableOffset, regSize, counterBits);
+    return createPredictor(spec);
+}
+
+// Simulates one grid point over the whole in-memory trace
+void runGridPoint(int task, void *context) {
+    SweepContext *sweep = (SweepContext *) context;
+    GridPoint *point = &sweep->points[task];
+    Predictor *gshare = createGShareSpec(point->tableOffset, point->regSize);
+
+    long long int missed = 0;
+    for(long long int i = 0; i < sweep->count; i += TRACE_BATCH) {
+        missed += runPredictor(gshare, sweep->branches + i, (sweep->count - i < TRACE_BATCH) ? (int) (sweep->count - i) : TRACE_BATCH);
+    }
+    point->missed = missed;
+
+    deletePredictor(gshare);
+}
+
+// Entry point for -sweep: prints a table of misprediction ratios, one row per GPB (M)
+// and one column per RB (N); points with N > M are skipped
+int sweepMain(int argc, char *argv[]) {
+    if(argc != 7 && argc != 8) {
+        printf("Invalid number of arguments.\n");
+        return 1;
+    }
+
+    int minOffset = (int) strtol(argv[2], NULL, 0), maxOffset = (int) strtol(argv[3], NULL, 0);
+    int minReg = (int) strtol(argv[4], NULL, 0), maxReg = (int) strtol(argv[5], NULL, 0);
+    int threads = (argc == 8) ? (int) strtol(argv[7], NULL, 0) : defaultThreadCount();
+    if(minOffset < 1 || maxOffset > 30 || minOffset > maxOffset || minReg < 0 || minReg > maxReg || threads < 1) {
+        printf("Bad sweep parameters.\n");
+        return 1;
+    }
+
+    // Decode the trace once
+    TraceReader *trace = openTrace(argv[6]);
+    if(!trace) {
+        printf("Bad Path.\n");
+        return 1;
+    }
+    SweepContext sweep;
+    sweep.branches = readAllBranches(trace, &sweep.count);
+    closeTrace(trace);
+
+    // Largest tables first so the slowest points start early
+    int capacity = (maxOffset - minOffset + 1) * (maxReg - minReg + 1), count = 0;
+    sweep.points = (GridPoint *) malloc(capacity * sizeof(GridPoint));
+    for(int m = maxOffset; m >= minOffset; m--) {
+        for(int n = minReg; n <= maxReg && n <= m; n++) {
+            sweep.points[count].tableOffset = m;
+            sweep.points[count].regSize = n;
+            sweep.points[count].missed = 0;
+            count++;
+        }
+    }
+    runTasks(count, threads, runGridPoint, &sweep);
+
+    // Report: header row of N, then one row per M
+    printf("M\\N");
+    for(int n = minReg; n <= maxReg && n <= maxOffset; n++) printf("\t%d", n);
+    printf("\n");
+    for(int m = minOffset; m <= maxOffset; m++) {
+        printf("%d", m);
+        for(int n = minReg; n <= maxReg && n <= maxOffset; n++) {
+            GridPoint *point = NULL;
+            for(int i = 0; i < count; i++) {
+                if(sweep.points[i].tableOffset == m && sweep.points[i].regSize == n) point = &sweep.points[i];
+            }
+            if(point == NULL) printf("\t-");
+            else printf("\t%.5f", (sweep.count > 0) ? (double) point->missed / (double) sweep.count : 0.0);
+        }
+        printf("\n");
+    }
+
+    free(sweep.points);
+    free(sweep.branches);
+    return 0;
+}
+
+// Entry point for -p: every predictor sees the same branches batch by batch. Prints one row per
+// predictor with its misses, misprediction ratio and modeled storage
+int compareMain(int argc, char *argv[]) {
+    if(argc < 4) {
+        printf("Invalid number of arguments.\n");
+        return 1;
+    }
+
+    int count = argc - 3;
+    Predictor **predictors = (Predictor **) malloc(count * sizeof(Predictor *));
+    long long int *missed = (long long int *) calloc(count, sizeof(long long int));
+    for(int i = 0; i < count; i++) {
+        predictors[i] = createPredictor(argv[i + 2]);
+        if(!predictors[i]) {
+            printf("Bad predictor: %s\n", argv[i + 2]);
+            while(i-- > 0) deletePredictor(predictors[i]);
+            free(predictors);
+            free(missed);
+            return 1;
+        }
+    }
+
+    TraceReader *trace = openTrace(argv[argc - 1]);
+    if(!trace) {
+        printf("Bad Path.\n");
+        for(int i = 0; i < count; i++) deletePredictor(predictors[i]);
+        free(predictors);
+        free(missed);
+        return 1;
+    }
+
+    long long int total = 0;
+    if(runPredictors(predictors, missed, count, trace, argv[argc - 1], MODE_COMPARE, &total)) printComparison(predictors, missed, count, total);
+    closeTrace(trace);
+
+    for(int i = 0; i < count; i++) deletePredictor(predictors[i]);
+    free(predictors);
+    free(missed);
+    return 0;
+}
+
+// First branch of a chunk; chunk == chunks gives the end of the trace
+long long int chunkStart(ChunkContext *context, int chunk) {
+    return context->count * chunk / context->chunks;
+}
+
+// Task 0 is the exact serial run when requested (started first, it's the longest); the others
+// are chunks. A chunk warms a fresh predictor, then counts misses over its own branches
+void runChunk(int task, void *context) {
+    ChunkContext *run = (ChunkContext *) context;
+    Predictor *predictor = createPredictor(run->spec);
+    if(run->exact && task == 0) {
+        for(int k = 0; k < run->chunks; k++) {
+            for(long long int i = chunkStart(run, k); i < chunkStart(run, k + 1); i += TRACE_BATCH) {
+                long long int end = chunkStart(run, k + 1);
+                run->exactMissed[k] += runPredictor(predictor, run->branches + i, (end - i < TRACE_BATCH) ? (int) (end - i) : TRACE_BATCH);
+            }
+        }
+        deletePredictor(predictor);
+        return;
+    }
+
+    int chunk = task - run->exact;
+    long long int start = chunkStart(run, chunk), end = chunkStart(run, chunk + 1);
+    long long int warm = (start > run->warmup) ? start - run->warmup : 0;
+    for(long long int i = warm; i < start; i += TRACE_BATCH) runPredictor(predictor, run->branches + i, (start - i < TRACE_BATCH) ? (int) (start - i) : TRACE_BATCH);
+    for(long long int i = start; i < end; i += TRACE_BATCH) run->missed[chunk] += runPredictor(predictor, run->branches + i, (end - i < TRACE_BATCH) ? (int) (end - i) : TRACE_BATCH);
+    deletePredictor(predictor);
+}
+
+// Entry point for -chunk: prints the chunked misprediction ratio and, with exact, the serial one
+// with the deviation overall and per chunk
+int chunkMain(int argc, char *argv[]) {
+    if(argc < 6 || argc > 8) {
+        printf("Invalid number of arguments.\n");
+        return 1;
+    }
+
+    ChunkContext run;
+    run.chunks = (int) strtol(argv[2], NULL, 0);
+    run.warmup = strtoll(argv[3], NULL, 0);
+    run.spec = argv[4];
+    int threads = (argc >= 7) ? (int) strtol(argv[6], NULL, 0) : 0;
+    if(threads == 0) threads = defaultThreadCount();
+    run.exact = argc == 8 && strcmp(argv[7], "exact") == 0;
+    if(run.chunks < 1 || run.warmup < 0 || threads < 1 || (argc == 8 && !run.exact)) {
+        printf("Bad chunk parameters.\n");
+        return 1;
+    }
+    Predictor *predictor = createPredictor(run.spec);
+    if(!predictor) {
+        printf("Bad predictor: %s\n", run.spec);
+        return 1;
+    }
+
+    // Decode the trace once
+    TraceReader *trace = openTrace(argv[5]);
+    if(!trace) {
+        printf("Bad Path.\n");
+        deletePredictor(predictor);
+        return 1;
+    }
+    run.branches = readAllBranches(trace, &run.count);
+    closeTrace(trace);
+    if(run.chunks > run.count && run.count > 0) run.chunks = (int) run.count;
+    run.missed = (long long int *) calloc(run.chunks, sizeof(long long int));
+    run.exactMissed = (long long int *) calloc(run.chunks, sizeof(long long int));
+    runTasks(run.chunks + run.exact, threads, runChunk, &run);
+
+    // Report
+    long long int missed = 0, exactMissed = 0;
+    for(int k = 0; k < run.chunks; k++) {
+        missed += run.missed[k];
+        exactMissed += run.exactMissed[k];
+    }
+    double ratio = (run.count > 0) ? (double) missed / (double) run.count : 0.0;
+    printf("Predictor\tChunks\tWarmup\tBranches\tMisses\tMissRatio\n");
+    printf("%s\t%d\t%lld\t%lld\t%lld\t%.5f\n", predictor->name, run.chunks, run.warmup, run.count, missed, ratio);
+    if(run.exact) {
+        double exactRatio = (run.count > 0) ? (double) exactMissed / (double) run.count : 0.0;
+        printf("Exact\tMisses: %lld\tMissRatio: %.5f\tDeviation: %+.5f (%+.3f%%)\n", exactMissed, exactRatio, ratio - exactRatio, (exactMissed > 0) ? 100.0 * (double) (missed - exactMissed) / (double) exactMissed : 0.0);
+        printf("Chunk\tStart\tBranches\tMisses\tExactMisses\tDifference\n");
+        for(int k = 0; k < run.chunks; k++) {
+            printf("%d\t%lld\t%lld\t%lld\t%lld\t%+lld\n", k, chunkStart(&run, k), chunkStart(&run, k + 1) - chunkStart(&run, k), run.missed[k], run.exactMissed[k], run.missed[k] - run.exactMissed[k]);
+        }
+    }
+
+    deletePredictor(predictor);
+    free(run.missed);
+    free(run.exactMissed);
+    free(run.branches);
+    return 0;
+}
+
+// Entry point for -frontend: prints the direction, BTB and RAS statistics
+int frontEndMain(int argc, char *argv[]) {
+    if(argc != 10) {
+        printf("Invalid number of arguments.\n");
+        return 1;
+    }
+    int historyMode = (strcmp(argv[8], "spec") == 0) ? HISTORY_SPECULATIVE : (strcmp(argv[8], "norepair") == 0) ? HISTORY_NO_REPAIR : (strcmp(argv[8], "retire") == 0) ? HISTORY_RETIRE : -1;
+    FrontEnd *frontEnd = (historyMode < 0) ? NULL : createFrontEnd((int) strtol(argv[2], NULL, 0), (int) strtol(argv[3], NULL, 0), counterBits, (int) strtol(argv[4], NULL, 0),
+        (int) strtol(argv[5], NULL, 0), (int) strtol(argv[6], NULL, 0), (int) strtol(argv[7], NULL, 0), historyMode);
+    if(!frontEnd) {
+        printf("Bad front end parameters.\n");
+        return 1;
+    }
+
+    TraceReader *trace = openTrace(argv[9]);
+    if(!trace) {
+        printf("Bad Path.\n");
+        deleteFrontEnd(frontEnd);
+        return 1;
+    }
+    runFrontEnd(trace, frontEnd);
+    printFrontEndStats(frontEnd);
+
+    closeTrace(trace);
+    deleteFrontEnd(frontEnd);
+    return 0;
+}
+
+// The compare mode table: one row per predictor, with its misses and modeled storage
+void printComparison(Predictor **predictors, long long int *missed, int count, long long int total) {
+    printf("Predictor\tMisses\tMissRatio\tKB\n");
+    for(int i = 0; i < count; i++) {
+        double kb = (double) predictors[i]->storageBits(predictors[i]->state) / 8192.0;
+        double ratio = (total > 0) ? (double) missed[i] / (double) total : 0.0;
+        printf("%s\t%lld\t%.5f\t%.2f\n", predictors[i]->name, missed[i], ratio, kb);
+    }
+}
+
+// Parses "<File>:<Every>[:stop]" into the checkpoint settings. Returns 1 on success
+int parseCheckpointing(char *spec) {
+    char *colon = strrchr(spec, ':');
+    if(colon != NULL && strcmp(colon, ":stop") == 0) {
+        checkpointing.stop = 1;
+        *colon = '\0';
+        colon = strrchr(spec, ':');
+    }
+    if(colon == NULL || colon == spec) return 0;
+    *colon = '\0';
+    checkpointing.path = spec;
+    checkpointing.every = strtoll(colon + 1, NULL, 0);
+    return checkpointing.every > 0;
+}
+
+// Drives predictors over the rest of the trace, total branches in, accumulating misses and
+// writing checkpoints on the way. Returns 0 if the run stopped at a checkpoint, 1 at the end
+int runPredictors(Predictor **predictors, long long int *missed, int count, TraceReader *trace, char *traceFile, int mode, long long int *total) {
+    long long int next = (checkpointing.path != NULL) ? (*total / checkpointing.every + 1) * checkpointing.every : -1;
+    Branch *batch = (Branch *) malloc(TRACE_BATCH * sizeof(Branch));
+    Profile **profiles = NULL;
+    int size, finished = 1;
+    if(profiling.path != NULL) {
+        profiles = (Profile **) malloc(count * sizeof(Profile *));
+        for(int i = 0; i < count; i++) profiles[i] = createProfile(predictors[i]);
+    }
+    for(;;) {
+        // Stop each batch at the next checkpoint
+        int max = (next >= 0 && next - *total < TRACE_BATCH) ? (int) (next - *total) : TRACE_BATCH;
+        if((size = readBranches(trace, batch, max)) <= 0) break;
+        for(int i = 0; i < count; i++) missed[i] += profiles ? runProfiledPredictor(predictors[i], profiles[i], batch, size) : runPredictor(predictors[i], batch, size);
+        *total += size;
+        if(*total != next) continue;
+
+        if(!saveCheckpoint(predictors, missed, count, traceFile, mode, *total, traceOffset(trace))) printf("Bad checkpoint path.\n");
+        else if(checkpointing.stop) {
+            printf("Checkpoint saved at %lld branches.\n", *total);
+            finished = 0;
+            break;
+        }
+        next += checkpointing.every;
+    }
+    free(batch);
+    if(profiles) {
+        if(!writeProfiles(predictors, profiles, count)) printf("Bad profile path.\n");
+        for(int i = 0; i < count; i++) deleteProfile(profiles[i]);
+        free(profiles);
+    }
+    return finished;
+}
+
+// Writes the mode, counter width, trace position, and every predictor's spec, misses and state.
+// Returns 1 on success
+int saveCheckpoint(Predictor **predictors, long long int *missed, int count, char *traceFile, int mode, long long int total, unsigned long long int offset) {
+    char temporary[1024];
+    snprintf(temporary, sizeof(temporary), "%s.tmp", checkpointing.path);
+    FILE *file = fopen(temporary, "wb");
+    if(!file) return 0;
+
+    int pathLength = (int) strlen(traceFile);
+    int ok = fwrite(CHECKPOINT_MAGIC, 1, 8, file) == 8 && fwrite(&mode, sizeof(int), 1, file) == 1 && fwrite(&counterBits, sizeof(int), 1, file) == 1;
+    ok = ok && fwrite(&count, sizeof(int), 1, file) == 1 && fwrite(&total, sizeof(long long int), 1, file) == 1 && fwrite(&offset, sizeof(unsigned long long int), 1, file) == 1;
+    ok = ok && fwrite(&pathLength, sizeof(int), 1, file) == 1 && fwrite(traceFile, 1, pathLength, file) == (size_t) pathLength;
+    for(int i = 0; i < count && ok; i++) {
+        ok = fwrite(predictors[i]->name, 1, sizeof(predictors[i]->name), file) == sizeof(predictors[i]->name) && fwrite(&missed[i], sizeof(long long int), 1, file) == 1;
+        ok = ok && predictors[i]->save(file, predictors[i]->state);
+    }
+    ok = (fclose(file) == 0) && ok;
+    return ok && rename(temporary, checkpointing.path) == 0;
+}
+
+// Entry point for -resume: rebuilds the predictors of a checkpoint and finishes the run
+int resumeMain(int argc, char *argv[]) {
+    if(argc != 3 && argc != 4) {
+        printf("Invalid number of arguments.\n");
+        return 1;
+    }
+    FILE *file = fopen(argv[2], "rb");
+    if(!file) {
+        printf("Bad Path.\n");
+        return 1;
+    }
+
+    // Header: the run's mode, counter width, trace and position
+    char magic[8], traceFile[1024];
+    int mode, count = 0, pathLength;
+    long long int total;
+    unsigned long long int offset;
+    int ok = fread(magic, 1, 8, file) == 8 && memcmp(magic, CHECKPOINT_MAGIC, 8) == 0;
+    ok = ok && fread(&mode, sizeof(int), 1, file) == 1 && fread(&counterBits, sizeof(int), 1, file) == 1 && fread(&count, sizeof(int), 1, file) == 1;
+    ok = ok && fread(&total, sizeof(long long int), 1, file) == 1 && fread(&offset, sizeof(unsigned long long int), 1, file) == 1;
+    ok = ok && fread(&pathLength, sizeof(int), 1, file) == 1 && pathLength >= 0 && pathLength < (int) sizeof(traceFile);
+    ok = ok && count > 0 && fread(traceFile, 1, pathLength, file) == (size_t) pathLength;
+    if(!ok) {
+        printf("Bad checkpoint.\n");
+        fclose(file);
+        return 1;
+    }
+    traceFile[pathLength] = '\0';
+
+    // Predictors, rebuilt from their specs and loaded
+    Predictor **predictors = (Predictor **) calloc(count, sizeof(Predictor *));
+    long long int *missed = (long long int *) calloc(count, sizeof(long long int));
+    for(int i = 0; i < count && ok; i++) {
+        char name[sizeof(predictors[i]->name)];
+        ok = fread(name, 1, sizeof(name), file) == sizeof(name) && fread(&missed[i], sizeof(long long int), 1, file) == 1;
+        name[sizeof(name) - 1] = '\0';
+        predictors[i] = ok ? createPredictor(name) : NULL;
+        ok = ok && predictors[i] != NULL && predictors[i]->load(file, predictors[i]->state);
+    }
+    fclose(file);
+
+    // Continue the trace from the saved position; the byte offset only holds for the saved trace,
+    // any other is skipped by record count
+    char *path = (argc == 4) ? argv[3] : traceFile;
+    if(strcmp(path, traceFile) != 0) offset = TRACE_NO_OFFSET;
+    TraceReader *trace = ok ? openTrace(path) : NULL;
+    int resumed = 0;
+    if(!ok) printf("Bad checkpoint.\n");
+    else if(!trace || !resumeTrace(trace, offset, total, 1)) printf("Bad Path.\n");
+    else resumed = 1;
+    if(resumed && runPredictors(predictors, missed, count, trace, path, mode, &total)) {
+        if(mode == MODE_COMPARE) printComparison(predictors, missed, count, total);
+        else {
+            int tableOffset = 0, regSize = 0;
+            sscanf(predictors[0]->name, "gshare:%d:%d", &tableOffset, &regSize);
+            printf("%d %d %.5f", regSize, tableOffset, (total > 0) ? (double) missed[0] / (double) total : 0.0);
+        }
+    }
+
+    if(trace) closeTrace(trace);
+    for(int i = 0; i < count; i++) if(predictors[i]) deletePredictor(predictors[i]);
+    free(predictors);
+    free(missed);
+    return resumed ? 0 : 1;
+}
+
+// Parses "<File>[:<Top>]" into the profile settings. Returns 1 on success
+int parseProfiling(char *spec) {
+    char *colon = strrchr(spec, ':');
+    if(colon != NULL && colon != spec && colon[1] != '\0' && strspn(colon + 1, "0123456789") == strlen(colon + 1)) {
+        *colon = '\0';
+        profiling.top = (int) strtol(colon + 1, NULL, 10);
+    }
+    profiling.path = spec;
+    return profiling.top > 0 && spec[0] != '\0';
+}
+
+// Writes every predictor's profile to the profile CSV. Returns 1 on success
+int writeProfiles(Predictor **predictors, Profile **profiles, int count) {
+    FILE *file = fopen(profiling.path, "w");
+    if(!file) return 0;
+    for(int i = 0; i < count; i++) writeProfile(file, predictors[i]->name, profiles[i], profiling.top);
+    return fclose(file) == 0;
+}
@@ -0,0 +1,323 @@
+// Esperandieu Elbon II - UCFID: 5401262
+// EEL4768 Computer Architecture - Suboh Suboh - Fall 2023
+// Front-End Model: BTB, Return Address Stack and Speculative History
+//
+// Drives a gshare predictor (gsharebase.h) through an extended branch trace (traceio.h Control
+// records) the way a fetch unit sees it:
+//   - A set-associative, LRU branch target buffer identifies branches and supplies their targets.
+//     A taken direct branch that misses it is redirected at decode; an indirect jump that misses
+//     it or hits with the wrong target waits for execute, like a misprediction. Branches are
+//     allocated once taken; returns take their target from the RAS instead.
+//   - A return address stack of fixed depth: calls push their fall-through (PC + 4, the same
+//     fixed-width instructions the predictors' PC >> 2 assumes), returns pop. Overflow wraps
+//     around and overwrites the oldest entry, as the hardware's circular stack does.
+//   - Conditional branches resolve <Delay> branches after they are predicted; the counter is
+//     trained only then, at the index computed at prediction. The global history is updated
+//     either speculatively with the prediction at fetch (HISTORY_SPECULATIVE), repaired to the
+//     correct path on a misprediction, or the same without repair (HISTORY_NO_REPAIR), or only
+//     with resolved outcomes (HISTORY_RETIRE), lagging <Delay> branches behind. A misprediction
+//     flushes the pipeline, so every older in-flight branch resolves before the next fetch.
+// With delay 0 and speculative history this is exactly the plain gshare simulation. With repair,
+// delay alone can't change gshare's accuracy: everything in flight was predicted correctly, so
+// its late training only strengthens counters already predicting it. It shows in the other
+// history modes and, through the flushes, in front-end throughput.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define HISTORY_SPECULATIVE 0
+#define HISTORY_NO_REPAIR 1
+#define HISTORY_RETIRE 2
+#define MAX_RAS_DEPTH 1024
+#define MAX_RESOLVE_DELAY 4096
+#define FRONTEND_BATCH 8192
+
+// One BTB way
+typedef struct BTBEntry {
+    unsigned long long int tag;     // Branch PC >> 2
+    unsigned long long int target;
+    unsigned long long int lastUse; // LRU stamp, 0 = invalid
+} BTBEntry;
+
+typedef struct BTB {
+    int sets, ways;
+    BTBEntry *entries;              // sets * ways
+    unsigned long long int clock;
+} BTB;
+
+typedef struct RAS {
+    unsigned long long int *stack;
+    int depth, top, count;          // top: next free slot; count: valid entries (<= depth)
+} RAS;
+
+// A predicted, not yet resolved conditional branch
+typedef struct InFlight {
+    int index;                      // Counter read at prediction
+    char outcome;                   // Resolved outcome
+} InFlight;
+
+typedef struct FrontEnd {
+    PredTable *table;
+    Register *history;              // History predictions read
+    int delay, historyMode;
+    InFlight *queue;                // delay + 1 slots, oldest at head
+    int head, pending;
+    BTB *btb;
+    RAS *ras;
+
+    // Statistics
+    long long int branches, conditional, directionMisses;
+    long long int taken, btbMisses, targetMisses;   // Taken branches; BTB misses and wrong targets among them
+    long long int calls, returns, rasMisses, rasOverflows, rasUnderflows;
+    long long int flushes;          // Pipeline flushes: direction, indirect target and return mispredictions
+} FrontEnd;
+
+// BTB Functions
+BTB *createBTB(int entries, int ways);
+BTBEntry *lookupBTB(unsigned long long int address, BTB *btb);
+void insertBTB(unsigned long long int address, unsigned long long int target, BTB *btb);
+BTB *deleteBTB(BTB *btb);
+
+// RAS Functions
+RAS *createRAS(int depth);
+void pushRAS(unsigned long long int address, RAS *ras);
+int popRAS(unsigned long long int *address, RAS *ras);
+RAS *deleteRAS(RAS *ras);
+
+// Front-End Functions
+FrontEnd *createFrontEnd(int tableOffset, int regSize, int width, int btbEntries, int btbWays, int rasDepth, int delay, int historyMode);
+void resolveOldest(FrontEnd *frontEnd);
+void drainFrontEnd(FrontEnd *frontEnd);
+int predictConditional(unsigned long long int address, char outcome, FrontEnd *frontEnd);
+void simulateControl(Branch *branch, Control *control, FrontEnd *frontEnd);
+void runFrontEnd(TraceReader *trace, FrontEnd *frontEnd);
+void printFrontEndStats(FrontEnd *frontEnd);
+FrontEnd *deleteFrontEnd(FrontEnd *frontEnd);
+
+// Creates an empty BTB of entries branches in ways-way sets. Returns NULL unless entries is a
+// multiple of ways giving a power of two number of sets
+BTB *createBTB(int entries, int ways) {
+    if(entries < 1 || ways < 1 || entries % ways != 0) return NULL;
+    int sets = entries / ways;
+    if((sets & (sets - 1)) != 0) return NULL;
+    BTB *btb = (BTB *) malloc(sizeof(BTB));
+    btb->sets = sets;
+    btb->ways = ways;
+    btb->entries = (BTBEntry *) calloc((size_t) entries, sizeof(BTBEntry));
+    btb->clock = 0;
+    return btb;
+}
+
+// The valid way holding the branch, marked most recently used, or NULL on a miss
+BTBEntry *lookupBTB(unsigned long long int address, BTB *btb) {
+    unsigned long long int tag = address >> 2;
+    BTBEntry *set = &btb->entries[(size_t) (tag & (unsigned long long int) (btb->sets - 1)) * btb->ways];
+    for(int w = 0; w < btb->ways; w++) {
+        if(set[w].lastUse != 0 && set[w].tag == tag) {
+            set[w].lastUse = ++btb->clock;
+            return &set[w];
+        }
+    }
+    return NULL;
+}
+
+// Allocates the branch in its set's least recently used (or an invalid) way
+void insertBTB(unsigned long long int address, unsigned long long int target, BTB *btb) {
+    unsigned long long int tag = address >> 2;
+    BTBEntry *set = &btb->entries[(size_t) (tag & (unsigned long long int) (btb->sets - 1)) * btb->ways], *victim = &set[0];
+    for(int w = 1; w < btb->ways; w++) if(set[w].lastUse < victim->lastUse) victim = &set[w];
+    victim->tag = tag;
+    victim->target = target;
+    victim->lastUse = ++btb->clock;
+}
+
+BTB *deleteBTB(BTB *btb) {
+    free(btb->entries);
+    free(btb);
+    return NULL;
+}
+
+// Creates an empty return address stack of depth entries (0 = no RAS)
+RAS *createRAS(int depth) {
+    RAS *ras = (RAS *) malloc(sizeof(RAS));
+    ras->stack = (unsigned long long int *) malloc((size_t) (depth > 0 ? depth : 1) * sizeof(unsigned long long int));
+    ras->depth = depth;
+    ras->top = ras->count = 0;
+    return ras;
+}
+
+// Push a return address, overwriting the oldest when full
+void pushRAS(unsigned long long int address, RAS *ras) {
+    if(ras->depth == 0) return;
+    ras->stack[ras->top] = address;
+    ras->top = (ras->top + 1) % ras->depth;
+    if(ras->count < ras->depth) ras->count++;
+}
+
+// Pop the predicted return address. Returns 0 if the stack is empty
+int popRAS(unsigned long long int *address, RAS *ras) {
+    if(ras->count == 0) return 0;
+    ras->top = (ras->top + ras->depth - 1) % ras->depth;
+    ras->count--;
+    *address = ras->stack[ras->top];
+    return 1;
+}
+
+RAS *deleteRAS(RAS *ras) {
+    free(ras->stack);
+    free(ras);
+    return NULL;
+}
+
+// Creates the gshare predictor (counters width bits wide), BTB and RAS. Returns NULL on bad parameters
+FrontEnd *createFrontEnd(int tableOffset, int regSize, int width, int btbEntries, int btbWays, int rasDepth, int delay, int historyMode) {
+    if(tableOffset < 1 || tableOffset > 30 || regSize < 0 || regSize > tableOffset) return NULL;
+    if(rasDepth < 0 || rasDepth > MAX_RAS_DEPTH || delay < 0 || delay > MAX_RESOLVE_DELAY) return NULL;
+    BTB *btb = createBTB(btbEntries, btbWays);
+    if(!btb) return NULL;
+
+    FrontEnd *frontEnd = (FrontEnd *) calloc(1, sizeof(FrontEnd));
+    frontEnd->table = createTableWidth(tableOffset, width);
+    frontEnd->history = createRegister(regSize);
+    frontEnd->delay = delay;
+    frontEnd->historyMode = historyMode;
+    frontEnd->queue = (InFlight *) malloc((size_t) (delay + 1) * sizeof(InFlight));
+    frontEnd->btb = btb;
+    frontEnd->ras = createRAS(rasDepth);
+    return frontEnd;
+}
+
+// The oldest in-flight branch resolves: its counter is trained, and under retire-time history
+// its outcome enters the history
+void resolveOldest(FrontEnd *frontEnd) {
+    InFlight *branch = &frontEnd->queue[frontEnd->head];
+    updateEntryState(branch->index, branch->outcome, frontEnd->table);
+    if(frontEnd->historyMode == HISTORY_RETIRE) updateRegister(branch->outcome, frontEnd->history);
+    frontEnd->head = (frontEnd->head + 1) % (frontEnd->delay + 1);
+    frontEnd->pending--;
+}
+
+// Resolve everything in flight (a pipeline flush)
+void drainFrontEnd(FrontEnd *frontEnd) {
+    while(frontEnd->pending > 0) resolveOldest(frontEnd);
+}
+
+// Predicts a conditional branch from the current history and puts it in flight. Returns 1 if
+// the prediction is correct
+int predictConditional(unsigned long long int address, char outcome, FrontEnd *frontEnd) {
+    int index = getIndex(address, frontEnd->history, frontEnd->table);
+    char predicted = (getPrediction(index, frontEnd->table) >= frontEnd->table->threshold) ? 't' : 'n';
+
+    InFlight *branch = &frontEnd->queue[(frontEnd->head + frontEnd->pending) % (frontEnd->delay + 1)];
+    branch->index = index;
+    branch->outcome = outcome;
+    frontEnd->pending++;
+
+    // Speculative history takes the prediction now; with repair, a wrong one is corrected when
+    // the branch resolves, before anything younger on the correct path is fetched
+    if(frontEnd->historyMode != HISTORY_RETIRE) {
+        Register saved = *frontEnd->history;
+        updateRegister(predicted, frontEnd->history);
+        if(predicted != outcome && frontEnd->historyMode == HISTORY_SPECULATIVE) {
+            *frontEnd->history = saved;
+            updateRegister(outcome, frontEnd->history);
+        }
+    }
+    return predicted == outcome;
+}
+
+// One control transfer through the front end
+void simulateControl(Branch *branch, Control *control, FrontEnd *frontEnd) {
+    int taken = branch->outcome == 't', flush = 0;
+    frontEnd->branches++;
+
+    // Direction
+    if(control->type == CONTROL_CONDITIONAL) {
+        frontEnd->conditional++;
+        if(!predictConditional(branch->address, branch->outcome, frontEnd)) {
+            frontEnd->directionMisses++;
+            flush = 1;
+        }
+    }
+    else taken = 1;
+
+    // Target: returns from the RAS, everything else from the BTB
+    if(control->type == CONTROL_CALL) {
+        frontEnd->calls++;
+        if(frontEnd->ras->count == frontEnd->ras->depth && frontEnd->ras->depth > 0) frontEnd->rasOverflows++;
+        pushRAS(branch->address + 4, frontEnd->ras);
+    }
+    BTBEntry *entry = lookupBTB(branch->address, frontEnd->btb);
+    if(taken) {
+        frontEnd->taken++;
+        if(control->type == CONTROL_RETURN) {
+            unsigned long long int predicted = 0;
+            int popped = popRAS(&predicted, frontEnd->ras);
+            frontEnd->returns++;
+            frontEnd->rasUnderflows += !popped;
+            if(!popped || predicted != control->target) {
+                frontEnd->rasMisses++;
+                flush = 1;
+            }
+            if(!entry) frontEnd->btbMisses++;
+        }
+        else if(!entry) {
+            frontEnd->btbMisses++;
+            flush = flush || control->type == CONTROL_INDIRECT;
+        }
+        else if(entry->target != control->target && control->target != 0) {
+            frontEnd->targetMisses++;
+            flush = 1;
+        }
+        if(!entry) insertBTB(branch->address, control->target, frontEnd->btb);
+        else if(control->type != CONTROL_RETURN) entry->target = control->target;
+    }
+
+    // A misprediction flushes the pipeline; otherwise the oldest branch resolves once <Delay> are in flight
+    if(flush) {
+        frontEnd->flushes++;
+        drainFrontEnd(frontEnd);
+    }
+    while(frontEnd->pending > frontEnd->delay) resolveOldest(frontEnd);
+}
+
+// Runs the rest of the trace through the front end
+void runFrontEnd(TraceReader *trace, FrontEnd *frontEnd) {
+    Branch *batch = (Branch *) malloc(FRONTEND_BATCH * sizeof(Branch));
+    Control *controls = (Control *) malloc(FRONTEND_BATCH * sizeof(Control));
+    int size;
+    while((size = readControls(trace, batch, controls, FRONTEND_BATCH)) > 0) {
+        for(int i = 0; i < size; i++) simulateControl(&batch[i], &controls[i], frontEnd);
+    }
+    drainFrontEnd(frontEnd);
+    free(batch);
+    free(controls);
+}
+
+// Direction, BTB and RAS results, with each kind of redirect per thousand branches (the BTB rate
+// counts both misses and wrong targets)
+void printFrontEndStats(FrontEnd *frontEnd) {
+    static const char *modes[] = {"speculative", "no repair", "retire"};
+    double perKilo = (frontEnd->branches > 0) ? 1000.0 / (double) frontEnd->branches : 0.0;
+    printf("FrontEnd: gshare %d:%d, BTB %d x %d, RAS %d, delay %d, %s history\n", frontEnd->table->offset, frontEnd->history->size,
+        frontEnd->btb->sets, frontEnd->btb->ways, frontEnd->ras->depth, frontEnd->delay, modes[frontEnd->historyMode]);
+    printf("Branches: %lld\tConditional: %lld\tTaken: %lld\tFlushes: %lld\tFlushes/1K branches: %.2f\n", frontEnd->branches, frontEnd->conditional, frontEnd->taken, frontEnd->flushes, frontEnd->flushes * perKilo);
+    printf("Direction\tMisses: %lld\tMissRatio: %.5f\tMisses/1K branches: %.2f\n", frontEnd->directionMisses,
+        (frontEnd->conditional > 0) ? (double) frontEnd->directionMisses / (double) frontEnd->conditional : 0.0, frontEnd->directionMisses * perKilo);
+    printf("BTB\tMisses: %lld\tMissRatio: %.5f\tWrongTargets: %lld\tRedirects/1K branches: %.2f\n", frontEnd->btbMisses,
+        (frontEnd->taken > 0) ? (double) frontEnd->btbMisses / (double) frontEnd->taken : 0.0, frontEnd->targetMisses, (frontEnd->btbMisses + frontEnd->targetMisses) * perKilo);
+    printf("RAS\tCalls: %lld\tReturns: %lld\tMisses: %lld\tOverflows: %lld\tUnderflows: %lld\tMisses/1K branches: %.2f\n", frontEnd->calls, frontEnd->returns,
+        frontEnd->rasMisses, frontEnd->rasOverflows, frontEnd->rasUnderflows, frontEnd->rasMisses * perKilo);
+}
+
+// De-allocate the predictor, BTB and RAS
+FrontEnd *deleteFrontEnd(FrontEnd *frontEnd) {
+    deleteTable(frontEnd->table);
+    deleteRegister(frontEnd->history);
+    free(frontEnd->queue);
+    deleteBTB(frontEnd->btb);
+    deleteRAS(frontEnd->ras);
+    free(frontEnd);
+    return NULL;
+}
@@ -2,6 +2,7 @@
 // EEL4768 Computer Architecture - Suboh Suboh - Fall 2023
 // Implementing a Branch Predictor Simulator 
 
+#include <stdio.h>
 #include <stdlib.h>
 #include <math.h>
 
@@ -17,6 +18,8 @@ Register *updateMSB(char outcome, Register *reg);
 Register *updateRegister(char outcome, Register *reg);
 Register *clearRegister(Register *reg);
 Register *deleteRegister(Register *reg);
+int saveRegister(FILE *file, Register *reg);
+int loadRegister(FILE *file, Register *reg);
 
 // Create a Register of the indicated size (in bits)
 Register *createRegister(int size) {
@@ -37,7 +40,7 @@ Register *updateMSB(char outcome, Register *reg) {
     int newMSB = 0;
 
     // If register size < 1, there's not actually a register so even if taken, don't update
-    if (outcome == 't' && reg->size > 0) newMSB = (newMSB + 1) << reg->size - 1;
+    if (outcome == 't' && reg->size > 0) newMSB = (newMSB + 1) << (reg->size - 1);
     reg->data = reg->data | newMSB;
     return reg;
 }
@@ -61,21 +64,50 @@ Register *deleteRegister(Register *reg) {
     return NULL;
 }
 
+// Write the register to a checkpoint. Returns 1 on success
+int saveRegister(FILE *file, Register *reg) {
+    return fwrite(&reg->size, sizeof(int), 1, file) == 1 && fwrite(&reg->data, sizeof(unsigned long long int), 1, file) == 1;
+}
+
+// Read a register saved by saveRegister; its size must match. Returns 1 on success
+int loadRegister(FILE *file, Register *reg) {
+    int size;
+    if(fread(&size, sizeof(int), 1, file) != 1 || size != reg->size) return 0;
+    return fread(&reg->data, sizeof(unsigned long long int), 1, file) == 1;
+}
+
 // Global Branch Prediction History Table
+// Saturating counters are packed into 64-bit words, 64 / slot bits per word. Counters may be
+// 1-4 bits wide; a 3 bit counter occupies a 4 bit slot so slots never straddle words.
 typedef struct PredTable {
     int offset;     // # of bits used to index table
     int size;       // How large the table is: 2^offset
-    int *table;     
+    int width;      // Bits per counter
+    int slotShift;  // log2(bits per slot)
+    int wordShift;  // log2(counters per word)
+    int threshold;  // Counter states >= threshold predict taken: 2^(width - 1)
+    unsigned long long int *table;  // Packed counters
+    unsigned long long int counterMask;    // Lowest width bits set
     unsigned long long int mask;    // Bit mask used to retrieve the lowest M bits from the branch address
 } PredTable;
 
 PredTable *createTable(int size);
+PredTable *createTableWidth(int offset, int width);
 int getEntryState(int index, PredTable *ptbl);
 PredTable *updateEntryState(int index, char outcome, PredTable *ptbl);
+unsigned long long int tableStorageBits(PredTable *ptbl);
+PredTable *resetTable(PredTable *ptbl);
 PredTable *deleteTable(PredTable *ptbl);
+int saveTable(FILE *file, PredTable *ptbl);
+int loadTable(FILE *file, PredTable *ptbl);
 
-// Creates a history table with the indicated offset of size 2^(offset)
+// Creates a history table of 2 bit counters with the indicated offset of size 2^(offset)
 PredTable *createTable(int offset) {
+    return createTableWidth(offset, 2);
+}
+
+// Creates a history table of counters width bits wide (1-4) with size 2^(offset)
+PredTable *createTableWidth(int offset, int width) {
     PredTable *ptbl = (PredTable *) malloc(sizeof(PredTable));
     ptbl->offset = offset;
 
@@ -83,27 +115,52 @@ PredTable *createTable(int offset) {
     ptbl->size = (int) pow(2,offset);
 
     // Initialize mask to be used in indexing  
-    ptbl->mask = 1 << offset - 1;
+    ptbl->mask = 1 << (offset - 1);
     ptbl->mask = 2*ptbl->mask - 1;
-    
-    // Initialize each entry to weakly taken (2)
-    ptbl-> table = (int *) malloc(ptbl->size * sizeof(int));
-    for(int i = 0; i < ptbl->size; i++) ptbl->table[i] = 2;
+
+    // Packing geometry: 1, 2 or 4 bit slots
+    ptbl->width = width;
+    ptbl->slotShift = (width <= 1) ? 0 : (width == 2) ? 1 : 2;
+    ptbl->wordShift = 6 - ptbl->slotShift;
+    ptbl->threshold = 1 << (width - 1);
+    ptbl->counterMask = (1ULL << width) - 1;
+
+    int words = (ptbl->size + (1 << ptbl->wordShift) - 1) >> ptbl->wordShift;
+    ptbl->table = (unsigned long long int *) malloc(words * sizeof(unsigned long long int));
+    return resetTable(ptbl);
+}
+
+// Sets each entry back to weakly taken (2^(width - 1)), a whole word at a time
+PredTable *resetTable(PredTable *ptbl) {
+    unsigned long long int pattern = 0;
+    for(int slot = 0; slot < (1 << ptbl->wordShift); slot++) pattern |= (unsigned long long int) ptbl->threshold << (slot << ptbl->slotShift);
+    int words = (ptbl->size + (1 << ptbl->wordShift) - 1) >> ptbl->wordShift;
+    for(int i = 0; i < words; i++) ptbl->table[i] = pattern;
     return ptbl;
 }
 
-// Retrieves the smith 2 bit counter state of an entry in the table at the given index
+// Retrieves the smith counter state of an entry in the table at the given index
 int getEntryState(int index, PredTable *ptbl) {
-    return ptbl->table[index];
+    int shift = (index & ((1 << ptbl->wordShift) - 1)) << ptbl->slotShift;
+    return (int) ((ptbl->table[index >> ptbl->wordShift] >> shift) & ptbl->counterMask);
 }
 
-// Updates the smith 2 bit counter state of an entry in the table at the given index with respect to the indicated outcome
+// Updates the smith counter state of an entry in the table at the given index with respect to the indicated outcome.
+// The field is rewritten in place by XORing the old and new states into its word
 PredTable *updateEntryState(int index, char outcome, PredTable *ptbl) {
-    if(outcome == 't' && ptbl->table[index] < 3) ptbl->table[index]++;
-    else if(outcome == 'n' && ptbl->table[index] > 0) ptbl->table[index]--;
+    unsigned long long int *word = &ptbl->table[index >> ptbl->wordShift];
+    int shift = (index & ((1 << ptbl->wordShift) - 1)) << ptbl->slotShift;
+    unsigned long long int state = (*word >> shift) & ptbl->counterMask;
+    unsigned long long int next = state + (outcome == 't' && state < ptbl->counterMask) - (outcome == 'n' && state > 0);
+    *word ^= (state ^ next) << shift;
     return ptbl;
 }
 
+// Bits of counter state the table models (excluding packing slack)
+unsigned long long int tableStorageBits(PredTable *ptbl) {
+    return (unsigned long long int) ptbl->size * ptbl->width;
+}
+
 // De-allocate space allocated for the table
 PredTable *deleteTable(PredTable *ptbl) {
     free(ptbl->table);
@@ -111,6 +168,21 @@ PredTable *deleteTable(PredTable *ptbl) {
     return NULL;
 }
 
+// Write the table's geometry and packed counters to a checkpoint. Returns 1 on success
+int saveTable(FILE *file, PredTable *ptbl) {
+    int words = (ptbl->size + (1 << ptbl->wordShift) - 1) >> ptbl->wordShift;
+    if(fwrite(&ptbl->offset, sizeof(int), 1, file) != 1 || fwrite(&ptbl->width, sizeof(int), 1, file) != 1) return 0;
+    return fwrite(ptbl->table, sizeof(unsigned long long int), words, file) == (size_t) words;
+}
+
+// Read counters saved by saveTable into a table of the same geometry. Returns 1 on success
+int loadTable(FILE *file, PredTable *ptbl) {
+    int offset, width, words = (ptbl->size + (1 << ptbl->wordShift) - 1) >> ptbl->wordShift;
+    if(fread(&offset, sizeof(int), 1, file) != 1 || fread(&width, sizeof(int), 1, file) != 1) return 0;
+    if(offset != ptbl->offset || width != ptbl->width) return 0;
+    return fread(ptbl->table, sizeof(unsigned long long int), words, file) == (size_t) words;
+}
+
 // Gshare operations
 int getIndex(unsigned long long int branchAddress, Register *reg, PredTable* ptbl);
 int getPrediction(int index, PredTable* ptbl);
@@ -149,8 +221,8 @@ int simulateGShare(char actualOutcome, unsigned long long int branchAddress, Reg
     
     // Compare actuality with prediction: Incorrect = 0, Correct = 1
     int res;
-    if(actualOutcome == 't' && predictedOutcome > 1) res = 1;
-    else if(actualOutcome == 'n' && predictedOutcome < 2) res = 1;
+    if(actualOutcome == 't' && predictedOutcome >= ptbl->threshold) res = 1;
+    else if(actualOutcome == 'n' && predictedOutcome < ptbl->threshold) res = 1;
     else res = 0;
 
     // Update prediction table and global history register based on actual outcome
@@ -0,0 +1,754 @@
+// Esperandieu Elbon II - UCFID: 5401262
+// EEL4768 Computer Architecture - Suboh Suboh - Fall 2023
+// Pluggable Branch Predictors
+//
+// Every predictor family implements the same interface (predict, update, reset, storage bits,
+// checkpoint save/load) behind a Predictor handle, so one trace loop can drive any mix of them
+// side by side. Single-table families also report the entry each prediction read, for profiling.
+// Predictors are built from a spec string:
+//   bimodal:<M>[:<bits>]          2^M counters indexed by PC
+//   gshare:<M>:<N>[:<bits>]       the gsharebase.h predictor (M index bits, N history bits)
+//   tournament:<M>:<N>            gshare(M, N) and bimodal(M) with a 2^M PC-indexed chooser
+//   perceptron:<KB>[:<tables>]    hashed perceptron sized to a storage budget (4 tables below 8 KB, else 8)
+//   tage:<KB>[:<tables>]          TAGE tagged geometric-history tables sized to a storage budget
+//                                 (7 tagged tables below 16 KB, else 10)
+// Requires gsharebase.h and traceio.h to be included first.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define HISTORY_BUFFER 4096         // Global history bits kept, power of 2 > longest history
+#define MAX_SPEC_FIELDS 3
+#define PERCEPTRON_MAX_TABLES 16
+#define TAGE_MAX_TABLES 12
+#define TAGE_USEFUL_PERIOD (1 << 18)    // Branches between graceful useful-bit resets
+
+// Predictor handle: family state plus the operations on it
+typedef struct Predictor {
+    char name[64];
+    void *state;
+    int (*predict)(unsigned long long int address, void *state);                // 1 = taken
+    void (*update)(unsigned long long int address, int taken, int predicted, void *state);
+    void (*reset)(void *state);
+    unsigned long long int (*storageBits)(void *state);
+    void (*destroy)(void *state);
+    int (*save)(FILE *file, void *state);   // Checkpoint the full state. Returns 1 on success
+    int (*load)(FILE *file, void *state);   // Restore a state saved from the same spec
+    int (*slot)(void *state);   // Pattern table entry the last predict read; NULL without one table
+    long long int slots;        // Entries slot can return
+} Predictor;
+
+// Long global history: bits[pointer] is the newest outcome
+typedef struct History {
+    unsigned char *bits;
+    int pointer;
+    unsigned int path;              // Low PC bits of recent branches
+} History;
+
+// A history of original bits folded (XORed) down to length bits, updated incrementally
+typedef struct FoldedHistory {
+    unsigned int value;
+    int length, original, outpoint;
+} FoldedHistory;
+
+// Predictor Functions
+Predictor *createPredictor(const char *spec);
+long long int runPredictor(Predictor *predictor, Branch *batch, int count);
+Predictor *deletePredictor(Predictor *predictor);
+
+// History Functions
+History *createHistory();
+void pushHistory(int taken, unsigned long long int address, History *history);
+void initFolded(int original, int length, FoldedHistory *folded);
+void updateFolded(History *history, FoldedHistory *folded);
+History *deleteHistory(History *history);
+int saveHistory(FILE *file, History *history);
+int loadHistory(FILE *file, History *history);
+
+// Create an empty (all not-taken) global history
+History *createHistory() {
+    History *history = (History *) malloc(sizeof(History));
+    history->bits = (unsigned char *) calloc(HISTORY_BUFFER, 1);
+    history->pointer = 0;
+    history->path = 0;
+    return history;
+}
+
+// Shift an outcome into the history
+void pushHistory(int taken, unsigned long long int address, History *history) {
+    history->pointer = (history->pointer - 1) & (HISTORY_BUFFER - 1);
+    history->bits[history->pointer] = (unsigned char) taken;
+    history->path = (history->path << 1) ^ (unsigned int) ((address >> 2) & 1);
+}
+
+void initFolded(int original, int length, FoldedHistory *folded) {
+    folded->value = 0;
+    folded->length = length;
+    folded->original = original;
+    folded->outpoint = original % length;
+}
+
+// Fold in the newest bit and fold out the one that just left the original window
+void updateFolded(History *history, FoldedHistory *folded) {
+    folded->value = (folded->value << 1) ^ history->bits[history->pointer];
+    folded->value ^= (unsigned int) history->bits[(history->pointer + folded->original) & (HISTORY_BUFFER - 1)] << folded->outpoint;
+    folded->value ^= folded->value >> folded->length;
+    folded->value &= (1u << folded->length) - 1;
+}
+
+History *deleteHistory(History *history) {
+    free(history->bits);
+    free(history);
+    return NULL;
+}
+
+int saveHistory(FILE *file, History *history) {
+    return fwrite(history->bits, 1, HISTORY_BUFFER, file) == HISTORY_BUFFER && fwrite(&history->pointer, sizeof(int), 1, file) == 1
+        && fwrite(&history->path, sizeof(unsigned int), 1, file) == 1;
+}
+
+int loadHistory(FILE *file, History *history) {
+    return fread(history->bits, 1, HISTORY_BUFFER, file) == HISTORY_BUFFER && fread(&history->pointer, sizeof(int), 1, file) == 1
+        && fread(&history->path, sizeof(unsigned int), 1, file) == 1;
+}
+
+// Bimodal: one counter per PC
+typedef struct Bimodal {
+    PredTable *table;
+    int index;
+} Bimodal;
+
+int predictBimodal(unsigned long long int address, void *state) {
+    Bimodal *bimodal = (Bimodal *) state;
+    bimodal->index = (int) ((address >> 2) & bimodal->table->mask);
+    return getEntryState(bimodal->index, bimodal->table) >= bimodal->table->threshold;
+}
+
+void updateBimodal(unsigned long long int address, int taken, int predicted, void *state) {
+    (void) address;
+    (void) predicted;
+    Bimodal *bimodal = (Bimodal *) state;
+    updateEntryState(bimodal->index, taken ? 't' : 'n', bimodal->table);
+}
+
+void resetBimodal(void *state) {
+    resetTable(((Bimodal *) state)->table);
+}
+
+unsigned long long int bimodalStorageBits(void *state) {
+    return tableStorageBits(((Bimodal *) state)->table);
+}
+
+void destroyBimodal(void *state) {
+    Bimodal *bimodal = (Bimodal *) state;
+    deleteTable(bimodal->table);
+    free(bimodal);
+}
+
+int saveBimodal(FILE *file, void *state) {
+    return saveTable(file, ((Bimodal *) state)->table);
+}
+
+int loadBimodal(FILE *file, void *state) {
+    return loadTable(file, ((Bimodal *) state)->table);
+}
+
+int bimodalSlot(void *state) {
+    return ((Bimodal *) state)->index;
+}
+
+Bimodal *createBimodal(int offset, int width) {
+    Bimodal *bimodal = (Bimodal *) malloc(sizeof(Bimodal));
+    bimodal->table = createTableWidth(offset, width);
+    bimodal->index = 0;
+    return bimodal;
+}
+
+// Gshare: the gsharebase.h register and table, so results match simulateGShare exactly
+typedef struct GShare {
+    Register *reg;
+    PredTable *table;
+    int index;
+} GShare;
+
+int predictGShare(unsigned long long int address, void *state) {
+    GShare *gshare = (GShare *) state;
+    gshare->index = getIndex(address, gshare->reg, gshare->table);
+    return getPrediction(gshare->index, gshare->table) >= gshare->table->threshold;
+}
+
+void updateGShare(unsigned long long int address, int taken, int predicted, void *state) {
+    (void) address;
+    (void) predicted;
+    GShare *gshare = (GShare *) state;
+    char outcome = taken ? 't' : 'n';
+    updateEntryState(gshare->index, outcome, gshare->table);
+    updateRegister(outcome, gshare->reg);
+}
+
+void resetGShare(void *state) {
+    GShare *gshare = (GShare *) state;
+    gshare->reg->data = 0;
+    resetTable(gshare->table);
+}
+
+unsigned long long int gshareStorageBits(void *state) {
+    GShare *gshare = (GShare *) state;
+    return tableStorageBits(gshare->table) + gshare->reg->size;
+}
+
+void destroyGShare(void *state) {
+    GShare *gshare = (GShare *) state;
+    deleteRegister(gshare->reg);
+    deleteTable(gshare->table);
+    free(gshare);
+}
+
+int saveGShare(FILE *file, void *state) {
+    GShare *gshare = (GShare *) state;
+    return saveRegister(file, gshare->reg) && saveTable(file, gshare->table);
+}
+
+int loadGShare(FILE *file, void *state) {
+    GShare *gshare = (GShare *) state;
+    return loadRegister(file, gshare->reg) && loadTable(file, gshare->table);
+}
+
+int gshareSlot(void *state) {
+    return ((GShare *) state)->index;
+}
+
+GShare *createGShare(int offset, int regSize, int width) {
+    GShare *gshare = (GShare *) malloc(sizeof(GShare));
+    gshare->reg = createRegister(regSize);
+    gshare->table = createTableWidth(offset, width);
+    gshare->index = 0;
+    return gshare;
+}
+
+// Tournament: a PC-indexed chooser picks between gshare (counter >= 2) and bimodal
+typedef struct Tournament {
+    GShare *global;
+    Bimodal *local;
+    PredTable *chooser;
+    int index, globalPrediction, localPrediction;
+} Tournament;
+
+int predictTournament(unsigned long long int address, void *state) {
+    Tournament *tournament = (Tournament *) state;
+    tournament->globalPrediction = predictGShare(address, tournament->global);
+    tournament->localPrediction = predictBimodal(address, tournament->local);
+    tournament->index = (int) ((address >> 2) & tournament->chooser->mask);
+    if(getEntryState(tournament->index, tournament->chooser) >= tournament->chooser->threshold) return tournament->globalPrediction;
+    return tournament->localPrediction;
+}
+
+// Train both components; the chooser only moves when exactly one of them was right
+void updateTournament(unsigned long long int address, int taken, int predicted, void *state) {
+    (void) predicted;
+    Tournament *tournament = (Tournament *) state;
+    int globalCorrect = tournament->globalPrediction == taken, localCorrect = tournament->localPrediction == taken;
+    if(globalCorrect != localCorrect) updateEntryState(tournament->index, globalCorrect ? 't' : 'n', tournament->chooser);
+    updateGShare(address, taken, tournament->globalPrediction, tournament->global);
+    updateBimodal(address, taken, tournament->localPrediction, tournament->local);
+}
+
+void resetTournament(void *state) {
+    Tournament *tournament = (Tournament *) state;
+    resetGShare(tournament->global);
+    resetBimodal(tournament->local);
+    resetTable(tournament->chooser);
+}
+
+unsigned long long int tournamentStorageBits(void *state) {
+    Tournament *tournament = (Tournament *) state;
+    return gshareStorageBits(tournament->global) + bimodalStorageBits(tournament->local) + tableStorageBits(tournament->chooser);
+}
+
+void destroyTournament(void *state) {
+    Tournament *tournament = (Tournament *) state;
+    destroyGShare(tournament->global);
+    destroyBimodal(tournament->local);
+    deleteTable(tournament->chooser);
+    free(tournament);
+}
+
+int saveTournament(FILE *file, void *state) {
+    Tournament *tournament = (Tournament *) state;
+    return saveGShare(file, tournament->global) && saveBimodal(file, tournament->local) && saveTable(file, tournament->chooser);
+}
+
+int loadTournament(FILE *file, void *state) {
+    Tournament *tournament = (Tournament *) state;
+    return loadGShare(file, tournament->global) && loadBimodal(file, tournament->local) && loadTable(file, tournament->chooser);
+}
+
+// The gshare component's entry: the one PC aliasing corrupts most
+int tournamentSlot(void *state) {
+    return ((Tournament *) state)->global->index;
+}
+
+Tournament *createTournament(int offset, int regSize) {
+    Tournament *tournament = (Tournament *) malloc(sizeof(Tournament));
+    tournament->global = createGShare(offset, regSize, 2);
+    tournament->local = createBimodal(offset, 2);
+    tournament->chooser = createTable(offset);
+    tournament->index = tournament->globalPrediction = tournament->localPrediction = 0;
+    return tournament;
+}
+
+// Hashed perceptron: one table of 8 bit weights per history segment, indexed by a hash of the
+// PC and that segment's folded history. Predict taken when the weight sum is >= 0, and train
+// on mispredictions or low-confidence sums. The training threshold adapts as in O-GEHL
+typedef struct Perceptron {
+    int tables, logEntries, theta, thetaCounter;
+    int historyLength[PERCEPTRON_MAX_TABLES], pcShift[PERCEPTRON_MAX_TABLES];
+    signed char *weights[PERCEPTRON_MAX_TABLES];
+    FoldedHistory folded[PERCEPTRON_MAX_TABLES];
+    History *history;
+    int index[PERCEPTRON_MAX_TABLES], sum;
+} Perceptron;
+
+int predictPerceptron(unsigned long long int address, void *state) {
+    Perceptron *perceptron = (Perceptron *) state;
+    unsigned int pc = (unsigned int) (address >> 2), mask = (1u << perceptron->logEntries) - 1;
+    int sum = 0;
+    for(int i = 0; i < perceptron->tables; i++) {
+        unsigned int hash = pc ^ (pc >> perceptron->pcShift[i]) ^ (perceptron->folded[i].value * 0x9E3779B1u >> 7) ^ (unsigned int) i;
+        perceptron->index[i] = (int) (hash & mask);
+        sum += perceptron->weights[i][perceptron->index[i]];
+    }
+    perceptron->sum = sum;
+    return sum >= 0;
+}
+
+void updatePerceptron(unsigned long long int address, int taken, int predicted, void *state) {
+    Perceptron *perceptron = (Perceptron *) state;
+    int magnitude = (perceptron->sum < 0) ? -perceptron->sum : perceptron->sum;
+    if(predicted != taken || magnitude <= perceptron->theta) {
+        for(int i = 0; i < perceptron->tables; i++) {
+            signed char *weight = &perceptron->weights[i][perceptron->index[i]];
+            if(taken && *weight < 127) (*weight)++;
+            else if(!taken && *weight > -128) (*weight)--;
+        }
+
+        // Adapt theta toward equal numbers of mispredictions and low-confidence updates
+        if(predicted != taken && ++perceptron->thetaCounter >= 64) {
+            perceptron->theta++;
+            perceptron->thetaCounter = 0;
+        }
+        else if(predicted == taken && --perceptron->thetaCounter <= -64) {
+            if(perceptron->theta > 1) perceptron->theta--;
+            perceptron->thetaCounter = 0;
+        }
+    }
+
+    pushHistory(taken, address, perceptron->history);
+    for(int i = 1; i < perceptron->tables; i++) updateFolded(perceptron->history, &perceptron->folded[i]);
+}
+
+void resetPerceptron(void *state) {
+    Perceptron *perceptron = (Perceptron *) state;
+    for(int i = 0; i < perceptron->tables; i++) {
+        memset(perceptron->weights[i], 0, (size_t) 1 << perceptron->logEntries);
+        perceptron->folded[i].value = 0;
+    }
+    memset(perceptron->history->bits, 0, HISTORY_BUFFER);
+    perceptron->history->pointer = 0;
+    perceptron->history->path = 0;
+    perceptron->theta = (int) (1.93 * perceptron->tables + 14);
+    perceptron->thetaCounter = 0;
+}
+
+unsigned long long int perceptronStorageBits(void *state) {
+    Perceptron *perceptron = (Perceptron *) state;
+    return ((unsigned long long int) perceptron->tables << perceptron->logEntries) * 8 + perceptron->historyLength[perceptron->tables - 1];
+}
+
+void destroyPerceptron(void *state) {
+    Perceptron *perceptron = (Perceptron *) state;
+    for(int i = 0; i < perceptron->tables; i++) free(perceptron->weights[i]);
+    deleteHistory(perceptron->history);
+    free(perceptron);
+}
+
+// Weights, folded histories, the global history and the adaptive threshold
+int savePerceptron(FILE *file, void *state) {
+    Perceptron *perceptron = (Perceptron *) state;
+    size_t entries = (size_t) 1 << perceptron->logEntries;
+    int ok = fwrite(&perceptron->theta, sizeof(int), 1, file) == 1 && fwrite(&perceptron->thetaCounter, sizeof(int), 1, file) == 1;
+    for(int i = 0; i < perceptron->tables && ok; i++) {
+        ok = fwrite(perceptron->weights[i], 1, entries, file) == entries && fwrite(&perceptron->folded[i].value, sizeof(unsigned int), 1, file) == 1;
+    }
+    return ok && saveHistory(file, perceptron->history);
+}
+
+int loadPerceptron(FILE *file, void *state) {
+    Perceptron *perceptron = (Perceptron *) state;
+    size_t entries = (size_t) 1 << perceptron->logEntries;
+    int ok = fread(&perceptron->theta, sizeof(int), 1, file) == 1 && fread(&perceptron->thetaCounter, sizeof(int), 1, file) == 1;
+    for(int i = 0; i < perceptron->tables && ok; i++) {
+        ok = fread(perceptron->weights[i], 1, entries, file) == entries && fread(&perceptron->folded[i].value, sizeof(unsigned int), 1, file) == 1;
+    }
+    return ok && loadHistory(file, perceptron->history);
+}
+
+// Largest power-of-2 tables that, with the longest history, fit the budget. Table 0 is PC only,
+// the rest use histories growing geometrically from 3 to 16 bits per table
+Perceptron *createPerceptron(int budgetKB, int tables) {
+    unsigned long long int budgetBits = (unsigned long long int) budgetKB * 8192;
+    int maxHistory = 16 * tables, longest = (tables > 1) ? maxHistory : 0;
+    int logEntries = 4;
+    while(logEntries < 24 && ((unsigned long long int) tables << (logEntries + 1)) * 8 + longest <= budgetBits) logEntries++;
+
+    Perceptron *perceptron = (Perceptron *) malloc(sizeof(Perceptron));
+    perceptron->tables = tables;
+    perceptron->logEntries = logEntries;
+    perceptron->history = createHistory();
+    for(int i = 0; i < tables; i++) {
+        perceptron->historyLength[i] = (i == 0) ? 0 : (tables == 2) ? maxHistory : (int) (3 * pow((double) maxHistory / 3, (double) (i - 1) / (tables - 2)) + 0.5);
+        perceptron->weights[i] = (signed char *) malloc((size_t) 1 << logEntries);
+        perceptron->pcShift[i] = logEntries - i % logEntries;
+        if(i > 0) initFolded(perceptron->historyLength[i], logEntries, &perceptron->folded[i]);
+        else perceptron->folded[i].value = 0;
+    }
+    resetPerceptron(perceptron);
+    return perceptron;
+}
+
+// TAGE: a bimodal base predictor plus tagged tables indexed with geometrically longer global
+// histories. The longest matching table provides the prediction; new entries are allocated in
+// longer tables on mispredictions, steered by per-entry useful counters
+typedef struct TageEntry {
+    unsigned short tag;
+    signed char counter;            // 3 bit signed: -4 .. 3, taken when >= 0
+    unsigned char useful;           // 2 bits
+} TageEntry;
+
+typedef struct Tage {
+    int tables, logEntries;         // Tagged tables are numbered 1 .. tables
+    int historyLength[TAGE_MAX_TABLES + 1], tagBits[TAGE_MAX_TABLES + 1];
+    int pcShift[TAGE_MAX_TABLES + 1], pathMask[TAGE_MAX_TABLES + 1];    // Per-table index hashing
+    TageEntry *entries[TAGE_MAX_TABLES + 1];
+    PredTable *base;
+    FoldedHistory indexFolded[TAGE_MAX_TABLES + 1], tagFolded[TAGE_MAX_TABLES + 1], tagFoldedShort[TAGE_MAX_TABLES + 1];
+    History *history;
+    int useAltOnNew;                // 4 bit signed: trust the alternate over a newly allocated entry when >= 0
+    unsigned long long int branches, seed;
+
+    // Lookup results carried from predict to update
+    int index[TAGE_MAX_TABLES + 1], tag[TAGE_MAX_TABLES + 1];
+    int baseIndex, provider, alternate, providerPrediction, alternatePrediction, prediction;
+} Tage;
+
+int predictTage(unsigned long long int address, void *state) {
+    Tage *tage = (Tage *) state;
+    unsigned int pc = (unsigned int) (address >> 2), mask = (1u << tage->logEntries) - 1;
+    for(int i = 1; i <= tage->tables; i++) {
+        unsigned int hash = pc ^ (pc >> tage->pcShift[i]) ^ tage->indexFolded[i].value ^ (tage->history->path & tage->pathMask[i]) * 0x9E3779B1u;
+        tage->index[i] = (int) (hash & mask);
+        tage->tag[i] = (int) ((pc ^ tage->tagFolded[i].value ^ (tage->tagFoldedShort[i].value << 1)) & ((1u << tage->tagBits[i]) - 1));
+    }
+
+    // Longest and second longest matching tables
+    tage->provider = tage->alternate = 0;
+    for(int i = tage->tables; i >= 1; i--) {
+        if(tage->entries[i][tage->index[i]].tag != tage->tag[i]) continue;
+        if(tage->provider == 0) tage->provider = i;
+        else {
+            tage->alternate = i;
+            break;
+        }
+    }
+
+    tage->baseIndex = (int) (pc & tage->base->mask);
+    int basePrediction = getEntryState(tage->baseIndex, tage->base) >= tage->base->threshold;
+    tage->alternatePrediction = (tage->alternate > 0) ? tage->entries[tage->alternate][tage->index[tage->alternate]].counter >= 0 : basePrediction;
+    if(tage->provider == 0) {
+        tage->providerPrediction = tage->prediction = basePrediction;
+        return tage->prediction;
+    }
+
+    // Weak, never-useful provider entries are usually fresh allocations
+    TageEntry *entry = &tage->entries[tage->provider][tage->index[tage->provider]];
+    tage->providerPrediction = entry->counter >= 0;
+    int fresh = (entry->counter == 0 || entry->counter == -1) && entry->useful == 0;
+    tage->prediction = (fresh && tage->useAltOnNew >= 0) ? tage->alternatePrediction : tage->providerPrediction;
+    return tage->prediction;
+}
+
+// Saturating 3 bit signed counter update
+void updateTageCounter(int taken, TageEntry *entry) {
+    if(taken && entry->counter < 3) entry->counter++;
+    else if(!taken && entry->counter > -4) entry->counter--;
+}
+
+void updateTage(unsigned long long int address, int taken, int predicted, void *state) {
+    (void) predicted;
+    Tage *tage = (Tage *) state;
+    char outcome = taken ? 't' : 'n';
+    TageEntry *entry = (tage->provider > 0) ? &tage->entries[tage->provider][tage->index[tage->provider]] : NULL;
+    int fresh = entry && (entry->counter == 0 || entry->counter == -1) && entry->useful == 0;
+
+    // Learn whether to trust fresh entries
+    if(fresh && tage->providerPrediction != tage->alternatePrediction) {
+        if(tage->alternatePrediction == taken && tage->useAltOnNew < 7) tage->useAltOnNew++;
+        else if(tage->alternatePrediction != taken && tage->useAltOnNew > -8) tage->useAltOnNew--;
+    }
+
+    // Allocate one entry in a longer table on a misprediction, skipping a table half the time
+    if(tage->prediction != taken && tage->provider < tage->tables) {
+        tage->seed ^= tage->seed << 13;
+        tage->seed ^= tage->seed >> 7;
+        tage->seed ^= tage->seed << 17;
+        int start = tage->provider + 1 + ((tage->provider + 1 < tage->tables) ? (int) (tage->seed & 1) : 0), allocated = 0;
+        for(int i = start; i <= tage->tables && !allocated; i++) {
+            TageEntry *victim = &tage->entries[i][tage->index[i]];
+            if(victim->useful != 0) continue;
+            victim->tag = (unsigned short) tage->tag[i];
+            victim->counter = taken ? 0 : -1;
+            allocated = 1;
+        }
+        for(int i = start; i <= tage->tables && !allocated; i++) {
+            TageEntry *victim = &tage->entries[i][tage->index[i]];
+            if(victim->useful > 0) victim->useful--;
+        }
+    }
+
+    // Train the provider (and the alternate while the provider is fresh), or the base
+    if(entry) {
+        updateTageCounter(taken, entry);
+        if(fresh) {
+            if(tage->alternate > 0) updateTageCounter(taken, &tage->entries[tage->alternate][tage->index[tage->alternate]]);
+            else updateEntryState(tage->baseIndex, outcome, tage->base);
+        }
+        if(tage->providerPrediction != tage->alternatePrediction) {
+            if(tage->providerPrediction == taken && entry->useful < 3) entry->useful++;
+            else if(tage->providerPrediction != taken && entry->useful > 0) entry->useful--;
+        }
+    }
+    else updateEntryState(tage->baseIndex, outcome, tage->base);
+
+    // Periodically age the useful counters so stale entries can be replaced
+    if(++tage->branches % TAGE_USEFUL_PERIOD == 0) {
+        for(int i = 1; i <= tage->tables; i++) {
+            for(int j = 0; j < (1 << tage->logEntries); j++) tage->entries[i][j].useful >>= 1;
+        }
+    }
+
+    pushHistory(taken, address, tage->history);
+    for(int i = 1; i <= tage->tables; i++) {
+        updateFolded(tage->history, &tage->indexFolded[i]);
+        updateFolded(tage->history, &tage->tagFolded[i]);
+        updateFolded(tage->history, &tage->tagFoldedShort[i]);
+    }
+}
+
+void resetTage(void *state) {
+    Tage *tage = (Tage *) state;
+    for(int i = 1; i <= tage->tables; i++) {
+        for(int j = 0; j < (1 << tage->logEntries); j++) {
+            tage->entries[i][j].tag = 0;
+            tage->entries[i][j].counter = 0;
+            tage->entries[i][j].useful = 0;
+        }
+        tage->indexFolded[i].value = tage->tagFolded[i].value = tage->tagFoldedShort[i].value = 0;
+    }
+    resetTable(tage->base);
+    memset(tage->history->bits, 0, HISTORY_BUFFER);
+    tage->history->pointer = 0;
+    tage->history->path = 0;
+    tage->useAltOnNew = 0;
+    tage->branches = 0;
+    tage->seed = 0x2545F4914F6CDD1DULL;
+}
+
+// Counter (3) + useful (2) + tag bits per tagged entry, the base table, the history and useAltOnNew
+unsigned long long int tageStorageBits(void *state) {
+    Tage *tage = (Tage *) state;
+    unsigned long long int bits = tableStorageBits(tage->base) + tage->historyLength[tage->tables] + 4;
+    for(int i = 1; i <= tage->tables; i++) bits += (unsigned long long int) (5 + tage->tagBits[i]) << tage->logEntries;
+    return bits;
+}
+
+void destroyTage(void *state) {
+    Tage *tage = (Tage *) state;
+    for(int i = 1; i <= tage->tables; i++) free(tage->entries[i]);
+    deleteTable(tage->base);
+    deleteHistory(tage->history);
+    free(tage);
+}
+
+// Tagged entries, folded histories, the base table, the global history and the allocation state
+int saveTage(FILE *file, void *state) {
+    Tage *tage = (Tage *) state;
+    size_t entries = (size_t) 1 << tage->logEntries;
+    int ok = 1;
+    for(int i = 1; i <= tage->tables && ok; i++) {
+        unsigned int folded[3] = {tage->indexFolded[i].value, tage->tagFolded[i].value, tage->tagFoldedShort[i].value};
+        ok = fwrite(tage->entries[i], sizeof(TageEntry), entries, file) == entries && fwrite(folded, sizeof(unsigned int), 3, file) == 3;
+    }
+    ok = ok && fwrite(&tage->useAltOnNew, sizeof(int), 1, file) == 1 && fwrite(&tage->branches, sizeof(unsigned long long int), 1, file) == 1;
+    ok = ok && fwrite(&tage->seed, sizeof(unsigned long long int), 1, file) == 1;
+    return ok && saveTable(file, tage->base) && saveHistory(file, tage->history);
+}
+
+int loadTage(FILE *file, void *state) {
+    Tage *tage = (Tage *) state;
+    size_t entries = (size_t) 1 << tage->logEntries;
+    int ok = 1;
+    for(int i = 1; i <= tage->tables && ok; i++) {
+        unsigned int folded[3];
+        ok = fread(tage->entries[i], sizeof(TageEntry), entries, file) == entries && fread(folded, sizeof(unsigned int), 3, file) == 3;
+        tage->indexFolded[i].value = folded[0];
+        tage->tagFolded[i].value = folded[1];
+        tage->tagFoldedShort[i].value = folded[2];
+    }
+    ok = ok && fread(&tage->useAltOnNew, sizeof(int), 1, file) == 1 && fread(&tage->branches, sizeof(unsigned long long int), 1, file) == 1;
+    ok = ok && fread(&tage->seed, sizeof(unsigned long long int), 1, file) == 1;
+    return ok && loadTable(file, tage->base) && loadHistory(file, tage->history);
+}
+
+// Histories grow geometrically from 4 bits to 64 bits per table (capped at 1000), tags from 8 to
+// 13 bits, and the base table has twice the entries of a tagged table. Table sizes are the
+// largest power of 2 that keeps everything within the budget
+Tage *createTage(int budgetKB, int tables) {
+    Tage *tage = (Tage *) malloc(sizeof(Tage));
+    tage->tables = tables;
+    int maxHistory = (64 * tables < 1000) ? 64 * tables : 1000;
+    unsigned long long int entryBits = 4;       // Base: 2 bit counters, twice as many entries
+    for(int i = 1; i <= tables; i++) {
+        tage->historyLength[i] = (tables == 1) ? maxHistory : (int) (4 * pow((double) maxHistory / 4, (double) (i - 1) / (tables - 1)) + 0.5);
+        tage->tagBits[i] = 8 + (5 * (i - 1)) / ((tables > 1) ? tables - 1 : 1);
+        entryBits += 5 + tage->tagBits[i];
+    }
+    unsigned long long int budgetBits = (unsigned long long int) budgetKB * 8192;
+    int logEntries = 4;
+    while(logEntries < 22 && (entryBits << (logEntries + 1)) + maxHistory + 4 <= budgetBits) logEntries++;
+
+    tage->logEntries = logEntries;
+    tage->base = createTable(logEntries + 1);
+    tage->history = createHistory();
+    for(int i = 1; i <= tables; i++) {
+        tage->entries[i] = (TageEntry *) malloc(sizeof(TageEntry) << logEntries);
+        tage->pcShift[i] = logEntries - i % logEntries;
+        tage->pathMask[i] = (tage->historyLength[i] < 16) ? (1 << tage->historyLength[i]) - 1 : 0xFFFF;
+        initFolded(tage->historyLength[i], logEntries, &tage->indexFolded[i]);
+        initFolded(tage->historyLength[i], tage->tagBits[i], &tage->tagFolded[i]);
+        initFolded(tage->historyLength[i], tage->tagBits[i] - 1, &tage->tagFoldedShort[i]);
+    }
+    resetTage(tage);
+    return tage;
+}
+
+// Splits "name:a:b:c" into the name and up to MAX_SPEC_FIELDS integers. Returns the field count, -1 if malformed
+int parseSpec(const char *spec, char *name, int nameLength, int *fields) {
+    const char *colon = strchr(spec, ':');
+    int length = colon ? (int) (colon - spec) : (int) strlen(spec);
+    if(length <= 0 || length >= nameLength) return -1;
+    memcpy(name, spec, length);
+    name[length] = '\0';
+
+    int count = 0;
+    while(colon) {
+        char *end;
+        if(count == MAX_SPEC_FIELDS) return -1;
+        fields[count++] = (int) strtol(colon + 1, &end, 0);
+        if(end == colon + 1 || (*end != ':' && *end != '\0')) return -1;
+        colon = (*end == ':') ? end : NULL;
+    }
+    return count;
+}
+
+// Builds a predictor from its spec string (see the top of this file). Returns NULL if the spec is bad
+Predictor *createPredictor(const char *spec) {
+    char family[32];
+    int fields[MAX_SPEC_FIELDS];
+    int count = parseSpec(spec, family, sizeof(family), fields);
+    if(count < 0) return NULL;
+
+    Predictor *predictor = (Predictor *) malloc(sizeof(Predictor));
+    snprintf(predictor->name, sizeof(predictor->name), "%s", spec);
+    predictor->slot = NULL;
+    predictor->slots = 0;
+    if(strcmp(family, "bimodal") == 0 && count >= 1 && count <= 2 && fields[0] >= 1 && fields[0] <= 30 && (count < 2 || (fields[1] >= 1 && fields[1] <= 4))) {
+        predictor->state = createBimodal(fields[0], (count == 2) ? fields[1] : 2);
+        predictor->predict = predictBimodal;
+        predictor->update = updateBimodal;
+        predictor->reset = resetBimodal;
+        predictor->storageBits = bimodalStorageBits;
+        predictor->destroy = destroyBimodal;
+        predictor->save = saveBimodal;
+        predictor->load = loadBimodal;
+        predictor->slot = bimodalSlot;
+        predictor->slots = 1LL << fields[0];
+    }
+    else if(strcmp(family, "gshare") == 0 && count >= 2 && fields[0] >= 1 && fields[0] <= 30 && fields[1] >= 0 && fields[1] <= fields[0] && (count < 3 || (fields[2] >= 1 && fields[2] <= 4))) {
+        predictor->state = createGShare(fields[0], fields[1], (count == 3) ? fields[2] : 2);
+        predictor->predict = predictGShare;
+        predictor->update = updateGShare;
+        predictor->reset = resetGShare;
+        predictor->storageBits = gshareStorageBits;
+        predictor->destroy = destroyGShare;
+        predictor->save = saveGShare;
+        predictor->load = loadGShare;
+        predictor->slot = gshareSlot;
+        predictor->slots = 1LL << fields[0];
+    }
+    else if(strcmp(family, "tournament") == 0 && count == 2 && fields[0] >= 1 && fields[0] <= 30 && fields[1] >= 0 && fields[1] <= fields[0]) {
+        predictor->state = createTournament(fields[0], fields[1]);
+        predictor->predict = predictTournament;
+        predictor->update = updateTournament;
+        predictor->reset = resetTournament;
+        predictor->storageBits = tournamentStorageBits;
+        predictor->destroy = destroyTournament;
+        predictor->save = saveTournament;
+        predictor->load = loadTournament;
+        predictor->slot = tournamentSlot;
+        predictor->slots = 1LL << fields[0];
+    }
+    else if(strcmp(family, "perceptron") == 0 && count >= 1 && count <= 2 && fields[0] >= 1 && (count < 2 || (fields[1] >= 2 && fields[1] <= PERCEPTRON_MAX_TABLES))) {
+        predictor->state = createPerceptron(fields[0], (count == 2) ? fields[1] : ((fields[0] < 8) ? 4 : 8));
+        predictor->predict = predictPerceptron;
+        predictor->update = updatePerceptron;
+        predictor->reset = resetPerceptron;
+        predictor->storageBits = perceptronStorageBits;
+        predictor->destroy = destroyPerceptron;
+        predictor->save = savePerceptron;
+        predictor->load = loadPerceptron;
+    }
+    else if(strcmp(family, "tage") == 0 && count >= 1 && count <= 2 && fields[0] >= 1 && (count < 2 || (fields[1] >= 1 && fields[1] <= TAGE_MAX_TABLES))) {
+        predictor->state = createTage(fields[0], (count == 2) ? fields[1] : ((fields[0] < 16) ? 7 : 10));
+        predictor->predict = predictTage;
+        predictor->update = updateTage;
+        predictor->reset = resetTage;
+        predictor->storageBits = tageStorageBits;
+        predictor->destroy = destroyTage;
+        predictor->save = saveTage;
+        predictor->load = loadTage;
+    }
+    else {
+        free(predictor);
+        return NULL;
+    }
+    return predictor;
+}
+
+// Predicts and trains on each branch of a batch in order. Returns the number of mispredictions
+long long int runPredictor(Predictor *predictor, Branch *batch, int count) {
+    long long int missed = 0;
+    for(int i = 0; i < count; i++) {
+        int taken = batch[i].outcome == 't';
+        int predicted = predictor->predict(batch[i].address, predictor->state);
+        if(predicted != taken) missed++;
+        predictor->update(batch[i].address, taken, predicted, predictor->state);
+    }
+    return missed;
+}
+
+Predictor *deletePredictor(Predictor *predictor) {
+    predictor->destroy(predictor->state);
+    free(predictor);
+    return NULL;
+}
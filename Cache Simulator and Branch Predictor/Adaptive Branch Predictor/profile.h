@@ -0,0 +1,167 @@
+// Esperandieu Elbon II - UCFID: 5401262
+// EEL4768 Computer Architecture - Suboh Suboh - Fall 2023
+// Per-Branch Misprediction Profiling
+//
+// An open-addressing hash table keyed by branch PC (linear probing, kept under half full) counts
+// executions, taken outcomes and mispredictions of every static branch. For predictors with one
+// pattern table (bimodal, gshare, tournament) each table entry also remembers the last branch
+// that read it; an execution whose entry was last read by another PC is aliased, so aliased
+// mispredictions separate interference from branches that are simply hard to predict. Entries
+// read by more than one PC over the run are counted as shared.
+// The report is the top K branches by mispredictions, as CSV.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define PROFILE_INITIAL_CAPACITY 4096   // Power of 2
+#define PROFILE_MAX_SLOTS (1LL << 26)   // Larger pattern tables are profiled without aliasing
+#define PROFILE_DEFAULT_TOP 20
+#define SLOT_SHARED 0x80000000u         // Owner flag: entry read by more than one PC
+
+// Counters of one static branch
+typedef struct BranchProfile {
+    unsigned long long int address;
+    long long int executions, taken, mispredictions;
+    long long int aliased, aliasedMispredictions;   // Executions whose entry another PC read last
+} BranchProfile;
+
+typedef struct Profile {
+    BranchProfile *entries;     // Hash table; executions == 0 marks an empty entry
+    int capacity, count;
+    unsigned int *owners;       // Per pattern table entry: 1 + profile index of the last reader, 0 = unused
+    long long int slots;        // Pattern table entries tracked, 0 = aliasing off
+} Profile;
+
+// Profile Functions
+Profile *createProfile(Predictor *predictor);
+unsigned int profileHash(unsigned long long int address, int capacity);
+int findProfile(unsigned long long int address, Profile *profile);
+void growProfile(Profile *profile);
+long long int runProfiledPredictor(Predictor *predictor, Profile *profile, Branch *batch, int count);
+int compareProfiles(const void *a, const void *b);
+void writeProfile(FILE *file, char *name, Profile *profile, int top);
+Profile *deleteProfile(Profile *profile);
+
+// Empty profile for a predictor, tracking aliasing when it has a single pattern table
+Profile *createProfile(Predictor *predictor) {
+    Profile *profile = (Profile *) calloc(1, sizeof(Profile));
+    profile->capacity = PROFILE_INITIAL_CAPACITY;
+    profile->entries = (BranchProfile *) calloc(profile->capacity, sizeof(BranchProfile));
+    if(predictor->slot != NULL && predictor->slots <= PROFILE_MAX_SLOTS) {
+        profile->slots = predictor->slots;
+        profile->owners = (unsigned int *) calloc((size_t) profile->slots, sizeof(unsigned int));
+    }
+    return profile;
+}
+
+// Fibonacci hash of the PC (low two bits dropped) into a power of two table
+unsigned int profileHash(unsigned long long int address, int capacity) {
+    return (unsigned int) (((address >> 2) * 0x9E3779B97F4A7C15ULL) >> 32) & (unsigned int) (capacity - 1);
+}
+
+// Index of a branch's entry, claimed if it's new
+int findProfile(unsigned long long int address, Profile *profile) {
+    unsigned int mask = (unsigned int) profile->capacity - 1, i = profileHash(address, profile->capacity);
+    while(profile->entries[i].executions != 0 && profile->entries[i].address != address) i = (i + 1) & mask;
+    if(profile->entries[i].executions == 0) {
+        profile->entries[i].address = address;
+        profile->count++;
+    }
+    return (int) i;
+}
+
+// Doubles the table, rehashing every branch and renumbering the entry owners
+void growProfile(Profile *profile) {
+    BranchProfile *old = profile->entries;
+    int oldCapacity = profile->capacity;
+    int *moved = (int *) malloc(oldCapacity * sizeof(int));
+    profile->capacity *= 2;
+    profile->entries = (BranchProfile *) calloc(profile->capacity, sizeof(BranchProfile));
+    profile->count = 0;
+    for(int i = 0; i < oldCapacity; i++) {
+        moved[i] = -1;
+        if(old[i].executions == 0) continue;
+        moved[i] = findProfile(old[i].address, profile);
+        profile->entries[moved[i]] = old[i];
+    }
+    for(long long int s = 0; s < profile->slots; s++) {
+        unsigned int owner = profile->owners[s] & ~SLOT_SHARED;
+        if(owner != 0) profile->owners[s] = (profile->owners[s] & SLOT_SHARED) | (unsigned int) (moved[owner - 1] + 1);
+    }
+    free(moved);
+    free(old);
+}
+
+// runPredictor with every branch counted in the profile. Returns the number of mispredictions
+long long int runProfiledPredictor(Predictor *predictor, Profile *profile, Branch *batch, int count) {
+    long long int missed = 0;
+    for(int i = 0; i < count; i++) {
+        if(2 * (profile->count + 1) > profile->capacity) growProfile(profile);
+        int taken = batch[i].outcome == 't';
+        int predicted = predictor->predict(batch[i].address, predictor->state);
+        int wrong = predicted != taken, index = findProfile(batch[i].address, profile);
+        BranchProfile *branch = &profile->entries[index];
+        branch->executions++;
+        branch->taken += taken;
+        branch->mispredictions += wrong;
+        missed += wrong;
+
+        // The pattern table entry just read, and whether another branch read it last
+        if(profile->slots > 0) {
+            unsigned int *owner = &profile->owners[predictor->slot(predictor->state)];
+            unsigned int self = (unsigned int) index + 1, last = *owner & ~SLOT_SHARED;
+            if(last != 0 && last != self) {
+                branch->aliased++;
+                branch->aliasedMispredictions += wrong;
+                *owner = self | SLOT_SHARED;
+            }
+            else *owner = self | (*owner & SLOT_SHARED);
+        }
+        predictor->update(batch[i].address, taken, predicted, predictor->state);
+    }
+    return missed;
+}
+
+// Most mispredictions first, ties by PC
+int compareProfiles(const void *a, const void *b) {
+    const BranchProfile *x = (const BranchProfile *) a, *y = (const BranchProfile *) b;
+    if(x->mispredictions != y->mispredictions) return (x->mispredictions < y->mispredictions) ? 1 : -1;
+    return (x->address > y->address) - (x->address < y->address);
+}
+
+// Writes the top branches as CSV rows (header first when the file is empty). Aliasing columns
+// are empty for predictors without a single pattern table
+void writeProfile(FILE *file, char *name, Profile *profile, int top) {
+    BranchProfile *branches = (BranchProfile *) malloc((profile->count > 0 ? profile->count : 1) * sizeof(BranchProfile));
+    long long int missed = 0, shared = 0, used = 0;
+    int n = 0;
+    for(int i = 0; i < profile->capacity; i++) {
+        if(profile->entries[i].executions == 0) continue;
+        missed += profile->entries[i].mispredictions;
+        branches[n++] = profile->entries[i];
+    }
+    for(long long int s = 0; s < profile->slots; s++) {
+        used += profile->owners[s] != 0;
+        shared += (profile->owners[s] & SLOT_SHARED) != 0;
+    }
+    qsort(branches, n, sizeof(BranchProfile), compareProfiles);
+
+    if(ftell(file) == 0) fprintf(file, "predictor,rank,pc,executions,taken,takenRate,mispredictions,missRatio,shareOfMisses,aliased,aliasedMispredictions,staticBranches,entriesUsed,entriesShared\n");
+    for(int i = 0; i < n && i < top; i++) {
+        BranchProfile *branch = &branches[i];
+        fprintf(file, "%s,%d,%llx,%lld,%lld,%.5f,%lld,%.5f,%.5f,", name, i + 1, branch->address, branch->executions, branch->taken, (double) branch->taken / (double) branch->executions,
+            branch->mispredictions, (double) branch->mispredictions / (double) branch->executions, (missed > 0) ? (double) branch->mispredictions / (double) missed : 0.0);
+        if(profile->slots > 0) fprintf(file, "%lld,%lld,%d,%lld,%lld\n", branch->aliased, branch->aliasedMispredictions, n, used, shared);
+        else fprintf(file, ",,%d,,\n", n);
+    }
+    free(branches);
+}
+
+// De-allocate the table and entry owners
+Profile *deleteProfile(Profile *profile) {
+    free(profile->entries);
+    free(profile->owners);
+    free(profile);
+    return NULL;
+}
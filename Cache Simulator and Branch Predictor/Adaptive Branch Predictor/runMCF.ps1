@@ -2,7 +2,7 @@
 # Set-ExecutionPolicy RemoteSigned
 
 # Compile (jic)
-gcc .\GSHARESIM.c -o .\GSHARESIM
+gcc .\GSHARESIM.c -o .\GSHARESIM -pthread
 
 ############ Begin Writing to file ############
 echo "Report Data (MCF)`n" > outMCF.txt
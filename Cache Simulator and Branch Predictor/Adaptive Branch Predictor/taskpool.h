@@ -0,0 +1,95 @@
+// Esperandieu Elbon II - UCFID: 5401262
+// EEL4768 Computer Architecture - Suboh Suboh - Fall 2023
+// Work-Stealing Thread Pool for Independent Simulation Tasks
+//
+// Tasks 0 .. count-1 are dealt out as contiguous ranges, one per worker. A worker takes tasks
+// from the front of its own range and, once that is empty, steals from the other workers'
+// ranges, so uneven task costs don't leave threads idle. Build with -pthread.
+
+#include <stdlib.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <unistd.h>
+
+#define MAX_POOL_THREADS 256
+
+// One worker's range of task indexes
+typedef struct TaskRange {
+    atomic_int next;
+    int end;
+} TaskRange;
+
+typedef struct TaskPool {
+    TaskRange *ranges;
+    int threads;
+    void (*run)(int task, void *context);
+    void *context;
+} TaskPool;
+
+// Worker thread argument
+typedef struct TaskWorker {
+    TaskPool *pool;
+    int id;
+} TaskWorker;
+
+int takeTask(TaskRange *range);
+void *runTaskWorker(void *arg);
+int defaultThreadCount();
+void runTasks(int count, int threads, void (*run)(int task, void *context), void *context);
+
+// Claims the next task in a range. Returns -1 once the range is empty
+int takeTask(TaskRange *range) {
+    if(atomic_load_explicit(&range->next, memory_order_relaxed) >= range->end) return -1;
+    int task = atomic_fetch_add_explicit(&range->next, 1, memory_order_relaxed);
+    return (task < range->end) ? task : -1;
+}
+
+// Drain the worker's own range, then steal from the others in turn
+void *runTaskWorker(void *arg) {
+    TaskWorker *worker = (TaskWorker *) arg;
+    TaskPool *pool = worker->pool;
+    for(int offset = 0; offset < pool->threads; offset++) {
+        TaskRange *range = &pool->ranges[(worker->id + offset) % pool->threads];
+        int task;
+        while((task = takeTask(range)) >= 0) pool->run(task, pool->context);
+    }
+    return NULL;
+}
+
+// Online processor count, at least 1
+int defaultThreadCount() {
+    long int cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    if(cpus < 1) return 1;
+    return (cpus > MAX_POOL_THREADS) ? MAX_POOL_THREADS : (int) cpus;
+}
+
+// Runs run(task, context) for every task on the indicated number of threads and waits for all of them
+void runTasks(int count, int threads, void (*run)(int task, void *context), void *context) {
+    if(threads < 1) threads = 1;
+    if(threads > count) threads = (count > 0) ? count : 1;
+
+    TaskPool pool;
+    pool.ranges = (TaskRange *) malloc(threads * sizeof(TaskRange));
+    pool.threads = threads;
+    pool.run = run;
+    pool.context = context;
+    for(int w = 0; w < threads; w++) {
+        atomic_init(&pool.ranges[w].next, (int) ((long long int) count * w / threads));
+        pool.ranges[w].end = (int) ((long long int) count * (w + 1) / threads);
+    }
+
+    // The calling thread works as worker 0
+    pthread_t *handles = (pthread_t *) malloc(threads * sizeof(pthread_t));
+    TaskWorker *workers = (TaskWorker *) malloc(threads * sizeof(TaskWorker));
+    for(int w = 0; w < threads; w++) {
+        workers[w].pool = &pool;
+        workers[w].id = w;
+        if(w > 0) pthread_create(&handles[w], NULL, runTaskWorker, &workers[w]);
+    }
+    runTaskWorker(&workers[0]);
+    for(int w = 1; w < threads; w++) pthread_join(handles[w], NULL);
+
+    free(handles);
+    free(workers);
+    free(pool.ranges);
+}
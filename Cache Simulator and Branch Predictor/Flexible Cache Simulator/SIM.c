@@ -4,492 +4,929 @@
 
 #include <stdio.h>
 #include <stdlib.h>
-
-// Cache Block
-typedef struct Block Block;
-struct Block {
-    int dirty;          // Dirty bit
-    unsigned long long int tag;  // Tag
-    Block *prev, *next; // Block links
-};
-
-// Cache Set
-typedef struct Set Set;
-struct Set {
-    int size, capacity; // Set properties
-    Block *tracker;     // Most recently accessed block
+#include <string.h>
+#include "cachebase.h"
+#include "stackdist.h"
+#include "../Trace Tools/traceio.h"
+#include "parallel.h"
+#include "hierarchy.h"
+#include "multicore.h"
+#include "prefetch.h"
+#include "record.h"
+#include "sample.h"
+#include "checkpoint.h"
+#include "kernels.h"
+#include "reuse.h"
+
+// Cache Configuration (one point of a sweep)
+typedef struct CacheConfig CacheConfig;
+struct CacheConfig {
+    int cacheSize, associativity, replacementPolicy, writePolicy;
+    int blockSize, allocation, indexing;    // Block size 0 means BLOCK_SIZE
 };
 
-// Cache 
-typedef struct Cache Cache;
-struct Cache {
-    int associativty, numberOfSets, replacementPolicy, writePolicy; // Cache properties
-    Set **tagArray;  // Tag array
+// Run Options: leading -flags shared by every mode
+typedef struct Options Options;
+struct Options {
+    int threads;    // Worker threads for set-partitioned simulation, 1 = serial
+    int blockSize, allocation, indexing;    // Defaults for configurations that don't set them
+    int prefetcher, degree;     // Prefetcher attached to every simulated cache
+    char *record;               // Interval and per-set output prefix, NULL = off
+    long long int interval;     // Demand accesses per recorded interval
+    int binary;                 // Record as one binary dump instead of CSV
+    SamplePlan sample;          // Sampled simulation, mode SAMPLE_NONE = every access in detail
+    Checkpointing checkpoint;   // Periodic checkpoints, path NULL = off
+    int regionSize;             // Bytes per -reuse region
 };
-
-// Block Functions
-Block *createBlock(unsigned long long int tag);
-Block *linkBlocks(unsigned long long int tag, Block *block);
-Block *unlinkBlocks(Block *block);
-
-// Set Functions
-Set *createSet(int capacity);
-Set *insertBlock(int operation, int event, int writePolicy, unsigned long long int tag , Set *set);
-Set *removeBlock(int writePolicy, int replacementPolicy, int event, Block *target, Set *set);
-Block *searchSet(unsigned long long int tag, Set *set);
-void deleteSet(Set *set);
-
-// Cache Functions
-Cache *createCache(int associativity, int numberOfSets, int replacementPoliocy, int writePolicy);
-void simulateCacheAccess(char operation, unsigned long long int address, Cache *cache);
-Set *updateCache_LRU(int event, char operation, int writePolicy, unsigned long long int tag, Block* block, Set *set);
-Set *updateCache_FIFO(int event, char operation, int writePolicy, unsigned long long int tag, Block* block, Set *set);
-void clearCache(Cache *cache);
-void displayCache(Cache  *cache);
-
-// Cache Parameters
-int hits, misses, reads, writes;
-#define BLOCK_SIZE 64
-#define FIFO 1
-#define LRU 0
-#define WRITE_BACK 1
-#define WRITE_THROUGH 0
-#define HIT 1
-#define MISS 0
-#define DIRTY 1
+Options options = {.threads = 1, .blockSize = BLOCK_SIZE, .allocation = WRITE_MIXED, .indexing = INDEX_MODULO, .prefetcher = NO_PREFETCH, .record = NULL,
+    .interval = DEFAULT_INTERVAL, .sample = {.mode = SAMPLE_NONE, .functional = 1}, .checkpoint = {.path = NULL, .mode = CHECKPOINT_SINGLE}, .regionSize = DEFAULT_REGION_SIZE};
+int parseOptions(int argc, char *argv[]);
+
+// Sweep Functions
+#define SWEEP_BATCH 4096
+#define SWEEP_STOPPED 2         // runSweep ended at a -checkpoint ...:stop
+int parseConfig(char *spec, CacheConfig *config);
+int configBlockSize(CacheConfig *config);
+int configSets(CacheConfig *config);
+int loadConfigs(char *path, CacheConfig **configs, int *count, int *capacity);
+int addConfig(CacheConfig config, CacheConfig **configs, int *count, int *capacity);
+int runSweep(CacheConfig *configs, int count, char *traceFile, Stats *results, PrefetchStats *prefetchResults, SampleEstimate *estimates);
+void runOfflineSweep(Cache **caches, int count, TraceReader *trace);
+int runCaches(Cache **caches, int count, TraceReader *trace, char *traceFile, long long int *records);
+int sweepMain(int argc, char *argv[]);
+
+// Hierarchy Functions
+int hierarchyMain(int argc, char *argv[]);
+
+// Multicore Functions
+int multicoreMain(int argc, char *argv[]);
+
+// Resume Functions
+int resumeMain(int argc, char *argv[]);
+
+// Stack Distance Functions
+int runStackProfiles(StackProfile **profiles, int count, char *traceFile);
+int stackMain(int argc, char *argv[]);
+
+// Reuse Analysis Functions
+int runReuseProfile(ReuseProfile *profile, char *traceFile);
+int reuseMain(int argc, char *argv[]);
 
 // Statistics
-void simulationStatistics ();
-void printReportStats(int cacheSize, int associativity, int replacementPolicy, int writePolicy, char *traceFile);
+double statsMissRatio(Stats *stats);
+void simulationStatistics (Stats *stats);
+void printReportStats(int cacheSize, int associativity, int replacementPolicy, int writePolicy, char *traceFile, Stats *stats);
+void printConfigStats(CacheConfig *config, char *traceFile, Stats *stats);
 void singleTest(int cacheSize, int associativity, int replacementPolicy, int writePolicy, char *traceFile);
-void partA();
-void partB();
-void partC();
-void partD();
+void printPart(char *title, int first, int count, Stats *xsbench, Stats *minife);
+void partA(Stats *xsbench, Stats *minife);
+void partB(Stats *xsbench, Stats *minife);
+void partC(Stats *xsbench, Stats *minife);
+void partD(Stats *xsbench, Stats *minife);
 void conductExperiments();
 
 // argc # of arguments, start at 1 b/c 0 is program name 
 // argv <Cache Size>, <Associativity>, <Replacement Policy>, <Write Back>, <TRACE_FILE>
-// Policy: LRU = 0, FIFO = 1. Write Back: Write Through = 0, Write Back = 1
+// Policy: LRU = 0, FIFO = 1, PLRU = 2, NRU = 3, SRRIP = 4, BRRIP = 5, DRRIP = 6, Random = 7, OPT = 8
+// Write Back: Write Through = 0, Write Back = 1
+// Options (before the mode): -threads <N> partitions sets across N worker threads
+//         -block <Bytes> block size, 16-256 (default 64)
+//         -alloc <N> write miss model: mixed = 0 (default), write allocate = 1, no write allocate = 2
+//         -index <N> set index function: modulo = 0 (default), XOR fold = 1
+//         -prefetch <nextline|stride|stream|bestoffset>[:<Degree>] prefetcher on every cache
+//         (not with OPT or -hier)
+//         -record <Prefix> per-interval and per-set counters to <Prefix>-intervals.csv and
+//         <Prefix>-sets.csv, or <Prefix>.bin with -binary (single and sweep modes)
+//         -interval <N> demand accesses per recorded interval (default 1000000)
+//         -sample periodic:<Period>:<Detail> or simpoint:<Interval>[:<Clusters>[:<Per Cluster>]]
+//         simulates only sample windows in detail and reports 95% confidence half widths
+//         -warmup <N> detailed warming accesses before each window, -nowarm no functional
+//         warming between windows (single and sweep modes, not with OPT, -prefetch or -record)
+//         -checkpoint <File>:<Every>[:stop] saves every cache's full state every <Every> accesses;
+//         stop ends the run at the first one (single, sweep and resume modes, serial only,
+//         not with OPT, -prefetch, -record or -sample)
+//         -region <Bytes> power of two region size for -reuse (default 1048576)
+//         -time reports elapsed time and trace records per second on stderr
+// Common configurations run on specialized kernels (kernels.h); SIM_KERNEL=generic turns them off
+// Sweep:  -sweep <TRACE_FILE> <CONFIG> [<CONFIG> ...]
+//         CONFIG = <Cache Size>,<Associativity>,<Replacement Policy>,<Write Back>[,<Block>[,<Alloc>[,<Index>]]]
+//         or @<CONFIG_FILE>. Omitted fields take the option defaults
+// Stack:  -stack <TRACE_FILE> <Max Associativity> <Min Sets> <Max Sets>
+//         LRU miss ratio of every associativity at every power of two multiple of Min Sets up to
+//         Max Sets, one report line each (size assoc policy wb trace); the write policy does not
+//         change the miss ratio, so wb is listed as write back. Only -block and -time apply
+// Reuse:  -reuse <TRACE_FILE> <Prefix> [exact|rate:<R>|max:<Blocks>]
+//         reuse distance histogram and LRU miss ratio curve, working set per -interval window
+//         and reads/writes per region, as <Prefix>-*.csv; rate and max sample blocks (SHARDS)
+// Hierarchy: -hier <TRACE_FILE> <inclusive|exclusive|nine> <LEVEL> [<LEVEL> ...]
+//         LEVEL = <Name>=<Cache Size>,<Associativity>,<Replacement Policy>,<Write Back>[,<Block>,<Alloc>,<Index>]
+//         Every level must use the same block size; the allocation field is ignored
+//         Names l1i and l1d are the first levels, any others (e.g. l2, llc) follow in order
+// Multicore: -multi <rr|time> <L1 CONFIG> <LLC CONFIG> <TRACE_FILE> [<TRACE_FILE> ...]
+//         one trace per core, private MESI L1s over a shared inclusive LLC; rr interleaves one
+//         access per core in turn, time merges by the decimal timestamp after each address.
+//         Both levels must be write back with the same block size
+// Resume: -resume <CHECKPOINT> [<TRACE_FILE>]
+//         continues a checkpointed single or sweep run, on its own trace unless one is given
+// TRACE_FILE may be "-" for stdin or a FIFO, and may be gzip or zstd compressed (decompressed
+// through the system gzip/zstd tools)
 int main(int argc, char* argv[]) {
 
-    // Create new cache with specififed parameters
-    int associativity = (int) strtol(argv[2], NULL, 0), policy = (int) strtol(argv[3], NULL, 0), writeBack = (int) strtol(argv[4], NULL, 0);
-    int cacheSize = (int) strtol(argv[1], NULL, 0);
-    int numSets = cacheSize / (associativity * BLOCK_SIZE);
-    Cache *cache = createCache(associativity, numSets, policy, writeBack);
+    // Strip leading options so each mode sees its own arguments from argv[1]
+    int consumed = parseOptions(argc, argv);
+    if(consumed < 0) return 1;
+    argv[consumed] = argv[0];
+    argc -= consumed;
+    argv += consumed;
 
-    // Read file
-    char *traceFile = argv[5];
-    FILE *file = fopen(traceFile, "r");
+    // Sweep mode: every configuration is fed from a single pass over the trace
+    if(argc > 1 && strcmp(argv[1], "-sweep") == 0) return sweepMain(argc, argv);
 
-    // Validate Path
-    if(!file) {
-        printf("Bad Path.\n");
+    // Stack distance mode: every LRU cache size from a single pass over the trace
+    if(argc > 1 && strcmp(argv[1], "-stack") == 0) return stackMain(argc, argv);
+
+    // Reuse mode: reuse distances, working sets and regions from a single pass over the trace
+    if(argc > 1 && strcmp(argv[1], "-reuse") == 0) return reuseMain(argc, argv);
+
+    // Hierarchy mode: chained cache levels with per-level traffic
+    if(argc > 1 && strcmp(argv[1], "-hier") == 0) return hierarchyMain(argc, argv);
+
+    // Multicore mode: per-core traces over coherent L1s and a shared LLC
+    if(argc > 1 && strcmp(argv[1], "-multi") == 0) return multicoreMain(argc, argv);
+
+    // Resume mode: continue a checkpointed run
+    if(argc > 1 && strcmp(argv[1], "-resume") == 0) return resumeMain(argc, argv);
+
+    // Ensure valid # of arguments given
+    if(argc != 6) {
+        printf("Invalid number of arguments.\n");
         return 1;
     }
 
-    // Begin simulation
-    else {
-        char operation;
-        unsigned long long int address;
-        int counter = 0;
-        while(!feof(file)) {
-            fscanf(file, "%c %llx ", &operation, &address);
-            simulateCacheAccess(operation, address, cache);
+    // Create new cache with specififed parameters
+    CacheConfig config;
+    config.cacheSize = (int) strtol(argv[1], NULL, 0);
+    config.associativity = (int) strtol(argv[2], NULL, 0);
+    config.replacementPolicy = (int) strtol(argv[3], NULL, 0);
+    config.writePolicy = (int) strtol(argv[4], NULL, 0);
+    config.blockSize = options.blockSize;
+    config.allocation = options.allocation;
+    config.indexing = options.indexing;
+    if(!validPolicy(config.replacementPolicy, config.associativity)) {
+        printf("Bad replacement policy.\n");
+        return 1;
+    }
+    if(config.associativity < 1 || configSets(&config) < 1) {
+        printf("Bad cache geometry.\n");
+        return 1;
+    }
+
+    // Simulate the trace and output results
+    Stats stats;
+    PrefetchStats prefetch;
+    SampleEstimate estimate;
+    int ok = runSweep(&config, 1, argv[5], &stats, &prefetch, &estimate);
+    if(ok != 1) return (ok == SWEEP_STOPPED) ? 0 : 1;
+    simulationStatistics (&stats);
+    if(options.prefetcher != NO_PREFETCH) printPrefetchStats(&prefetch, &stats);
+    if(options.sample.mode != SAMPLE_NONE) printSampleEstimate(&estimate);
+    return 0;
+}
+
+// Parses leading options into the global options. Returns the number of arguments consumed, -1 on error
+int parseOptions(int argc, char *argv[]) {
+    int i = 1;
+    while(i < argc && argv[i][0] == '-' && argv[i][1] != '\0') {
+        if(strcmp(argv[i], "-threads") == 0 && i + 1 < argc) {
+            options.threads = (int) strtol(argv[i + 1], NULL, 0);
+            if(options.threads < 1 || options.threads > MAX_THREADS) {
+                printf("Bad thread count.\n");
+                return -1;
+            }
+            i += 2;
         }
-        simulationStatistics ();
+        else if(strcmp(argv[i], "-block") == 0 && i + 1 < argc) {
+            options.blockSize = (int) strtol(argv[i + 1], NULL, 0);
+            if(!validBlockSize(options.blockSize)) {
+                printf("Bad block size.\n");
+                return -1;
+            }
+            i += 2;
+        }
+        else if(strcmp(argv[i], "-alloc") == 0 && i + 1 < argc) {
+            options.allocation = (int) strtol(argv[i + 1], NULL, 0);
+            if(options.allocation < WRITE_MIXED || options.allocation > NO_WRITE_ALLOCATE) {
+                printf("Bad write allocation.\n");
+                return -1;
+            }
+            i += 2;
+        }
+        else if(strcmp(argv[i], "-index") == 0 && i + 1 < argc) {
+            options.indexing = (int) strtol(argv[i + 1], NULL, 0);
+            if(options.indexing < INDEX_MODULO || options.indexing > INDEX_XOR) {
+                printf("Bad index function.\n");
+                return -1;
+            }
+            i += 2;
+        }
+        else if(strcmp(argv[i], "-record") == 0 && i + 1 < argc) {
+            options.record = argv[i + 1];
+            i += 2;
+        }
+        else if(strcmp(argv[i], "-interval") == 0 && i + 1 < argc) {
+            options.interval = strtoll(argv[i + 1], NULL, 0);
+            if(options.interval < 1) {
+                printf("Bad interval.\n");
+                return -1;
+            }
+            i += 2;
+        }
+        else if(strcmp(argv[i], "-region") == 0 && i + 1 < argc) {
+            options.regionSize = (int) strtol(argv[i + 1], NULL, 0);
+            if(options.regionSize < options.blockSize || (options.regionSize & (options.regionSize - 1)) != 0) {
+                printf("Bad region size.\n");
+                return -1;
+            }
+            i += 2;
+        }
+        else if(strcmp(argv[i], "-binary") == 0) {
+            options.binary = 1;
+            i++;
+        }
+        else if(strcmp(argv[i], "-sample") == 0 && i + 1 < argc) {
+            if(!parseSamplePlan(argv[i + 1], &options.sample)) {
+                printf("Bad sample plan.\n");
+                return -1;
+            }
+            i += 2;
+        }
+        else if(strcmp(argv[i], "-warmup") == 0 && i + 1 < argc) {
+            options.sample.warmup = strtoll(argv[i + 1], NULL, 0);
+            if(options.sample.warmup < 0) {
+                printf("Bad warmup.\n");
+                return -1;
+            }
+            i += 2;
+        }
+        else if(strcmp(argv[i], "-checkpoint") == 0 && i + 1 < argc) {
+            if(!parseCheckpointing(argv[i + 1], &options.checkpoint)) {
+                printf("Bad checkpoint.\n");
+                return -1;
+            }
+            i += 2;
+        }
+        else if(strcmp(argv[i], "-nowarm") == 0) {
+            options.sample.functional = 0;
+            i++;
+        }
+        else if(strcmp(argv[i], "-time") == 0) {
+            startTraceTimer();
+            i++;
+        }
+        else if(strcmp(argv[i], "-prefetch") == 0 && i + 1 < argc) {
+            if(!parsePrefetcher(argv[i + 1], &options.prefetcher, &options.degree)) {
+                printf("Bad prefetcher.\n");
+                return -1;
+            }
+            i += 2;
+        }
+        else break;
+    }
+    return i - 1;
+}
 
-        // Free cache memory
-        clearCache(cache);
+// The report line of a configuration; block size, allocation and indexing are listed when not the defaults
+void printConfigStats(CacheConfig *config, char *traceFile, Stats *stats) {
+    if(configBlockSize(config) == BLOCK_SIZE && config->allocation == WRITE_MIXED && config->indexing == INDEX_MODULO) {
+        printReportStats(config->cacheSize, config->associativity, config->replacementPolicy, config->writePolicy, traceFile, stats);
+        return;
     }
+    printf("\t%d %d %d %d %d %d %d %s:\t", config->cacheSize, config->associativity, config->replacementPolicy, config->writePolicy, configBlockSize(config), config->allocation, config->indexing, traceFile);
+    printf("%.6f", statsMissRatio(stats));
+    printf("\t%lld", stats->writes);
+    printf("\t%lld\n", stats->reads);
+}
 
-    // End Simulation
-    fclose(file);
-    return 0;
+void printReportStats(int cacheSize, int associativity, int replacementPolicy, int writePolicy, char *traceFile, Stats *stats) {
+    // Output desired simualtion stats
+    printf("\t%d %d %d %d %s:\t", cacheSize, associativity, replacementPolicy, writePolicy, traceFile);
+    printf("%.6f", statsMissRatio(stats));
+    printf("\t%lld", stats->writes);
+    printf("\t%lld\n", stats->reads);
+}
+
+// Parses "<Cache Size>,<Associativity>,<Replacement Policy>,<Write Back>[,<Block>[,<Alloc>[,<Index>]]]"
+// (commas or whitespace). Returns 1 on success
+int parseConfig(char *spec, CacheConfig *config) {
+    int fields[7] = {0, 0, 0, 0, options.blockSize, options.allocation, options.indexing}, n = 0;
+    char *cursor = spec, *end;
+    while(n < 7) {
+        while(*cursor == ',' || *cursor == ' ' || *cursor == '\t') cursor++;
+        int value = (int) strtol(cursor, &end, 0);
+        if(end == cursor) {
+            if(n < 4) return 0;
+            break;
+        }
+        fields[n] = value;
+        cursor = end;
+        n++;
+    }
+    config->cacheSize = fields[0];
+    config->associativity = fields[1];
+    config->replacementPolicy = fields[2];
+    config->writePolicy = fields[3];
+    config->blockSize = fields[4];
+    config->allocation = fields[5];
+    config->indexing = fields[6];
+
+    // Reject geometries that don't yield at least one full set, and unknown policies or models
+    if(!validBlockSize(config->blockSize) || config->allocation < WRITE_MIXED || config->allocation > NO_WRITE_ALLOCATE) return 0;
+    if(config->indexing < INDEX_MODULO || config->indexing > INDEX_XOR) return 0;
+    if(config->associativity <= 0 || configSets(config) <= 0) return 0;
+    return validPolicy(config->replacementPolicy, config->associativity);
 }
 
-// Block Function Definitons
-Block *createBlock(unsigned long long int tag) {
-    // New Block
-   Block *newBlock = (Block *) malloc(sizeof(Block));
+// Block size of a configuration (0 in the built-in tables means BLOCK_SIZE)
+int configBlockSize(CacheConfig *config) {
+    return (config->blockSize > 0) ? config->blockSize : BLOCK_SIZE;
+}
 
-   // Initialize block memebers
-   newBlock->dirty = 0;
-   newBlock->tag = tag;
-   newBlock->prev = newBlock;
-   newBlock->next = newBlock;
+// Number of sets a configuration's geometry yields
+int configSets(CacheConfig *config) {
+    return config->cacheSize / (config->associativity * configBlockSize(config));
+}
 
-   // Return new block
-   return newBlock;
+// Appends a configuration to a growable list. Returns 1 on success
+int addConfig(CacheConfig config, CacheConfig **configs, int *count, int *capacity) {
+    if(*count == *capacity) {
+        *capacity = (*capacity == 0) ? 16 : 2 * (*capacity);
+        *configs = (CacheConfig *) realloc(*configs, *capacity * sizeof(CacheConfig));
+        if(*configs == NULL) return 0;
+    }
+    (*configs)[(*count)++] = config;
+    return 1;
 }
 
-Block *linkBlocks(unsigned long long int tag, Block *block) {
-    // Block to link with passed in block
-    Block *newBlock = createBlock(tag);
+// Reads one configuration per line from a file, skipping blank lines and '#' comments. Returns 1 on success
+int loadConfigs(char *path, CacheConfig **configs, int *count, int *capacity) {
+    FILE *file = fopen(path, "r");
+    if(!file) return 0;
+
+    char line[256];
+    CacheConfig config;
+    while(fgets(line, sizeof(line), file)) {
+        char *start = line;
+        while(*start == ' ' || *start == '\t') start++;
+        if(*start == '#' || *start == '\n' || *start == '\r' || *start == '\0') continue;
+        if(!parseConfig(start, &config) || !addConfig(config, configs, count, capacity)) {
+            printf("Bad configuration: %s", line);
+            fclose(file);
+            return 0;
+        }
+    }
+    fclose(file);
+    return 1;
+}
 
-    // Empty Set
-    if(block == NULL) return newBlock;
+// Simulates every configuration against a single pass over the trace. Records are read in
+// batches and each batch is replayed through every cache before the next is parsed, so the
+// trace is only decoded once no matter how many configurations are swept.
+// Writes the final counters of configs[i] to results[i], and its prefetch counters to
+// prefetchResults[i] when that isn't NULL. Sampled runs write estimated totals to results[i]
+// and the estimate itself to estimates[i] when that isn't NULL. Returns 1 on success, or
+// SWEEP_STOPPED if a checkpoint ended the run
+int runSweep(CacheConfig *configs, int count, char *traceFile, Stats *results, PrefetchStats *prefetchResults, SampleEstimate *estimates) {
+    // A prefetch fill has no next use of its own to give OPT, and sampling skips the future OPT needs
+    int sampled = options.sample.mode != SAMPLE_NONE;
+    for(int i = 0; i < count; i++) {
+        if(options.prefetcher != NO_PREFETCH && configs[i].replacementPolicy == OPT) {
+            printf("Prefetching is not supported with OPT.\n");
+            return 0;
+        }
+        if(sampled && configs[i].replacementPolicy == OPT) {
+            printf("Sampling is not supported with OPT.\n");
+            return 0;
+        }
+    }
+    if(sampled && (options.prefetcher != NO_PREFETCH || options.record != NULL)) {
+        printf("Sampling is not supported with -prefetch or -record.\n");
+        return 0;
+    }
+    if(options.checkpoint.path != NULL && (sampled || options.prefetcher != NO_PREFETCH || options.record != NULL)) {
+        printf("Checkpointing is not supported with -sample, -prefetch or -record.\n");
+        return 0;
+    }
+    if(options.sample.mode == SAMPLE_SIMPOINT && !planSimPoints(&options.sample, traceFile)) {
+        printf("Bad Path.\n");
+        return 0;
+    }
+    TraceReader *trace = openTrace(traceFile);
+    if(!trace) {
+        printf("Bad Path.\n");
+        return 0;
+    }
+    Recorder recorder;
+    if(options.record != NULL && !openRecorder(options.record, options.binary, &recorder)) {
+        printf("Bad record path.\n");
+        closeTrace(trace);
+        return 0;
+    }
 
-    // Link Up
-    newBlock->prev = block;
-    newBlock->next = block->next;
-    block->next->prev = newBlock;
-    block->next = newBlock;
+    Cache **caches = (Cache **) malloc(count * sizeof(Cache *));
+    for(int i = 0; i < count; i++) {
+        caches[i] = createCacheExtended(configs[i].associativity, configSets(&configs[i]), configs[i].replacementPolicy, configs[i].writePolicy,
+            configBlockSize(&configs[i]), configs[i].allocation, configs[i].indexing);
+        attachPrefetcher(caches[i], options.prefetcher, options.degree);
+        if(options.record != NULL) enableRecording(caches[i], options.interval);
+    }
 
-    // Return
-    return newBlock;
+    // OPT needs the future, so those sweeps run from an in-memory copy of the trace. Worker threads
+    // each own a slice of every cache's sets (routed accesses carry a short cache index), which
+    // needs policies whose state doesn't span sets, no prefetcher filling other sets and no
+    // intervals or checkpoints cut in trace order
+    int offline = 0, setLocal = options.prefetcher == NO_PREFETCH && options.record == NULL && options.checkpoint.path == NULL;
+    for(int i = 0; i < count; i++) {
+        offline |= configs[i].replacementPolicy == OPT;
+        setLocal &= caches[i]->policy->setLocal;
+    }
+    if(offline && options.checkpoint.path != NULL) {
+        printf("Checkpointing is not supported with OPT.\n");
+        for(int i = 0; i < count; i++) clearCache(caches[i]);
+        free(caches);
+        closeTrace(trace);
+        return 0;
+    }
+    SampleEstimate *scratch = NULL;
+    long long int records = 0;
+    int finished = 1, estimated = 1;
+    if(sampled) {
+        if(estimates == NULL) estimates = scratch = (SampleEstimate *) malloc(count * sizeof(SampleEstimate));
+        estimated = runSampledSweep(caches, count, trace, &options.sample, results, estimates);
+        deleteSamplePlan(&options.sample);
+        if(!estimated) printf("No sample window in the trace.\n");
+    }
+    else if(offline) runOfflineSweep(caches, count, trace);
+    else if(options.threads > 1 && count <= 32767 && setLocal) runParallelSweep(caches, count, trace, options.threads);
+    else finished = runCaches(caches, count, trace, traceFile, &records);
+
+    // Collect results and free caches
+    for(int i = 0; i < count; i++) {
+        if(!sampled) results[i] = caches[i]->stats;
+        if(prefetchResults != NULL) prefetchResults[i] = caches[i]->prefetchStats;
+        if(options.record != NULL) writeRecord(&recorder, i, caches[i]);
+        clearCache(caches[i]);
+    }
+    if(options.record != NULL) closeRecorder(&recorder);
+    free(scratch);
+    free(caches);
+    closeTrace(trace);
+    if(!estimated) return 0;
+    return finished ? 1 : SWEEP_STOPPED;
 }
 
-Block *unlinkBlocks(Block *block) {
-    // Empty set
-    if(block == NULL) return NULL;
-    
-    // Single block set, remove only block
-    else if(block == block->next || block == block->prev) {
-        free(block);
-        return NULL;
+// Replays the rest of the trace (records accesses in) through every cache, a batch at a time,
+// writing checkpoints on the way. Returns 0 if the run stopped at a checkpoint, 1 at the end
+int runCaches(Cache **caches, int count, TraceReader *trace, char *traceFile, long long int *records) {
+    Checkpointing *checkpoint = &options.checkpoint;
+    long long int next = (checkpoint->path != NULL) ? (*records / checkpoint->every + 1) * checkpoint->every : -1;
+    Access *batch = (Access *) malloc(SWEEP_BATCH * sizeof(Access));
+    CacheKernel *kernels = (CacheKernel *) malloc(count * sizeof(CacheKernel));
+    for(int i = 0; i < count; i++) kernels[i] = selectKernel(caches[i]);
+    int size, finished = 1;
+    for(;;) {
+        // Stop each batch at the next checkpoint
+        int max = (next >= 0 && next - *records < SWEEP_BATCH) ? (int) (next - *records) : SWEEP_BATCH;
+        if((size = readAccesses(trace, batch, max)) <= 0) break;
+
+        // Replay the batch through each cache in turn, with its specialized kernel when it has one
+        for(int i = 0; i < count; i++) kernels[i](batch, size, caches[i]);
+        *records += size;
+        if(*records != next) continue;
+
+        if(!saveCacheCheckpoint(checkpoint, caches, count, traceFile, *records, traceOffset(trace))) printf("Bad checkpoint path.\n");
+        else if(checkpoint->stop) {
+            printf("Checkpoint saved at %lld accesses.\n", *records);
+            finished = 0;
+            break;
+        }
+        next += checkpoint->every;
     }
+    free(kernels);
+    free(batch);
+    return finished;
+}
 
-    // Multiple blocks
-    Block *newBlock = block->prev;
-    block->next->prev = newBlock;
-    newBlock->next = block->next;
+// Loads the rest of the trace, works out when each access's block is next used, then replays the
+// whole trace through each cache in turn with that next use available to OPT
+void runOfflineSweep(Cache **caches, int count, TraceReader *trace) {
+    long long int total = 0, capacity = 1 << 16;
+    Access *accesses = (Access *) malloc(capacity * sizeof(Access));
+    int size;
+    while((size = readAccesses(trace, accesses + total, (int) ((capacity - total < SWEEP_BATCH) ? capacity - total : SWEEP_BATCH))) > 0) {
+        total += size;
+        if(total == capacity) {
+            capacity *= 2;
+            accesses = (Access *) realloc(accesses, capacity * sizeof(Access));
+        }
+    }
 
-    // Free unlinked block and return new block
-    free(block);
-    return newBlock;
+    // Next uses depend on the block size, so they're recomputed whenever an OPT cache's differs
+    unsigned long long int *blocks = (unsigned long long int *) malloc((total > 0 ? total : 1) * sizeof(unsigned long long int));
+    unsigned long long int *nextUse = NULL;
+    int shift = -1;
+    for(int c = 0; c < count; c++) {
+        if(caches[c]->replacementPolicy == OPT && caches[c]->blockShift != shift) {
+            shift = caches[c]->blockShift;
+            for(long long int i = 0; i < total; i++) blocks[i] = accesses[i].address >> shift;
+            free(nextUse);
+            nextUse = computeNextUse(blocks, total);
+        }
+        for(long long int i = 0; i < total; i++) {
+            if(caches[c]->replacementPolicy == OPT) caches[c]->upcoming = nextUse[i];
+            simulateCacheAccess(accesses[i].operation, accesses[i].address, caches[c]);
+        }
+    }
+    free(blocks);
+    free(nextUse);
+    free(accesses);
 }
 
-// Set Function Defintions
-Set *createSet(int capacity) {
-    // New set
-    Set *newSet = (Set *) malloc(sizeof(Set));
+// Entry point for -sweep: SIM -sweep <TRACE_FILE> <CONFIG> [<CONFIG> ...]
+int sweepMain(int argc, char *argv[]) {
+    if(argc < 4) {
+        printf("Invalid number of arguments.\n");
+        return 1;
+    }
 
-    // Initialize set members
-    newSet->capacity = capacity;
-    newSet->size = 0;
-    newSet->tracker = NULL;
+    // Gather configurations from the command line and any @files
+    CacheConfig *configs = NULL, config;
+    int count = 0, capacity = 0;
+    for(int i = 3; i < argc; i++) {
+        int ok;
+        if(argv[i][0] == '@') ok = loadConfigs(argv[i] + 1, &configs, &count, &capacity);
+        else ok = parseConfig(argv[i], &config) && addConfig(config, &configs, &count, &capacity);
+        if(!ok) {
+            printf("Bad configuration: %s\n", argv[i]);
+            free(configs);
+            return 1;
+        }
+    }
 
-    // Return new set
-    return newSet;
+    // Simulate and report one line per configuration
+    char *traceFile = argv[2];
+    Stats *results = (Stats *) malloc(count * sizeof(Stats));
+    PrefetchStats *prefetch = (PrefetchStats *) malloc(count * sizeof(PrefetchStats));
+    SampleEstimate *estimates = (SampleEstimate *) malloc(count * sizeof(SampleEstimate));
+    options.checkpoint.mode = CHECKPOINT_SWEEP;
+    int ok = runSweep(configs, count, traceFile, results, prefetch, estimates);
+    if(ok == 1) {
+        for(int i = 0; i < count; i++) {
+            printConfigStats(&configs[i], traceFile, &results[i]);
+            if(options.prefetcher != NO_PREFETCH) printPrefetchLine(&prefetch[i], &results[i]);
+            if(options.sample.mode != SAMPLE_NONE) printSampleLine(&estimates[i]);
+        }
+    }
+    free(results);
+    free(prefetch);
+    free(estimates);
+    free(configs);
+    return ok ? 0 : 1;
 }
 
-Set *insertBlock(int operation, int event, int writePolicy, unsigned long long int tag , Set *set) {
-    // Only add to sets when not at capacity.
-    if(set->size < set->capacity) {
-        set->tracker = linkBlocks(tag, set->tracker);
+// Feeds a single pass over the trace to every stack profile. Returns 1 on success
+int runStackProfiles(StackProfile **profiles, int count, char *traceFile) {
+    TraceReader *trace = openTrace(traceFile);
+    if(!trace) {
+        printf("Bad Path.\n");
+        return 0;
+    }
 
-        // Write back condiiton check, simulataneously increment size (only mark dirty blocks when set not empty)
-        if(set->size++ > 0 && operation == 'W' && event == HIT && writePolicy == WRITE_BACK) set->tracker->dirty = DIRTY;
+    Access *batch = (Access *) malloc(SWEEP_BATCH * sizeof(Access));
+    int size;
+    while((size = readAccesses(trace, batch, SWEEP_BATCH)) > 0) {
+        for(int i = 0; i < count; i++) {
+            StackProfile *profile = profiles[i];
+            for(int j = 0; j < size; j++) recordStackAccess(batch[j].address / options.blockSize, profile);
+        }
     }
-    return set;
+
+    free(batch);
+    closeTrace(trace);
+    return 1;
 }
 
-Set *removeBlock(int writePolicy, int replacementPolicy, int event, Block *target, Set *set) { 
-    
-    // Write Back if Write Hit and evicting dirty block
-    int evicting = (writePolicy == WRITE_BACK) && (event == MISS);
+// Entry point for -stack: SIM -stack <TRACE_FILE> <Max Associativity> <Min Sets> <Max Sets>
+int stackMain(int argc, char *argv[]) {
+    if(argc != 6) {
+        printf("Invalid number of arguments.\n");
+        return 1;
+    }
 
-    // FIFO Hit == unchanged set, FIFO Miss below
-    if(replacementPolicy == FIFO && event == MISS) {
-        // Evict FIFO always removes the head, target == NULL b/c Miss
-        if(evicting && set->tracker->next->dirty == DIRTY) writes++;
-        set->tracker = unlinkBlocks(set->tracker->next); 
+    if(options.threads > 1 || options.allocation != WRITE_MIXED || options.indexing != INDEX_MODULO || options.prefetcher != NO_PREFETCH
+        || options.record || options.sample.mode != SAMPLE_NONE || options.checkpoint.path) {
+        printf("Threads, write allocation, indexing, prefetching, recording, sampling and checkpoints are not supported in stack mode.\n");
+        return 1;
     }
-    else if(replacementPolicy == LRU) {
-        if(event == HIT) {
-            // Target = Head
-            if(target == set->tracker->next) set->tracker = unlinkBlocks(set->tracker->next);
 
-            // Target = Tail
-            else if(target == set->tracker) set->tracker = unlinkBlocks(set->tracker);
+    int maxAssociativity = (int) strtol(argv[3], NULL, 0);
+    int minSets = (int) strtol(argv[4], NULL, 0), maxSets = (int) strtol(argv[5], NULL, 0);
+    if(maxAssociativity < 1 || minSets < 1 || maxSets < minSets) {
+        printf("Bad stack parameters.\n");
+        return 1;
+    }
 
-            // Target = middle of set
-            else unlinkBlocks(target);
-        }
-        // Evict LRU always removes the head, target == NULL b/c Miss
-        else if(event == MISS) {
-            if(evicting && set->tracker->next->dirty == DIRTY) writes++;
-            set->tracker = unlinkBlocks(set->tracker->next);
+    // One profile per power of two multiple of the minimum set count
+    int count = 0;
+    for(long long int sets = minSets; sets <= maxSets; sets *= 2) count++;
+    StackProfile **profiles = (StackProfile **) malloc(count * sizeof(StackProfile *));
+    for(int i = 0; i < count; i++) profiles[i] = createStackProfile(minSets << i, maxAssociativity);
+
+    // Report the LRU miss ratio curve: one line per (sets, associativity) point
+    char *traceFile = argv[2];
+    int ok = runStackProfiles(profiles, count, traceFile);
+    for(int i = 0; i < count; i++) {
+        if(ok) {
+            for(int a = 1; a <= maxAssociativity; a++) {
+                long long int cacheSize = (long long int) profiles[i]->numberOfSets * a * options.blockSize;
+                printf("\t%lld %d %d %d %s:\t%.6f\n", cacheSize, a, LRU, WRITE_BACK, traceFile, stackMissRatio(a, profiles[i]));
+            }
         }
+        deleteStackProfile(profiles[i]);
     }
-    
-    // Reduce set size, return
-    set->size--;
-    return set;
+    free(profiles);
+    return ok ? 0 : 1;
 }
 
-Block *searchSet(unsigned long long int tag, Set *set) {
-    Block *currBlock = set->tracker;
-    if(currBlock != NULL) {
-        do {
-            if(tag == currBlock->tag) return currBlock;
-            else currBlock = currBlock->next;
-        } while(currBlock != set->tracker);
+// Feeds every trace access to the reuse profile. Returns 1 on success
+int runReuseProfile(ReuseProfile *profile, char *traceFile) {
+    TraceReader *trace = openTrace(traceFile);
+    if(!trace) {
+        printf("Bad Path.\n");
+        return 0;
     }
-    return NULL;
-}
 
-void deleteSet(Set *set) {
-    // Empty the set and then free it
-    while(set->tracker != NULL) set->tracker = unlinkBlocks(set->tracker);
-    free(set);
-}
+    Access *batch = (Access *) malloc(SWEEP_BATCH * sizeof(Access));
+    int size;
+    while((size = readAccesses(trace, batch, SWEEP_BATCH)) > 0) {
+        for(int j = 0; j < size; j++) recordReuse(batch[j].operation, batch[j].address, profile);
+    }
 
-// Cache Function Definitions 
-Cache *createCache(int associativity, int numberOfSets, int replacementPolicy, int writePolicy) {
-    // Create new cache
-    Cache *newCache = (Cache *) malloc(sizeof(Cache));
-
-    // Initialize the tag array (array of set pointers)
-    newCache->tagArray = (Set **) malloc(numberOfSets * sizeof(Set *));
-    for(int i = 0; i <numberOfSets; i++) newCache->tagArray[i] = createSet(associativity);
-    
-    // Initialize the rest of the cache members
-    newCache->associativty = associativity;
-    newCache->numberOfSets = numberOfSets;
-    newCache->replacementPolicy = replacementPolicy;
-    newCache->writePolicy = writePolicy;
-
-    // Return new cache
-    return newCache;
+    free(batch);
+    closeTrace(trace);
+    return 1;
 }
 
-void simulateCacheAccess(char operation, unsigned long long int address, Cache *cache) {
-    // Calculate the set number/cache index and tag of the indicated address
-    unsigned long long int tag = address / BLOCK_SIZE;
-    int setNumber = (address / BLOCK_SIZE) % cache->numberOfSets;
-
-    // Search for address
-    Set *targetSet = cache->tagArray[setNumber];
-    Block *targetBlock = searchSet(tag, targetSet);
-    //printf("target set = %d -> ", setNumber);
-    // Hit
-    if(targetBlock !=  NULL) {
-        //printf("%c HIT -> ", operation);
-        // Increment hit counter. Increment writes on write hit and write throuh
-        if(operation == 'W' && cache->writePolicy == WRITE_THROUGH) writes++;
-        hits++;
-
-        // Update Cache Block in both Write Through and Write Back
-        if(cache->replacementPolicy == FIFO) targetSet = updateCache_FIFO(HIT, operation, cache->writePolicy, tag, targetBlock, targetSet); 
-        else if(cache->replacementPolicy == LRU) targetSet = updateCache_LRU(HIT, operation, cache->writePolicy, tag, targetBlock, targetSet);
-    }
-    // Miss
-    else {
-        //printf("%c MISS -> ", operation);
-        // Increment misses
-        misses++;
-
-        // Write miss. Write to memory.
-        // Assuming from tests and sample input: a mixed Write allocate/no allocate policy
-        // This means that we write to main memeory first then
-        // We load the block into memory via a read
-        if(operation == 'W') {
-            writes++;
-            reads++;
-        }
+// Entry point for -reuse: SIM -reuse <TRACE_FILE> <Prefix> [exact|rate:<R>|max:<Blocks>]
+int reuseMain(int argc, char *argv[]) {
+    if(argc != 4 && argc != 5) {
+        printf("Invalid number of arguments.\n");
+        return 1;
+    }
 
-        // Read miss, fetch from memory
-        else if(operation == 'R') reads++;
+    int mode = REUSE_EXACT;
+    double rate = 1.0;
+    long long int maxBlocks = 0;
+    if(argc == 5 && !parseReuseSampling(argv[4], &mode, &rate, &maxBlocks)) {
+        printf("Bad sampling.\n");
+        return 1;
+    }
+    if(options.regionSize < options.blockSize) {
+        printf("Bad region size.\n");
+        return 1;
+    }
 
-        // Update cache block
-        if(cache->replacementPolicy == FIFO) targetSet = updateCache_FIFO(MISS, operation, cache->writePolicy, tag, targetBlock, targetSet);
-        else if(cache->replacementPolicy == LRU) targetSet = updateCache_LRU(MISS, operation, cache->writePolicy, tag, targetBlock, targetSet);
+    ReuseProfile *profile = createReuseProfile(options.blockSize, options.regionSize, options.interval, mode, rate, maxBlocks);
+    int ok = runReuseProfile(profile, argv[2]);
+    if(ok) {
+        ok = writeReuseProfile(argv[3], profile);
+        if(ok) printReuseSummary(profile);
+        else printf("Bad Path.\n");
     }
+    deleteReuseProfile(profile);
+    return ok ? 0 : 1;
 }
 
-Set *updateCache_LRU(int event, char operation, int writePolicy, unsigned long long int tag, Block* block, Set *set) {
-    
-    if(event == HIT) {
-        // Remove tag and re add to move it up the stack IF not alr at the top
-        set = removeBlock(writePolicy, LRU, event, block, set);
-        set = insertBlock(operation, event, writePolicy, tag, set);
+// Entry point for -hier: SIM -hier <TRACE_FILE> <Inclusion> <LEVEL> [<LEVEL> ...]
+int hierarchyMain(int argc, char *argv[]) {
+    if(argc < 5) {
+        printf("Invalid number of arguments.\n");
+        return 1;
+    }
+    if(options.prefetcher != NO_PREFETCH) {
+        printf("Prefetching is not supported in hierarchy mode.\n");
+        return 1;
     }
+
+    int inclusion;
+    if(strcmp(argv[3], "inclusive") == 0) inclusion = INCLUSIVE;
+    else if(strcmp(argv[3], "exclusive") == 0) inclusion = EXCLUSIVE;
+    else if(strcmp(argv[3], "nine") == 0) inclusion = NINE;
     else {
-        // Cold miss
-        if(set->size < set->capacity) set = insertBlock(operation, event, writePolicy, tag, set);
-        
-        // Capacity Miss: Evict
-        else if(set->size == set->capacity) {
-            set = removeBlock(writePolicy, LRU, event, block, set);
-            set = insertBlock(operation, event, writePolicy, tag, set);
+        printf("Unknown inclusion policy: %s\n", argv[3]);
+        return 1;
+    }
+
+    // Levels: name=size,assoc,policy,wb
+    Hierarchy *hierarchy = createHierarchy(inclusion);
+    for(int i = 4; i < argc; i++) {
+        char *equals = strchr(argv[i], '=');
+        CacheConfig config;
+        int ok = equals != NULL && parseConfig(equals + 1, &config);
+        if(ok) {
+            *equals = '\0';
+            ok = addLevel(argv[i], config.cacheSize, config.associativity, config.replacementPolicy, config.writePolicy, config.blockSize, config.indexing, hierarchy);
+        }
+        if(!ok) {
+            printf("Bad level: %s\n", argv[i]);
+            deleteHierarchy(hierarchy);
+            return 1;
         }
     }
+    if(!linkHierarchy(hierarchy)) {
+        printf("The hierarchy needs an l1d level.\n");
+        deleteHierarchy(hierarchy);
+        return 1;
+    }
 
-    // Return the updated set
-    return set;
-}
+    TraceReader *trace = openTrace(argv[2]);
+    if(!trace) {
+        printf("Bad Path.\n");
+        deleteHierarchy(hierarchy);
+        return 1;
+    }
+    Access *batch = (Access *) malloc(SWEEP_BATCH * sizeof(Access));
+    int size;
+    while((size = readAccesses(trace, batch, SWEEP_BATCH)) > 0) {
+        for(int j = 0; j < size; j++) simulateHierarchyAccess(batch[j].operation, batch[j].address, hierarchy);
+    }
+    free(batch);
+    closeTrace(trace);
 
-Set *updateCache_FIFO(int event, char operation, int writePolicy, unsigned long long int tag, Block* block, Set *set) {
-    
-    if(event == HIT){
-        // Mark block as dirty if Write and Write Back
-        if(operation == 'W' && writePolicy == WRITE_BACK) block->dirty = DIRTY;
-    } 
-    else {
-        // Cold miss
-        if(set->size < set->capacity) set = insertBlock(operation, event, writePolicy, tag, set);
-        
-        // Capacity Miss: Evict
-        else if(set->size == set->capacity) {
-            set = removeBlock(writePolicy, FIFO, event, block, set);
-            set = insertBlock(operation, event, writePolicy, tag, set);
-        }      
-    }
-
-    // Return the updated set
-    return set;
+    printHierarchyStats(hierarchy);
+    deleteHierarchy(hierarchy);
+    return 0;
 }
 
-void clearCache(Cache *cache) {
-    // Empty the tag array, free it, free the cache
-    for(int i = 0; i < cache->numberOfSets; i++) deleteSet(cache->tagArray[i]);
-    free(cache->tagArray);
-    free(cache);
-}
+// Entry point for -multi: SIM -multi <rr|time> <L1 CONFIG> <LLC CONFIG> <TRACE_FILE> [<TRACE_FILE> ...]
+int multicoreMain(int argc, char *argv[]) {
+    if(argc < 6) {
+        printf("Invalid number of arguments.\n");
+        return 1;
+    }
+    if(options.prefetcher != NO_PREFETCH || options.record || options.sample.mode != SAMPLE_NONE || options.checkpoint.path) {
+        printf("Prefetching, recording, sampling and checkpoints are not supported in multicore mode.\n");
+        return 1;
+    }
 
-void displayCache(Cache *cache) {
-    for(int i = 0; i < cache->numberOfSets; i++) {
-        Set *currSet = cache->tagArray[i];
+    int interleave;
+    if(strcmp(argv[2], "rr") == 0) interleave = INTERLEAVE_ROUND_ROBIN;
+    else if(strcmp(argv[2], "time") == 0) interleave = INTERLEAVE_TIMESTAMP;
+    else {
+        printf("Unknown interleaving: %s\n", argv[2]);
+        return 1;
+    }
 
-        if(currSet == NULL) {
-            printf("Null set\n");
-            return;
-        }
-        if(currSet->tracker == NULL) {
-            printf("\t[Set #: %d. Size: 0. Tracker: NULL] \t | ", i);
-            for(int j = 0; j < currSet->capacity; j++) {
-                printf(" -\t");  
-            }
-            printf("| Tail -> NULL\n");
-            continue;
-        }
-    
-        Block *currBlock = currSet->tracker->next;
-        Block *end = currBlock;
-
-        printf("\t[Set #: %d. Size %d. Tracker: %llx] \tHead -> %llx | ", i, currSet->size, currSet->tracker->tag, currBlock->tag);
-        for(int i = 0; i < currSet->capacity - currSet->size; i++) printf("- ");
-        do { 
-            printf("%llx ", currBlock->tag);
-            currBlock = currBlock->next;
-        } while (currBlock != end);
-        printf("| Tail -> %llx\n", currBlock->prev->tag);
+    // L1 and LLC: size,assoc,policy,wb[,block,alloc,index]
+    CacheConfig l1, llc;
+    Multicore *multicore = NULL;
+    int cores = argc - 5;
+    if(parseConfig(argv[3], &l1) && parseConfig(argv[4], &llc) && l1.writePolicy == WRITE_BACK && llc.writePolicy == WRITE_BACK && configBlockSize(&l1) == configBlockSize(&llc)) {
+        multicore = createMulticore(cores, l1.cacheSize, l1.associativity, l1.replacementPolicy, llc.cacheSize, llc.associativity, llc.replacementPolicy, configBlockSize(&l1), l1.indexing);
+    }
+    if(!multicore) {
+        printf("Bad multicore configuration.\n");
+        return 1;
     }
-}
 
-void printReportStats(int cacheSize, int associativity, int replacementPolicy, int writePolicy, char *traceFile) {
-    // Output desired simualtion stats
-    printf("\t%d %d %d %d %s:\t", cacheSize, associativity, replacementPolicy, writePolicy, traceFile);
-    printf("%.6f", (double) misses / (double) (hits + misses));
-    printf("\t%d", writes);
-    printf("\t%d\n", reads);
-    hits = 0; misses = 0; reads = 0; writes = 0;
+    // One trace per core
+    TraceReader **traces = (TraceReader **) calloc(cores, sizeof(TraceReader *));
+    int ok = 1;
+    for(int c = 0; c < cores && ok; c++) ok = (traces[c] = openTrace(argv[5 + c])) != NULL;
+    if(!ok) printf("Bad Path.\n");
+    else {
+        runMulticore(traces, interleave, multicore);
+        printMulticoreStats(interleave, multicore);
+    }
+    for(int c = 0; c < cores; c++) if(traces[c]) closeTrace(traces[c]);
+    free(traces);
+    deleteMulticore(multicore);
+    return ok ? 0 : 1;
 }
 
-void singleTest(int cacheSize, int associativity, int replacementPolicy, int writePolicy, char *traceFile) {
-    FILE *file = fopen(traceFile, "r");
-    if(!file) printf("Bad Path.\n");
+// Entry point for -resume: SIM -resume <CHECKPOINT> [<TRACE_FILE>]
+int resumeMain(int argc, char *argv[]) {
+    if(argc != 3 && argc != 4) {
+        printf("Invalid number of arguments.\n");
+        return 1;
+    }
+    char savedTrace[1024];
+    int count, mode;
+    long long int records;
+    unsigned long long int offset;
+    Cache **caches = loadCacheCheckpoint(argv[2], &count, &mode, savedTrace, sizeof(savedTrace), &records, &offset);
+    if(!caches) {
+        printf("Bad checkpoint.\n");
+        return 1;
+    }
+
+    // Continue the trace from the saved position; the byte offset only holds for the saved trace,
+    // any other is skipped by record count
+    char *traceFile = (argc == 4) ? argv[3] : savedTrace;
+    if(strcmp(traceFile, savedTrace) != 0) offset = TRACE_NO_OFFSET;
+    TraceReader *trace = openTrace(traceFile);
+    int resumed = 0, finished = 0;
+    if(!trace || !resumeTrace(trace, offset, records, 0)) printf("Bad Path.\n");
     else {
-        fseek(file, 0, SEEK_SET);
-        int numSets = cacheSize / (associativity * BLOCK_SIZE);
-        Cache *cache = createCache(associativity, numSets, replacementPolicy, writePolicy);
-        char operation;
-        unsigned long long int address;
-        while(!feof(file)) {
-            fscanf(file, "%c %llx ", &operation, &address);
-            simulateCacheAccess(operation, address, cache);
-        }
-        printReportStats(cacheSize, associativity, replacementPolicy, writePolicy, traceFile);
+        options.checkpoint.mode = mode;
+        resumed = 1;
+        finished = runCaches(caches, count, trace, traceFile, &records);
+    }
+
+    // Report in the checkpointed run's format
+    for(int i = 0; i < count; i++) {
+        Cache *cache = caches[i];
+        CacheConfig config = {cache->numberOfSets * cache->associativty * cache->blockSize, cache->associativty, cache->replacementPolicy, cache->writePolicy,
+            cache->blockSize, cache->allocation, cache->indexing};
+        if(finished && mode == CHECKPOINT_SWEEP) printConfigStats(&config, traceFile, &cache->stats);
+        else if(finished) simulationStatistics (&cache->stats);
         clearCache(cache);
     }
-    fclose(file);
+    free(caches);
+    if(trace) closeTrace(trace);
+    return resumed ? 0 : 1;
 }
 
+void singleTest(int cacheSize, int associativity, int replacementPolicy, int writePolicy, char *traceFile) {
+    CacheConfig config = {cacheSize, associativity, replacementPolicy, writePolicy, BLOCK_SIZE, WRITE_MIXED, INDEX_MODULO};
+    Stats result;
+    if(runSweep(&config, 1, traceFile, &result, NULL, NULL)) printReportStats(cacheSize, associativity, replacementPolicy, writePolicy, traceFile, &result);
+}
+
+// Configurations for Parts A-D, in report order
+CacheConfig experiments[] = {
+    // Part A: size varied, LRU, write back
+    {8192, 4, LRU, WRITE_BACK, BLOCK_SIZE, WRITE_MIXED, INDEX_MODULO}, {16384, 4, LRU, WRITE_BACK, BLOCK_SIZE, WRITE_MIXED, INDEX_MODULO}, {32768, 4, LRU, WRITE_BACK, BLOCK_SIZE, WRITE_MIXED, INDEX_MODULO},
+    {65536, 4, LRU, WRITE_BACK, BLOCK_SIZE, WRITE_MIXED, INDEX_MODULO}, {131072, 4, LRU, WRITE_BACK, BLOCK_SIZE, WRITE_MIXED, INDEX_MODULO},
+    // Part B: size varied, LRU, write through
+    {8192, 4, LRU, WRITE_THROUGH, BLOCK_SIZE, WRITE_MIXED, INDEX_MODULO}, {16384, 4, LRU, WRITE_THROUGH, BLOCK_SIZE, WRITE_MIXED, INDEX_MODULO}, {32768, 4, LRU, WRITE_THROUGH, BLOCK_SIZE, WRITE_MIXED, INDEX_MODULO},
+    {65536, 4, LRU, WRITE_THROUGH, BLOCK_SIZE, WRITE_MIXED, INDEX_MODULO}, {131072, 4, LRU, WRITE_THROUGH, BLOCK_SIZE, WRITE_MIXED, INDEX_MODULO},
+    // Part C: associativity varied, LRU, write back
+    {32768, 1, LRU, WRITE_BACK, BLOCK_SIZE, WRITE_MIXED, INDEX_MODULO}, {32768, 2, LRU, WRITE_BACK, BLOCK_SIZE, WRITE_MIXED, INDEX_MODULO}, {32768, 4, LRU, WRITE_BACK, BLOCK_SIZE, WRITE_MIXED, INDEX_MODULO},
+    {32768, 8, LRU, WRITE_BACK, BLOCK_SIZE, WRITE_MIXED, INDEX_MODULO}, {32768, 16, LRU, WRITE_BACK, BLOCK_SIZE, WRITE_MIXED, INDEX_MODULO}, {32768, 32, LRU, WRITE_BACK, BLOCK_SIZE, WRITE_MIXED, INDEX_MODULO},
+    {32768, 64, LRU, WRITE_BACK, BLOCK_SIZE, WRITE_MIXED, INDEX_MODULO},
+    // Part D: size varied, FIFO, write back
+    {8192, 4, FIFO, WRITE_BACK, BLOCK_SIZE, WRITE_MIXED, INDEX_MODULO}, {16384, 4, FIFO, WRITE_BACK, BLOCK_SIZE, WRITE_MIXED, INDEX_MODULO}, {32768, 4, FIFO, WRITE_BACK, BLOCK_SIZE, WRITE_MIXED, INDEX_MODULO},
+    {65536, 4, FIFO, WRITE_BACK, BLOCK_SIZE, WRITE_MIXED, INDEX_MODULO}, {131072, 4, FIFO, WRITE_BACK, BLOCK_SIZE, WRITE_MIXED, INDEX_MODULO}
+};
+#define NUM_EXPERIMENTS (int) (sizeof(experiments) / sizeof(experiments[0]))
+
 void conductExperiments() {
-    partA();
-    partB();
-    partC();
-    partD();
+    // One pass per trace covers every part
+    Stats xsbench[NUM_EXPERIMENTS], minife[NUM_EXPERIMENTS];
+    if(!runSweep(experiments, NUM_EXPERIMENTS, "TRACES/XSBENCH.t", xsbench, NULL, NULL)) return;
+    if(!runSweep(experiments, NUM_EXPERIMENTS, "TRACES/MINIFE.t", minife, NULL, NULL)) return;
+
+    partA(xsbench, minife);
+    partB(xsbench, minife);
+    partC(xsbench, minife);
+    partD(xsbench, minife);
 }
 
-void partA() {
-    printf("================================= PART A =================================\n"); 
+// Prints the results of experiments[first .. first + count) for both traces
+void printPart(char *title, int first, int count, Stats *xsbench, Stats *minife) {
+    printf("================================= %s =================================\n", title);
     printf("XSBENCH.t\n") ;
-    singleTest(8192, 4, LRU, WRITE_BACK, "TRACES/XSBENCH.t");
-    singleTest(16384, 4, LRU, WRITE_BACK, "TRACES/XSBENCH.t");
-    singleTest(32768, 4, LRU, WRITE_BACK, "TRACES/XSBENCH.t");
-    singleTest(65536, 4, LRU, WRITE_BACK, "TRACES/XSBENCH.t");
-    singleTest(131072, 4, LRU, WRITE_BACK, "TRACES/XSBENCH.t");
+    for(int i = first; i < first + count; i++) printReportStats(experiments[i].cacheSize, experiments[i].associativity, experiments[i].replacementPolicy, experiments[i].writePolicy, "TRACES/XSBENCH.t", &xsbench[i]);
     printf("MINIFE.t\n") ;
-    singleTest(8192, 4, LRU, WRITE_BACK, "TRACES/MINIFE.t");
-    singleTest(16384, 4, LRU, WRITE_BACK, "TRACES/MINIFE.t");
-    singleTest(32768, 4, LRU, WRITE_BACK, "TRACES/MINIFE.t");
-    singleTest(65536, 4, LRU, WRITE_BACK, "TRACES/MINIFE.t");
-    singleTest(131072, 4, LRU, WRITE_BACK, "TRACES/MINIFE.t");
+    for(int i = first; i < first + count; i++) printReportStats(experiments[i].cacheSize, experiments[i].associativity, experiments[i].replacementPolicy, experiments[i].writePolicy, "TRACES/MINIFE.t", &minife[i]);
     printf("\n");
 }
 
-void partB() {
-    printf("================================= PART B =================================\n");
-    printf("XSBENCH.t\n") ;
-    singleTest(8192, 4, LRU, WRITE_THROUGH, "TRACES/XSBENCH.t");
-    singleTest(16384, 4, LRU, WRITE_THROUGH, "TRACES/XSBENCH.t");
-    singleTest(32768, 4, LRU, WRITE_THROUGH, "TRACES/XSBENCH.t");
-    singleTest(65536, 4, LRU, WRITE_THROUGH, "TRACES/XSBENCH.t");
-    singleTest(131072, 4, LRU, WRITE_THROUGH, "TRACES/XSBENCH.t");
-    printf("MINIFE.t\n") ;
-    singleTest(8192, 4, LRU, WRITE_THROUGH, "TRACES/MINIFE.t");
-    singleTest(16384, 4, LRU, WRITE_THROUGH, "TRACES/MINIFE.t");
-    singleTest(32768, 4, LRU, WRITE_THROUGH, "TRACES/MINIFE.t");
-    singleTest(65536, 4, LRU, WRITE_THROUGH, "TRACES/MINIFE.t");
-    singleTest(131072, 4, LRU, WRITE_THROUGH, "TRACES/MINIFE.t");
-    printf("\n");
+void partA(Stats *xsbench, Stats *minife) {
+    printPart("PART A", 0, 5, xsbench, minife);
 }
 
-void partC() {
-    printf("================================= PART C =================================\n"); 
-    printf("XSBENCH.t\n") ;
-    singleTest(32768, 1, LRU, WRITE_BACK, "TRACES/XSBENCH.t");
-    singleTest(32768, 2, LRU, WRITE_BACK, "TRACES/XSBENCH.t");
-    singleTest(32768, 4, LRU, WRITE_BACK, "TRACES/XSBENCH.t");
-    singleTest(32768, 8, LRU, WRITE_BACK, "TRACES/XSBENCH.t");
-    singleTest(32768, 16, LRU, WRITE_BACK, "TRACES/XSBENCH.t");
-    singleTest(32768, 32, LRU, WRITE_BACK, "TRACES/XSBENCH.t");
-    singleTest(32768, 64, LRU, WRITE_BACK, "TRACES/XSBENCH.t");
-    printf("MINIFE.t\n") ;
-    singleTest(32768, 1, LRU, WRITE_BACK, "TRACES/MINIFE.t");
-    singleTest(32768, 2, LRU, WRITE_BACK, "TRACES/MINIFE.t");
-    singleTest(32768, 4, LRU, WRITE_BACK, "TRACES/MINIFE.t");
-    singleTest(32768, 8, LRU, WRITE_BACK, "TRACES/MINIFE.t");
-    singleTest(32768, 16, LRU, WRITE_BACK, "TRACES/MINIFE.t");
-    singleTest(32768, 32, LRU, WRITE_BACK, "TRACES/MINIFE.t");
-    singleTest(32768, 64, LRU, WRITE_BACK, "TRACES/MINIFE.t");
-    printf("\n");
+void partB(Stats *xsbench, Stats *minife) {
+    printPart("PART B", 5, 5, xsbench, minife);
 }
 
-void partD() {
-    printf("================================= PART D =================================\n"); 
-    printf("XSBENCH.t\n") ;
-    singleTest(8192, 4, FIFO, WRITE_BACK, "TRACES/XSBENCH.t");
-    singleTest(16384, 4, FIFO, WRITE_BACK, "TRACES/XSBENCH.t");
-    singleTest(32768, 4, FIFO, WRITE_BACK, "TRACES/XSBENCH.t");
-    singleTest(65536, 4, FIFO, WRITE_BACK, "TRACES/XSBENCH.t");
-    singleTest(131072, 4, FIFO, WRITE_BACK, "TRACES/XSBENCH.t");
-    printf("MINIFE.t\n") ;
-    singleTest(8192, 4, FIFO, WRITE_BACK, "TRACES/MINIFE.t");
-    singleTest(16384, 4, FIFO, WRITE_BACK, "TRACES/MINIFE.t");
-    singleTest(32768, 4, FIFO, WRITE_BACK, "TRACES/MINIFE.t");
-    singleTest(65536, 4, FIFO, WRITE_BACK, "TRACES/MINIFE.t");
-    singleTest(131072, 4, FIFO, WRITE_BACK, "TRACES/MINIFE.t");
-    printf("\n");
+void partC(Stats *xsbench, Stats *minife) {
+    printPart("PART C", 10, 7, xsbench, minife);
+}
+
+void partD(Stats *xsbench, Stats *minife) {
+    printPart("PART D", 17, 5, xsbench, minife);
+}
+
+// Miss ratio of a run, 0 when the trace had no accesses
+double statsMissRatio(Stats *stats) {
+    long long int accesses = stats->hits + stats->misses;
+    return (accesses > 0) ? (double) stats->misses / (double) accesses : 0.0;
 }
 
-void simulationStatistics () {
+void simulationStatistics (Stats *stats) {
     // Outpute desired simualtion stats
-    printf("Miss Ratio: \t%.6f\n", (double) misses / (double) (hits + misses));
-    printf("Writes: \t%d\n", writes);
-    printf("Reads: \t\t%d\n", reads);
+    printf("Miss Ratio: \t%.6f\n", statsMissRatio(stats));
+    printf("Writes: \t%lld\n", stats->writes);
+    printf("Reads: \t\t%lld\n", stats->reads);
 }
@@ -0,0 +1,834 @@
+// Esperandieu Elbon II - UCFID: 5401262
+// EEL4768 Computer Architecture - Suboh Suboh - Fall 2023
+// Implementing a Flexible Cache Simulator
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Vectorized tag match is available on x86 with GCC/Clang; everything else uses the scalar loop
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define SIMD_TAG_MATCH 1
+#endif
+
+// Cache Parameters
+#define BLOCK_SIZE 64
+#define FIFO 1
+#define LRU 0
+#define PLRU 2          // Tree pseudo-LRU, power of two associativity
+#define NRU 3           // Not recently used, one reference bit per way
+#define SRRIP 4         // Static re-reference interval prediction, 2 bit RRPVs
+#define BRRIP 5         // Bimodal RRIP: SRRIP with distant insertion most of the time
+#define DRRIP 6         // Set dueling between SRRIP and BRRIP
+#define RANDOM 7
+#define OPT 8           // Belady: needs each access's next use (see computeNextUse)
+#define NUM_POLICIES 9
+#define WRITE_BACK 1
+#define WRITE_THROUGH 0
+#define WRITE_MIXED 0           // Write misses write memory, then fetch the block clean (the original model)
+#define WRITE_ALLOCATE 1        // Write misses fetch the block and write into it
+#define NO_WRITE_ALLOCATE 2     // Write misses only write memory
+#define INDEX_MODULO 0          // Set = block address mod sets (a mask for power of two set counts)
+#define INDEX_XOR 1             // Set = block address XOR-folded with its next two index-width slices
+#define MIN_BLOCK_SIZE 16
+#define MAX_BLOCK_SIZE 256
+#define HIT 1
+#define MISS 0
+#define PREFETCHED_HIT 2        // First demand hit on a prefetched line, as reported to prefetchers
+#define DIRTY 1
+#define INVALID_TAG (~0ULL)     // Marks an empty way; never produced by address >> blockShift
+#define INVALID_AGE 0xFFFF      // Age of an empty way, older than any valid block
+#define NEVER_USED (~0ULL)      // Next use of a block that isn't accessed again
+#define RRPV_MAX 3
+#define BRRIP_EPSILON 32        // BRRIP inserts at RRPV_MAX - 1 once every this many fills
+#define PSEL_MAX 1023           // 10 bit DRRIP policy selector
+#define DUEL_LEADERS 32         // Leader sets per DRRIP component
+#define PREFETCH_LATE_WINDOW 16 // Prefetches used within this many accesses of issue count as late
+#define POLLUTION_FILTER 4096   // Direct-mapped filter of lines evicted by prefetches, power of 2
+
+// Cache Statistics
+typedef struct Stats Stats;
+struct Stats {
+    long long int hits, misses, reads, writes;
+};
+
+// Per-set counters, for finding conflict-hot sets
+typedef struct SetStats SetStats;
+struct SetStats {
+    long long int hits, misses, evictions;
+};
+
+// Prefetch Statistics. Without a timing model, lateness is approximated by how soon after issue
+// a prefetched line is first used, and pollution by demand misses on lines a prefetch evicted
+typedef struct PrefetchStats PrefetchStats;
+struct PrefetchStats {
+    long long int issued;       // Prefetch fills (lines not already cached)
+    long long int useful;       // Prefetched lines hit by a demand access
+    long long int late;         // Useful prefetches used within PREFETCH_LATE_WINDOW accesses
+    long long int distance;     // Sum of issue-to-first-use distances of useful prefetches, in accesses
+    long long int unused;       // Prefetched lines evicted without a demand hit
+    long long int pollution;    // Demand misses on lines a prefetch had evicted
+};
+
+// Replacement Policy
+// Hooks run on a hit, after a miss fills a way, and to pick the victim of a full set (empty
+// ways are always filled first). setLocal policies only touch the accessed set, so sets can be
+// simulated independently; the others share a selector or random state across sets.
+typedef struct Cache Cache;
+typedef struct ReplacementPolicy ReplacementPolicy;
+struct ReplacementPolicy {
+    char *name;
+    void (*hit)(int setNumber, int way, Cache *cache);
+    void (*fill)(int setNumber, int way, Cache *cache);
+    int (*victim)(int setNumber, Cache *cache);
+    int setLocal;
+};
+
+// Cache
+// Ways are stored structure-of-arrays: way w of set s lives at index s * associativity + w in
+// each array, so a set's tags are contiguous and nothing is allocated after createCache().
+// LRU and FIFO track recency with per-way ages: 0 is the most recently used (LRU) or inserted
+// (FIFO) block and the oldest valid block in a full set has age associativity - 1. Empty ways
+// hold INVALID_AGE so the age updates need no separate valid check. The other policies keep
+// their per-way state (RRPVs, reference bits, PLRU tree nodes) in state.
+// Tags are whole block addresses, so any index function is safe. Power of two set counts index
+// with setMask; other counts fall back to a modulo.
+struct Cache {
+    int associativty, numberOfSets, replacementPolicy, writePolicy; // Cache properties
+    int blockSize, blockShift, allocation, indexing;
+    int indexBits;                  // Bits needed to name a set (XOR folding width)
+    int powerOfTwoSets;
+    unsigned long long int setMask; // numberOfSets - 1 when powerOfTwoSets
+    unsigned long long int *tags;   // Tag array, INVALID_TAG when the way is empty
+    unsigned char *dirty;           // Dirty bit per way
+    unsigned short *age;            // Recency/insertion age per way, INVALID_AGE when empty
+    unsigned short *size;           // Valid ways per set
+    ReplacementPolicy *policy;      // Hooks for replacementPolicy
+    unsigned char *state;           // Per-way policy state (per-set tree nodes for PLRU)
+    unsigned long long int *nextUse;    // OPT: next use of each way's block
+    unsigned long long int upcoming;    // OPT: next use of the block being accessed, set by the caller
+    int psel;                       // DRRIP policy selector
+    unsigned int seed;              // BRRIP/DRRIP/RANDOM generator state
+    Stats stats;                    // Access counters for this cache
+
+    // Prefetching (all NULL/0 unless a prefetcher is attached, see prefetch.h)
+    void (*prefetch)(unsigned long long int block, int result, Cache *cache);   // Called after each demand access
+    void *prefetcher;               // Prefetcher state, one allocation
+    unsigned char *prefetched;      // Per-way: filled by a prefetch and not yet used
+    unsigned long long int *issuedAt;   // Per-way: clock of the prefetch fill
+    unsigned long long int *evicted;    // Pollution filter of lines evicted by prefetch fills
+    unsigned long long int clock;   // Demand accesses seen
+    PrefetchStats prefetchStats;
+
+    // Recording (NULL/0 unless enabled, see record.h)
+    SetStats *setStats;             // Per-set counters
+    Stats *intervals;               // Cumulative counters at the end of each completed interval
+    int intervalCount, intervalCapacity;
+    long long int intervalLength, intervalClock;    // Demand accesses per interval, and so far in this one
+};
+
+// Tag Match Functions
+// Each returns the index of the first key in keys[0 .. ways), or -1. Tags within a set are
+// unique, and so are the ages of valid ways, which is how the victim is found.
+int matchTags_scalar(const unsigned long long int *tags, int ways, unsigned long long int tag);
+int matchAges_scalar(const unsigned short *ages, int ways, unsigned short age);
+#ifdef SIMD_TAG_MATCH
+int matchTags_sse42(const unsigned long long int *tags, int ways, unsigned long long int tag) __attribute__((target("sse4.2")));
+int matchTags_avx2(const unsigned long long int *tags, int ways, unsigned long long int tag) __attribute__((target("avx2")));
+int matchAges_sse42(const unsigned short *ages, int ways, unsigned short age) __attribute__((target("sse4.2")));
+int matchAges_avx2(const unsigned short *ages, int ways, unsigned short age) __attribute__((target("avx2")));
+#endif
+int (*matchTags)(const unsigned long long int *tags, int ways, unsigned long long int tag) = NULL;
+int (*matchAges)(const unsigned short *ages, int ways, unsigned short age) = NULL;
+
+// Age Functions: every age below limit is incremented (empty ways hold INVALID_AGE and are never below)
+void olderAges_scalar(unsigned short *ages, int ways, unsigned short limit);
+#ifdef SIMD_TAG_MATCH
+void olderAges_sse42(unsigned short *ages, int ways, unsigned short limit) __attribute__((target("sse4.2")));
+void olderAges_avx2(unsigned short *ages, int ways, unsigned short limit) __attribute__((target("avx2")));
+#endif
+void (*olderAges)(unsigned short *ages, int ways, unsigned short limit) = NULL;
+void selectTagMatch();
+
+// Set Functions
+int searchSet(unsigned long long int tag, int setNumber, Cache *cache);
+int findVictim(int setNumber, Cache *cache);
+void promoteWay(int setNumber, int way, int oldAge, Cache *cache);
+void fillWay(unsigned long long int tag, int setNumber, int way, Cache *cache);
+void invalidateWay(int setNumber, int way, Cache *cache);
+
+// Replacement Policy Functions
+int validPolicy(int replacementPolicy, int associativity);
+unsigned int nextRandom(Cache *cache);
+void ageHit(int setNumber, int way, Cache *cache);
+void ageFill(int setNumber, int way, Cache *cache);
+int ageVictim(int setNumber, Cache *cache);
+void plruTouch(int setNumber, int way, Cache *cache);
+int plruVictim(int setNumber, Cache *cache);
+void nruTouch(int setNumber, int way, Cache *cache);
+int nruVictim(int setNumber, Cache *cache);
+void rripHit(int setNumber, int way, Cache *cache);
+void srripFill(int setNumber, int way, Cache *cache);
+void brripFill(int setNumber, int way, Cache *cache);
+void drripFill(int setNumber, int way, Cache *cache);
+int rripVictim(int setNumber, Cache *cache);
+int randomVictim(int setNumber, Cache *cache);
+void optTouch(int setNumber, int way, Cache *cache);
+int optVictim(int setNumber, Cache *cache);
+void noTouch(int setNumber, int way, Cache *cache);
+unsigned long long int *computeNextUse(unsigned long long int *blocks, long long int count);
+
+// Cache Functions
+Cache *createCache(int associativity, int numberOfSets, int replacementPolicy, int writePolicy);
+Cache *createCacheExtended(int associativity, int numberOfSets, int replacementPolicy, int writePolicy, int blockSize, int allocation, int indexing);
+int validBlockSize(int blockSize);
+int blockShiftOf(int blockSize);
+int indexSet(unsigned long long int block, Cache *cache);
+void simulateCacheAccess(char operation, unsigned long long int address, Cache *cache);
+int accessCacheSet(char operation, unsigned long long int tag, int setNumber, Cache *cache, Stats *stats);
+void prefetchBlock(unsigned long long int block, Cache *cache);
+void closeInterval(Cache *cache);
+void addStats(Stats *from, Stats *into);
+void clearCache(Cache *cache);
+void displayCache(Cache *cache);
+
+// Linear scan, used for low associativity and on targets without SIMD support
+int matchTags_scalar(const unsigned long long int *tags, int ways, unsigned long long int tag) {
+    for(int way = 0; way < ways; way++) {
+        if(tags[way] == tag) return way;
+    }
+    return -1;
+}
+
+int matchAges_scalar(const unsigned short *ages, int ways, unsigned short age) {
+    for(int way = 0; way < ways; way++) {
+        if(ages[way] == age) return way;
+    }
+    return -1;
+}
+
+void olderAges_scalar(unsigned short *ages, int ways, unsigned short limit) {
+    for(int way = 0; way < ways; way++) ages[way] += (unsigned short) (ages[way] < limit);
+}
+
+#ifdef SIMD_TAG_MATCH
+// Compares two tags per instruction
+int matchTags_sse42(const unsigned long long int *tags, int ways, unsigned long long int tag) {
+    __m128i key = _mm_set1_epi64x((long long int) tag);
+    int way = 0;
+    for(; way + 4 <= ways; way += 4) {
+        __m128i lo = _mm_cmpeq_epi64(_mm_loadu_si128((const __m128i *) (tags + way)), key);
+        __m128i hi = _mm_cmpeq_epi64(_mm_loadu_si128((const __m128i *) (tags + way + 2)), key);
+        int mask = _mm_movemask_pd(_mm_castsi128_pd(lo)) | (_mm_movemask_pd(_mm_castsi128_pd(hi)) << 2);
+        if(mask) return way + __builtin_ctz(mask);
+    }
+    for(; way < ways; way++) {
+        if(tags[way] == tag) return way;
+    }
+    return -1;
+}
+
+// Compares four tags per instruction, eight per iteration
+int matchTags_avx2(const unsigned long long int *tags, int ways, unsigned long long int tag) {
+    __m256i key = _mm256_set1_epi64x((long long int) tag);
+    int way = 0;
+    for(; way + 8 <= ways; way += 8) {
+        __m256i lo = _mm256_cmpeq_epi64(_mm256_loadu_si256((const __m256i *) (tags + way)), key);
+        __m256i hi = _mm256_cmpeq_epi64(_mm256_loadu_si256((const __m256i *) (tags + way + 4)), key);
+        int mask = _mm256_movemask_pd(_mm256_castsi256_pd(lo)) | (_mm256_movemask_pd(_mm256_castsi256_pd(hi)) << 4);
+        if(mask) return way + __builtin_ctz(mask);
+    }
+    if(way + 4 <= ways) {
+        int mask = _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpeq_epi64(_mm256_loadu_si256((const __m256i *) (tags + way)), key)));
+        if(mask) return way + __builtin_ctz(mask);
+        way += 4;
+    }
+    for(; way < ways; way++) {
+        if(tags[way] == tag) return way;
+    }
+    return -1;
+}
+
+// Compares eight ages per instruction
+int matchAges_sse42(const unsigned short *ages, int ways, unsigned short age) {
+    __m128i key = _mm_set1_epi16((short) age);
+    int way = 0;
+    for(; way + 8 <= ways; way += 8) {
+        int mask = _mm_movemask_epi8(_mm_cmpeq_epi16(_mm_loadu_si128((const __m128i *) (ages + way)), key));
+        if(mask) return way + __builtin_ctz(mask) / 2;
+    }
+    for(; way < ways; way++) {
+        if(ages[way] == age) return way;
+    }
+    return -1;
+}
+
+// Compares sixteen ages per instruction
+int matchAges_avx2(const unsigned short *ages, int ways, unsigned short age) {
+    __m256i key = _mm256_set1_epi16((short) age);
+    int way = 0;
+    for(; way + 16 <= ways; way += 16) {
+        int mask = _mm256_movemask_epi8(_mm256_cmpeq_epi16(_mm256_loadu_si256((const __m256i *) (ages + way)), key));
+        if(mask) return way + __builtin_ctz(mask) / 2;
+    }
+    for(; way < ways; way++) {
+        if(ages[way] == age) return way;
+    }
+    return -1;
+}
+
+// Ages eight ways per instruction. Unsigned a < limit is min(a, limit - 1) == a
+void olderAges_sse42(unsigned short *ages, int ways, unsigned short limit) {
+    if(limit == 0) return;
+    __m128i bound = _mm_set1_epi16((short) (limit - 1));
+    int way = 0;
+    for(; way + 8 <= ways; way += 8) {
+        __m128i a = _mm_loadu_si128((const __m128i *) (ages + way));
+        __m128i younger = _mm_cmpeq_epi16(_mm_min_epu16(a, bound), a);
+        _mm_storeu_si128((__m128i *) (ages + way), _mm_sub_epi16(a, younger));
+    }
+    for(; way < ways; way++) ages[way] += (unsigned short) (ages[way] < limit);
+}
+
+// Ages sixteen ways per instruction
+void olderAges_avx2(unsigned short *ages, int ways, unsigned short limit) {
+    if(limit == 0) return;
+    __m256i bound = _mm256_set1_epi16((short) (limit - 1));
+    int way = 0;
+    for(; way + 16 <= ways; way += 16) {
+        __m256i a = _mm256_loadu_si256((const __m256i *) (ages + way));
+        __m256i younger = _mm256_cmpeq_epi16(_mm256_min_epu16(a, bound), a);
+        _mm256_storeu_si256((__m256i *) (ages + way), _mm256_sub_epi16(a, younger));
+    }
+    for(; way < ways; way++) ages[way] += (unsigned short) (ages[way] < limit);
+}
+#endif
+
+// Picks the widest tag match the CPU supports. SIM_TAG_MATCH=scalar|sse42|avx2 overrides the choice
+void selectTagMatch() {
+    char *forced = getenv("SIM_TAG_MATCH");
+    matchTags = matchTags_scalar;
+    matchAges = matchAges_scalar;
+    olderAges = olderAges_scalar;
+#ifdef SIMD_TAG_MATCH
+    __builtin_cpu_init();
+    int avx2 = __builtin_cpu_supports("avx2"), sse42 = __builtin_cpu_supports("sse4.2");
+    if(forced != NULL) {
+        avx2 = avx2 && strcmp(forced, "avx2") == 0;
+        sse42 = sse42 && strcmp(forced, "sse42") == 0;
+    }
+    if(avx2) {
+        matchTags = matchTags_avx2;
+        matchAges = matchAges_avx2;
+        olderAges = olderAges_avx2;
+    }
+    else if(sse42) {
+        matchTags = matchTags_sse42;
+        matchAges = matchAges_sse42;
+        olderAges = olderAges_sse42;
+    }
+#else
+    (void) forced;
+#endif
+}
+
+// Policy table, indexed by replacementPolicy. LRU and FIFO share the age machinery: LRU
+// promotes on hits, FIFO only on fills
+ReplacementPolicy replacementPolicies[NUM_POLICIES] = {
+    {"LRU", ageHit, ageFill, ageVictim, 1},
+    {"FIFO", noTouch, ageFill, ageVictim, 1},
+    {"PLRU", plruTouch, plruTouch, plruVictim, 1},
+    {"NRU", nruTouch, nruTouch, nruVictim, 1},
+    {"SRRIP", rripHit, srripFill, rripVictim, 1},
+    {"BRRIP", rripHit, brripFill, rripVictim, 0},
+    {"DRRIP", rripHit, drripFill, rripVictim, 0},
+    {"RANDOM", noTouch, noTouch, randomVictim, 0},
+    {"OPT", optTouch, optTouch, optVictim, 0}
+};
+
+// Returns 1 if the policy exists and supports the associativity (PLRU needs a power of two)
+int validPolicy(int replacementPolicy, int associativity) {
+    if(replacementPolicy < 0 || replacementPolicy >= NUM_POLICIES) return 0;
+    return replacementPolicy != PLRU || (associativity & (associativity - 1)) == 0;
+}
+
+// xorshift32, deterministic per cache
+unsigned int nextRandom(Cache *cache) {
+    cache->seed ^= cache->seed << 13;
+    cache->seed ^= cache->seed >> 17;
+    cache->seed ^= cache->seed << 5;
+    return cache->seed;
+}
+
+void noTouch(int setNumber, int way, Cache *cache) {
+    (void) setNumber;
+    (void) way;
+    (void) cache;
+}
+
+// LRU hit: the way becomes the newest
+void ageHit(int setNumber, int way, Cache *cache) {
+    promoteWay(setNumber, way, cache->age[(size_t) setNumber * cache->associativty + way], cache);
+}
+
+// Fill: the way becomes the newest. It still holds its previous age, INVALID_AGE if it was empty
+void ageFill(int setNumber, int way, Cache *cache) {
+    size_t index = (size_t) setNumber * cache->associativty + way;
+    promoteWay(setNumber, way, cache->age[index], cache);
+}
+
+// The oldest block of a full set
+int ageVictim(int setNumber, Cache *cache) {
+    unsigned short *age = cache->age + (size_t) setNumber * cache->associativty;
+    unsigned short oldest = cache->associativty - 1;
+    int way = (cache->associativty < 8) ? matchAges_scalar(age, cache->associativty, oldest) : matchAges(age, cache->associativty, oldest);
+    return (way < 0) ? 0 : way;
+}
+
+// Tree PLRU: node n (1 .. associativity - 1, heap order) points toward the less recently used
+// half below it, 0 = left. An access points every node on the way's path away from it
+void plruTouch(int setNumber, int way, Cache *cache) {
+    unsigned char *tree = cache->state + (size_t) setNumber * cache->associativty;
+    int node = 1;
+    for(int half = cache->associativty >> 1; half > 0; half >>= 1) {
+        int right = (way & half) != 0;
+        tree[node] = (unsigned char) !right;
+        node = 2 * node + right;
+    }
+}
+
+int plruVictim(int setNumber, Cache *cache) {
+    unsigned char *tree = cache->state + (size_t) setNumber * cache->associativty;
+    int node = 1, way = 0;
+    for(int half = cache->associativty >> 1; half > 0; half >>= 1) {
+        way = 2 * way + tree[node];
+        node = 2 * node + tree[node];
+    }
+    return way;
+}
+
+// NRU: set the way's reference bit; once every bit is set, clear all the others
+void nruTouch(int setNumber, int way, Cache *cache) {
+    unsigned char *referenced = cache->state + (size_t) setNumber * cache->associativty;
+    referenced[way] = 1;
+    for(int i = 0; i < cache->associativty; i++) {
+        if(!referenced[i]) return;
+    }
+    memset(referenced, 0, cache->associativty);
+    referenced[way] = 1;
+}
+
+// First way not referenced since the last clear
+int nruVictim(int setNumber, Cache *cache) {
+    unsigned char *referenced = cache->state + (size_t) setNumber * cache->associativty;
+    for(int i = 0; i < cache->associativty; i++) {
+        if(!referenced[i]) return i;
+    }
+    return 0;
+}
+
+// RRIP hit promotion: predicted near-immediate re-reference
+void rripHit(int setNumber, int way, Cache *cache) {
+    cache->state[(size_t) setNumber * cache->associativty + way] = 0;
+}
+
+// SRRIP inserts with a long re-reference interval
+void srripFill(int setNumber, int way, Cache *cache) {
+    cache->state[(size_t) setNumber * cache->associativty + way] = RRPV_MAX - 1;
+}
+
+// BRRIP inserts with a distant interval, and a long one once every BRRIP_EPSILON fills
+void brripFill(int setNumber, int way, Cache *cache) {
+    cache->state[(size_t) setNumber * cache->associativty + way] = (nextRandom(cache) % BRRIP_EPSILON == 0) ? RRPV_MAX - 1 : RRPV_MAX;
+}
+
+// DRRIP: the first set of every group is an SRRIP leader and the second a BRRIP leader, with
+// up to DUEL_LEADERS groups of at least 8 sets, so small caches keep follower sets. Misses
+// (fills) in leader sets move the selector toward the other policy and follower sets insert
+// with whichever policy is missing less
+void drripFill(int setNumber, int way, Cache *cache) {
+    int leaders = cache->numberOfSets / 8;
+    if(leaders > DUEL_LEADERS) leaders = DUEL_LEADERS;
+    if(leaders < 1) leaders = 1;
+    int group = cache->numberOfSets / leaders;
+    if(group < 2) group = 2;
+    int member = setNumber % group;
+    if(member == 0 && cache->psel < PSEL_MAX) cache->psel++;
+    else if(member == 1 && cache->psel > 0) cache->psel--;
+
+    int brrip = (member == 1) || (member != 0 && cache->psel > PSEL_MAX / 2);
+    if(brrip) brripFill(setNumber, way, cache);
+    else srripFill(setNumber, way, cache);
+}
+
+// First way predicted for a distant re-reference, aging the set until one is
+int rripVictim(int setNumber, Cache *cache) {
+    unsigned char *rrpv = cache->state + (size_t) setNumber * cache->associativty;
+    int oldest = 0;
+    for(int i = 0; i < cache->associativty; i++) {
+        if(rrpv[i] == RRPV_MAX) return i;
+        if(rrpv[i] > rrpv[oldest]) oldest = i;
+    }
+    int step = RRPV_MAX - rrpv[oldest];
+    for(int i = 0; i < cache->associativty; i++) rrpv[i] += step;
+    return oldest;
+}
+
+int randomVictim(int setNumber, Cache *cache) {
+    (void) setNumber;
+    return (int) (nextRandom(cache) % (unsigned int) cache->associativty);
+}
+
+// OPT: remember when the way's block is next used
+void optTouch(int setNumber, int way, Cache *cache) {
+    cache->nextUse[(size_t) setNumber * cache->associativty + way] = cache->upcoming;
+}
+
+// The block used furthest in the future (or never again)
+int optVictim(int setNumber, Cache *cache) {
+    unsigned long long int *nextUse = cache->nextUse + (size_t) setNumber * cache->associativty;
+    int victim = 0;
+    for(int i = 1; i < cache->associativty; i++) {
+        if(nextUse[i] > nextUse[victim]) victim = i;
+    }
+    return victim;
+}
+
+// For each access i of a block sequence, the index of the next access to the same block, or
+// NEVER_USED. One backward pass with an open-addressed table of the latest index seen per block
+unsigned long long int *computeNextUse(unsigned long long int *blocks, long long int count) {
+    unsigned long long int *nextUse = (unsigned long long int *) malloc((count > 0 ? count : 1) * sizeof(unsigned long long int));
+    size_t capacity = 1024;
+    while(capacity < (size_t) count * 2) capacity *= 2;
+    unsigned long long int *keys = (unsigned long long int *) malloc(capacity * sizeof(unsigned long long int));
+    unsigned long long int *seen = (unsigned long long int *) malloc(capacity * sizeof(unsigned long long int));
+    for(size_t i = 0; i < capacity; i++) keys[i] = INVALID_TAG;
+
+    for(long long int i = count - 1; i >= 0; i--) {
+        size_t slot = (size_t) ((blocks[i] * 0x9E3779B97F4A7C15ULL) >> 20) & (capacity - 1);
+        while(keys[slot] != INVALID_TAG && keys[slot] != blocks[i]) slot = (slot + 1) & (capacity - 1);
+        nextUse[i] = (keys[slot] == blocks[i]) ? seen[slot] : NEVER_USED;
+        keys[slot] = blocks[i];
+        seen[slot] = (unsigned long long int) i;
+    }
+    free(keys);
+    free(seen);
+    return nextUse;
+}
+
+// Create a cache of 64B blocks, mixed write allocation and modulo indexing with every way empty
+Cache *createCache(int associativity, int numberOfSets, int replacementPolicy, int writePolicy) {
+    return createCacheExtended(associativity, numberOfSets, replacementPolicy, writePolicy, BLOCK_SIZE, WRITE_MIXED, INDEX_MODULO);
+}
+
+// Returns 1 for the supported power of two block sizes
+int validBlockSize(int blockSize) {
+    return blockSize >= MIN_BLOCK_SIZE && blockSize <= MAX_BLOCK_SIZE && (blockSize & (blockSize - 1)) == 0;
+}
+
+// log2 of a power of two block size
+int blockShiftOf(int blockSize) {
+    int shift = 0;
+    while((1 << shift) < blockSize) shift++;
+    return shift;
+}
+
+// Create a cache with every way empty
+Cache *createCacheExtended(int associativity, int numberOfSets, int replacementPolicy, int writePolicy, int blockSize, int allocation, int indexing) {
+    if(matchTags == NULL) selectTagMatch();
+    Cache *newCache = (Cache *) malloc(sizeof(Cache));
+    size_t ways = (size_t) associativity * numberOfSets;
+
+    // Initialize the way arrays
+    newCache->tags = (unsigned long long int *) malloc(ways * sizeof(unsigned long long int));
+    for(size_t i = 0; i < ways; i++) newCache->tags[i] = INVALID_TAG;
+    newCache->dirty = (unsigned char *) calloc(ways, sizeof(unsigned char));
+    newCache->age = (unsigned short *) malloc(ways * sizeof(unsigned short));
+    for(size_t i = 0; i < ways; i++) newCache->age[i] = INVALID_AGE;
+    newCache->size = (unsigned short *) calloc(numberOfSets, sizeof(unsigned short));
+
+    // Policy state: every RRPV starts distant, every other policy starts at zero
+    newCache->policy = &replacementPolicies[replacementPolicy];
+    newCache->state = (unsigned char *) malloc(ways);
+    memset(newCache->state, (replacementPolicy == SRRIP || replacementPolicy == BRRIP || replacementPolicy == DRRIP) ? RRPV_MAX : 0, ways);
+    newCache->nextUse = (replacementPolicy == OPT) ? (unsigned long long int *) malloc(ways * sizeof(unsigned long long int)) : NULL;
+    newCache->upcoming = NEVER_USED;
+    newCache->psel = PSEL_MAX / 2 + 1;
+    newCache->seed = 2463534242u;
+    newCache->prefetch = NULL;
+    newCache->prefetcher = NULL;
+    newCache->prefetched = NULL;
+    newCache->issuedAt = NULL;
+    newCache->evicted = NULL;
+    newCache->clock = 0;
+    memset(&newCache->prefetchStats, 0, sizeof(PrefetchStats));
+    newCache->setStats = NULL;
+    newCache->intervals = NULL;
+    newCache->intervalCount = newCache->intervalCapacity = 0;
+    newCache->intervalLength = newCache->intervalClock = 0;
+
+    // Initialize the rest of the cache members
+    newCache->associativty = associativity;
+    newCache->numberOfSets = numberOfSets;
+    newCache->replacementPolicy = replacementPolicy;
+    newCache->writePolicy = writePolicy;
+    newCache->blockSize = blockSize;
+    newCache->blockShift = blockShiftOf(blockSize);
+    newCache->allocation = allocation;
+    newCache->indexing = indexing;
+    newCache->indexBits = 1;
+    while((1LL << newCache->indexBits) < numberOfSets) newCache->indexBits++;
+    newCache->powerOfTwoSets = (numberOfSets & (numberOfSets - 1)) == 0;
+    newCache->setMask = (unsigned long long int) numberOfSets - 1;
+    newCache->stats.hits = newCache->stats.misses = newCache->stats.reads = newCache->stats.writes = 0;
+    return newCache;
+}
+
+// Returns the way holding the tag in the indicated set, or -1 if it isn't cached.
+// Sets narrower than a vector aren't worth the indirect call and use the scalar loop.
+int searchSet(unsigned long long int tag, int setNumber, Cache *cache) {
+    unsigned long long int *tags = cache->tags + (size_t) setNumber * cache->associativty;
+    if(cache->associativty < 4) return matchTags_scalar(tags, cache->associativty, tag);
+    return matchTags(tags, cache->associativty, tag);
+}
+
+// Returns the way to fill on a miss: an empty way if the set isn't full, otherwise the policy's victim
+int findVictim(int setNumber, Cache *cache) {
+    if(cache->size[setNumber] < cache->associativty) {
+        int way = searchSet(INVALID_TAG, setNumber, cache);
+        return (way < 0) ? 0 : way;
+    }
+    return cache->policy->victim(setNumber, cache);
+}
+
+// Makes a way the newest in its set: every valid way younger than oldAge ages by one
+void promoteWay(int setNumber, int way, int oldAge, Cache *cache) {
+    size_t base = (size_t) setNumber * cache->associativty;
+    unsigned short *age = cache->age + base;
+    if(cache->associativty < 8) olderAges_scalar(age, cache->associativty, (unsigned short) oldAge);
+    else olderAges(age, cache->associativty, (unsigned short) oldAge);
+    age[way] = 0;
+}
+
+// Places a clean block in the indicated way and lets the policy record the insertion
+void fillWay(unsigned long long int tag, int setNumber, int way, Cache *cache) {
+    size_t index = (size_t) setNumber * cache->associativty + way;
+    if(cache->tags[index] == INVALID_TAG) cache->size[setNumber]++;
+
+    cache->tags[index] = tag;
+    cache->dirty[index] = 0;
+    cache->policy->fill(setNumber, way, cache);
+}
+
+// Empties a valid way. Under LRU/FIFO every block older than it moves one step younger so ages
+// stay dense; the other policies never look at an empty way's state
+void invalidateWay(int setNumber, int way, Cache *cache) {
+    size_t base = (size_t) setNumber * cache->associativty;
+    unsigned short *age = cache->age + base;
+    unsigned short oldAge = age[way];
+    for(int i = 0; i < cache->associativty && cache->replacementPolicy <= FIFO; i++) {
+        if(age[i] != INVALID_AGE && age[i] > oldAge) age[i]--;
+    }
+    cache->tags[base + way] = INVALID_TAG;
+    cache->dirty[base + way] = 0;
+    age[way] = INVALID_AGE;
+    cache->size[setNumber]--;
+}
+
+// Set of a block address under the cache's index function
+int indexSet(unsigned long long int block, Cache *cache) {
+    if(cache->indexing == INDEX_XOR) block ^= (block >> cache->indexBits) ^ (block >> 2 * cache->indexBits);
+    if(cache->powerOfTwoSets) return (int) (block & cache->setMask);
+    return (int) (block % cache->numberOfSets);
+}
+
+void simulateCacheAccess(char operation, unsigned long long int address, Cache *cache) {
+    // Calculate the set number/cache index and tag of the indicated address
+    unsigned long long int tag = address >> cache->blockShift;
+    int setNumber = indexSet(tag, cache);
+    if(cache->prefetch == NULL) accessCacheSet(operation, tag, setNumber, cache, &cache->stats);
+    else {
+        // Let the prefetcher observe the demand access and issue its prefetches
+        long long int useful = cache->prefetchStats.useful;
+        int result = accessCacheSet(operation, tag, setNumber, cache, &cache->stats);
+        if(cache->prefetchStats.useful != useful) result = PREFETCHED_HIT;
+        cache->clock++;
+        cache->prefetch(tag, result, cache);
+    }
+    if(cache->intervalLength > 0 && ++cache->intervalClock == cache->intervalLength) closeInterval(cache);
+}
+
+// Snapshots the counters at the end of an interval
+void closeInterval(Cache *cache) {
+    if(cache->intervalCount == cache->intervalCapacity) {
+        cache->intervalCapacity = (cache->intervalCapacity == 0) ? 64 : 2 * cache->intervalCapacity;
+        cache->intervals = (Stats *) realloc(cache->intervals, cache->intervalCapacity * sizeof(Stats));
+    }
+    cache->intervals[cache->intervalCount++] = cache->stats;
+    cache->intervalClock = 0;
+}
+
+// Simulates one access to an already indexed set, counting into stats. Only the indicated set
+// is read or written, so callers may run disjoint sets of one cache on different threads.
+// Returns HIT or MISS
+int accessCacheSet(char operation, unsigned long long int tag, int setNumber, Cache *cache, Stats *stats) {
+    size_t base = (size_t) setNumber * cache->associativty;
+
+    // Search for address
+    int way = searchSet(tag, setNumber, cache);
+
+    // Hit
+    if(way >= 0) {
+        if(cache->setStats != NULL) cache->setStats[setNumber].hits++;
+
+        // First demand use of a prefetched line
+        if(cache->prefetched != NULL && cache->prefetched[base + way]) {
+            unsigned long long int distance = cache->clock - cache->issuedAt[base + way];
+            cache->prefetchStats.useful++;
+            cache->prefetchStats.distance += distance;
+            if(distance < PREFETCH_LATE_WINDOW) cache->prefetchStats.late++;
+            cache->prefetched[base + way] = 0;
+        }
+
+        // Increment hit counter. Increment writes on write hit and write throuh
+        if(operation == 'W' && cache->writePolicy == WRITE_THROUGH) stats->writes++;
+        stats->hits++;
+
+        // LRU moves the block to the top of the set. Under the original mixed write model the
+        // block is treated as re-inserted, as the original linked-list model did: it only stays
+        // dirty when this access is a write back write and the set holds other blocks. Kept so
+        // reported write counts are unchanged.
+        if(cache->replacementPolicy == LRU && cache->allocation == WRITE_MIXED) {
+            cache->dirty[base + way] = operation == 'W' && cache->writePolicy == WRITE_BACK && cache->size[setNumber] > 1;
+            promoteWay(setNumber, way, cache->age[base + way], cache);
+        }
+
+        // FIFO leaves the order alone, the other policies (and LRU under the explicit allocation
+        // models) update their own state. Mark block as dirty if Write and Write Back
+        else {
+            cache->policy->hit(setNumber, way, cache);
+            if(operation == 'W' && cache->writePolicy == WRITE_BACK) cache->dirty[base + way] = DIRTY;
+        }
+    }
+    // Miss
+    else {
+        // Increment misses
+        stats->misses++;
+        if(cache->setStats != NULL) cache->setStats[setNumber].misses++;
+
+        // A miss on a line a prefetch pushed out is pollution
+        if(cache->evicted != NULL && cache->evicted[tag & (POLLUTION_FILTER - 1)] == tag) {
+            cache->prefetchStats.pollution++;
+            cache->evicted[tag & (POLLUTION_FILTER - 1)] = INVALID_TAG;
+        }
+
+        // Write miss. Write to memory.
+        // Assuming from tests and sample input: a mixed Write allocate/no allocate policy
+        // This means that we write to main memeory first then
+        // We load the block into memory via a read
+        if(operation == 'W' && cache->allocation == WRITE_MIXED) {
+            stats->writes++;
+            stats->reads++;
+        }
+
+        // No write allocate: the write goes to memory and the block isn't cached
+        else if(operation == 'W' && cache->allocation == NO_WRITE_ALLOCATE) {
+            stats->writes++;
+            return MISS;
+        }
+
+        // Write allocate: fetch the block and write into it (through to memory if write through)
+        else if(operation == 'W') {
+            stats->reads++;
+            if(cache->writePolicy == WRITE_THROUGH) stats->writes++;
+        }
+
+        // Read miss, fetch from memory
+        else if(operation == 'R') stats->reads++;
+
+        // Evict the policy's victim when the set is full, writing it back if dirty
+        way = findVictim(setNumber, cache);
+        if(cache->tags[base + way] != INVALID_TAG && cache->writePolicy == WRITE_BACK && cache->dirty[base + way] == DIRTY) stats->writes++;
+        if(cache->setStats != NULL && cache->tags[base + way] != INVALID_TAG) cache->setStats[setNumber].evictions++;
+        if(cache->prefetched != NULL && cache->tags[base + way] != INVALID_TAG && cache->prefetched[base + way]) {
+            cache->prefetchStats.unused++;
+            cache->prefetched[base + way] = 0;
+        }
+        fillWay(tag, setNumber, way, cache);
+        if(operation == 'W' && cache->allocation == WRITE_ALLOCATE && cache->writePolicy == WRITE_BACK) cache->dirty[base + way] = DIRTY;
+        return MISS;
+    }
+    return HIT;
+}
+
+// Fills a line on behalf of the prefetcher unless it is already cached. The fill reads memory
+// like a demand miss, and a demand line it evicts is remembered in the pollution filter
+void prefetchBlock(unsigned long long int block, Cache *cache) {
+    int setNumber = indexSet(block, cache);
+    if(searchSet(block, setNumber, cache) >= 0) return;
+
+    int way = findVictim(setNumber, cache);
+    size_t index = (size_t) setNumber * cache->associativty + way;
+    unsigned long long int victim = cache->tags[index];
+    if(victim != INVALID_TAG) {
+        if(cache->writePolicy == WRITE_BACK && cache->dirty[index] == DIRTY) cache->stats.writes++;
+        if(cache->setStats != NULL) cache->setStats[setNumber].evictions++;
+        if(cache->prefetched[index]) cache->prefetchStats.unused++;
+        else cache->evicted[victim & (POLLUTION_FILTER - 1)] = victim;
+    }
+    fillWay(block, setNumber, way, cache);
+    cache->prefetched[index] = 1;
+    cache->issuedAt[index] = cache->clock;
+    cache->stats.reads++;
+    cache->prefetchStats.issued++;
+}
+
+// Accumulates one set of counters into another
+void addStats(Stats *from, Stats *into) {
+    into->hits += from->hits;
+    into->misses += from->misses;
+    into->reads += from->reads;
+    into->writes += from->writes;
+}
+
+// De-allocate space allocated for the cache
+void clearCache(Cache *cache) {
+    free(cache->tags);
+    free(cache->dirty);
+    free(cache->age);
+    free(cache->size);
+    free(cache->state);
+    free(cache->nextUse);
+    free(cache->prefetcher);
+    free(cache->prefetched);
+    free(cache->issuedAt);
+    free(cache->evicted);
+    free(cache->setStats);
+    free(cache->intervals);
+    free(cache);
+}
+
+// Prints each set oldest block first ('*' marking dirty blocks). Policies without ages print in way order
+void displayCache(Cache *cache) {
+    for(int i = 0; i < cache->numberOfSets; i++) {
+        size_t base = (size_t) i * cache->associativty;
+        int size = cache->size[i];
+
+        printf("\t[Set #: %d. Size %d] \tHead -> | ", i, size);
+        for(int j = 0; j < cache->associativty - size; j++) printf("- ");
+        if(cache->replacementPolicy > FIFO) {
+            for(int way = 0; way < cache->associativty; way++) {
+                if(cache->tags[base + way] != INVALID_TAG) printf("%llx%s ", cache->tags[base + way], cache->dirty[base + way] ? "*" : "");
+            }
+            printf("| Tail\n");
+            continue;
+        }
+        for(int age = size - 1; age >= 0; age--) {
+            for(int way = 0; way < cache->associativty; way++) {
+                if(cache->age[base + way] == age) printf("%llx%s ", cache->tags[base + way], cache->dirty[base + way] ? "*" : "");
+            }
+        }
+        printf("| Tail\n");
+    }
+}
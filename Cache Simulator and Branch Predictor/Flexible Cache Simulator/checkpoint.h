@@ -0,0 +1,131 @@
+// Esperandieu Elbon II - UCFID: 5401262
+// EEL4768 Computer Architecture - Suboh Suboh - Fall 2023
+// Cache Checkpoint and Restore
+//
+// A checkpoint holds everything a run needs to continue: each cache's geometry, tag array,
+// recency ages, dirty bits, per-set fill counts, policy state (PLRU trees, NRU bits, RRPVs,
+// the DRRIP selector and random seed) and counters, plus the trace path, how many records were
+// consumed and the byte offset to restart from. Files are written through a temporary name and
+// renamed, so a run pre-empted mid-write still leaves the previous checkpoint whole. Prefetcher,
+// recording and OPT state are not saved.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define CACHE_CHECKPOINT_MAGIC "CSIMCKP1"
+#define CHECKPOINT_SINGLE 0
+#define CHECKPOINT_SWEEP 1
+
+// -checkpoint <File>:<Every>[:stop]
+typedef struct Checkpointing {
+    char *path;             // NULL = off
+    long long int every;    // Accesses between checkpoints
+    int stop;               // End the run at the first checkpoint
+    int mode;               // CHECKPOINT_SINGLE or CHECKPOINT_SWEEP, for the resumed report
+} Checkpointing;
+
+// Checkpoint Functions
+int parseCheckpointing(char *spec, Checkpointing *checkpointing);
+int saveCache(FILE *file, Cache *cache);
+Cache *loadCache(FILE *file);
+int saveCacheCheckpoint(Checkpointing *checkpointing, Cache **caches, int count, char *traceFile, long long int records, unsigned long long int offset);
+Cache **loadCacheCheckpoint(char *path, int *count, int *mode, char *traceFile, int traceFileSize, long long int *records, unsigned long long int *offset);
+
+// Parses "<File>:<Every>[:stop]". Returns 1 on success
+int parseCheckpointing(char *spec, Checkpointing *checkpointing) {
+    char *colon = strrchr(spec, ':');
+    if(colon != NULL && strcmp(colon, ":stop") == 0) {
+        checkpointing->stop = 1;
+        *colon = '\0';
+        colon = strrchr(spec, ':');
+    }
+    if(colon == NULL || colon == spec) return 0;
+    *colon = '\0';
+    checkpointing->path = spec;
+    checkpointing->every = strtoll(colon + 1, NULL, 0);
+    return checkpointing->every > 0;
+}
+
+// Writes one cache's geometry, way arrays, policy state and counters. Returns 1 on success
+int saveCache(FILE *file, Cache *cache) {
+    size_t ways = (size_t) cache->numberOfSets * cache->associativty;
+    int geometry[7] = {cache->associativty, cache->numberOfSets, cache->replacementPolicy, cache->writePolicy, cache->blockSize, cache->allocation, cache->indexing};
+    int ok = fwrite(geometry, sizeof(int), 7, file) == 7;
+    ok = ok && fwrite(cache->tags, sizeof(unsigned long long int), ways, file) == ways;
+    ok = ok && fwrite(cache->dirty, sizeof(unsigned char), ways, file) == ways;
+    ok = ok && fwrite(cache->age, sizeof(unsigned short), ways, file) == ways;
+    ok = ok && fwrite(cache->state, sizeof(unsigned char), ways, file) == ways;
+    ok = ok && fwrite(cache->size, sizeof(unsigned short), cache->numberOfSets, file) == (size_t) cache->numberOfSets;
+    ok = ok && fwrite(&cache->psel, sizeof(int), 1, file) == 1 && fwrite(&cache->seed, sizeof(unsigned int), 1, file) == 1;
+    return ok && fwrite(&cache->stats, sizeof(Stats), 1, file) == 1;
+}
+
+// Rebuilds a cache written by saveCache. Returns NULL if the data is bad
+Cache *loadCache(FILE *file) {
+    int geometry[7];
+    if(fread(geometry, sizeof(int), 7, file) != 7) return NULL;
+    if(geometry[0] < 1 || geometry[1] < 1 || !validBlockSize(geometry[4]) || !validPolicy(geometry[2], geometry[0]) || geometry[2] == OPT) return NULL;
+
+    Cache *cache = createCacheExtended(geometry[0], geometry[1], geometry[2], geometry[3], geometry[4], geometry[5], geometry[6]);
+    size_t ways = (size_t) cache->numberOfSets * cache->associativty;
+    int ok = fread(cache->tags, sizeof(unsigned long long int), ways, file) == ways;
+    ok = ok && fread(cache->dirty, sizeof(unsigned char), ways, file) == ways;
+    ok = ok && fread(cache->age, sizeof(unsigned short), ways, file) == ways;
+    ok = ok && fread(cache->state, sizeof(unsigned char), ways, file) == ways;
+    ok = ok && fread(cache->size, sizeof(unsigned short), cache->numberOfSets, file) == (size_t) cache->numberOfSets;
+    ok = ok && fread(&cache->psel, sizeof(int), 1, file) == 1 && fread(&cache->seed, sizeof(unsigned int), 1, file) == 1;
+    ok = ok && fread(&cache->stats, sizeof(Stats), 1, file) == 1;
+    if(!ok) {
+        clearCache(cache);
+        return NULL;
+    }
+    return cache;
+}
+
+// Writes a checkpoint of every cache at the indicated trace position. Returns 1 on success
+int saveCacheCheckpoint(Checkpointing *checkpointing, Cache **caches, int count, char *traceFile, long long int records, unsigned long long int offset) {
+    char temporary[1024];
+    snprintf(temporary, sizeof(temporary), "%s.tmp", checkpointing->path);
+    FILE *file = fopen(temporary, "wb");
+    if(!file) return 0;
+
+    int pathLength = (int) strlen(traceFile);
+    int ok = fwrite(CACHE_CHECKPOINT_MAGIC, 1, 8, file) == 8 && fwrite(&checkpointing->mode, sizeof(int), 1, file) == 1 && fwrite(&count, sizeof(int), 1, file) == 1;
+    ok = ok && fwrite(&records, sizeof(long long int), 1, file) == 1 && fwrite(&offset, sizeof(unsigned long long int), 1, file) == 1;
+    ok = ok && fwrite(&pathLength, sizeof(int), 1, file) == 1 && fwrite(traceFile, 1, pathLength, file) == (size_t) pathLength;
+    for(int i = 0; i < count && ok; i++) ok = saveCache(file, caches[i]);
+    ok = (fclose(file) == 0) && ok;
+    return ok && rename(temporary, checkpointing->path) == 0;
+}
+
+// Reads a checkpoint back: its caches, report mode, trace path and position. Returns NULL if
+// the file can't be read or isn't a cache checkpoint
+Cache **loadCacheCheckpoint(char *path, int *count, int *mode, char *traceFile, int traceFileSize, long long int *records, unsigned long long int *offset) {
+    FILE *file = fopen(path, "rb");
+    if(!file) return NULL;
+
+    char magic[8];
+    int pathLength;
+    *count = 0;
+    int ok = fread(magic, 1, 8, file) == 8 && memcmp(magic, CACHE_CHECKPOINT_MAGIC, 8) == 0;
+    ok = ok && fread(mode, sizeof(int), 1, file) == 1 && fread(count, sizeof(int), 1, file) == 1 && *count > 0;
+    ok = ok && fread(records, sizeof(long long int), 1, file) == 1 && fread(offset, sizeof(unsigned long long int), 1, file) == 1;
+    ok = ok && fread(&pathLength, sizeof(int), 1, file) == 1 && pathLength >= 0 && pathLength < traceFileSize;
+    ok = ok && fread(traceFile, 1, pathLength, file) == (size_t) pathLength;
+    if(!ok) {
+        fclose(file);
+        return NULL;
+    }
+    traceFile[pathLength] = '\0';
+
+    Cache **caches = (Cache **) calloc(*count, sizeof(Cache *));
+    for(int i = 0; i < *count && ok; i++) ok = (caches[i] = loadCache(file)) != NULL;
+    fclose(file);
+    if(!ok) {
+        for(int i = 0; i < *count; i++) if(caches[i]) clearCache(caches[i]);
+        free(caches);
+        return NULL;
+    }
+    return caches;
+}
@@ -0,0 +1,272 @@
+// Esperandieu Elbon II - UCFID: 5401262
+// EEL4768 Computer Architecture - Suboh Suboh - Fall 2023
+// Multi-Level Cache Hierarchy
+//
+// Chains Cache instances into L1I/L1D -> L2 -> ... -> LLC -> memory. Instruction fetches ('I')
+// start at the L1I (or the L1D when there is none); reads and writes start at the L1D. Both L1s
+// feed the first outer level and every outer level feeds the next. Blocks move between levels
+// as whole lines:
+//   - A miss fetches the line from the next level (a read there), then fills it here.
+//   - Write back levels allocate on writes and send dirty victims to the next level as line
+//     writes. Write through levels forward every write to the next level and don't allocate on
+//     write misses.
+//   - Inclusive: evicting a line from an outer level back-invalidates it in every inner level
+//     (a dirty inner copy makes the eviction dirty).
+//   - Exclusive: a line lives in one level at a time. An outer hit moves the line up to the
+//     requester, outer misses fill only the L1, and every victim (clean or dirty) drops into
+//     the next level, counted there as a line write. Exclusive hierarchies must be write back
+//     throughout.
+//   - NINE (non-inclusive non-exclusive): fills go into every level on the way up and evictions
+//     never reach inner levels.
+// Recency and dirty bits are tracked exactly here; the single-level LRU dirty quirk is not modeled.
+// Any replacement policy but OPT may be used per level.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_LEVELS 8
+#define INCLUSIVE 0
+#define EXCLUSIVE 1
+#define NINE 2
+
+// Per-level traffic, 64-bit so long traces don't wrap
+typedef struct LevelStats LevelStats;
+struct LevelStats {
+    long long int reads, writes;            // Demand accesses from the core or an inner level
+    long long int hits, misses;             // Outcomes of the demand accesses
+    long long int lineWrites;               // Writebacks, write-through data and exclusive victims from inner levels
+    long long int evictions, writebacks;    // Valid victims, and those sent on dirty
+    long long int invalidations;            // Lines removed by back-invalidation or exclusive moves
+};
+
+// One level: its cache and the level it misses to (-1 = memory)
+typedef struct Level Level;
+struct Level {
+    char name[8];
+    int cacheSize;
+    Cache *cache;
+    int next;
+    LevelStats stats;
+};
+
+typedef struct Hierarchy Hierarchy;
+struct Hierarchy {
+    Level levels[MAX_LEVELS];
+    int count, inclusion;
+    int instructionLevel, dataLevel;        // Where 'I' and 'R'/'W' accesses enter
+    int blockSize, blockShift;              // Line size shared by every level
+    long long int memoryReads, memoryWrites;
+};
+
+// Hierarchy Functions
+Hierarchy *createHierarchy(int inclusion);
+int addLevel(char *name, int cacheSize, int associativity, int replacementPolicy, int writePolicy, int blockSize, int indexing, Hierarchy *hierarchy);
+int linkHierarchy(Hierarchy *hierarchy);
+void simulateHierarchyAccess(char operation, unsigned long long int address, Hierarchy *hierarchy);
+void printHierarchyStats(Hierarchy *hierarchy);
+Hierarchy *deleteHierarchy(Hierarchy *hierarchy);
+
+// Line Movement Functions
+int demandAccess(int level, unsigned long long int block, int write, int fromInner, Hierarchy *hierarchy);
+void writeLine(int level, unsigned long long int block, Hierarchy *hierarchy);
+void insertLine(int level, unsigned long long int block, int dirty, Hierarchy *hierarchy);
+int backInvalidate(int level, unsigned long long int block, Hierarchy *hierarchy);
+
+// Create an empty hierarchy with the indicated inclusion policy
+Hierarchy *createHierarchy(int inclusion) {
+    Hierarchy *hierarchy = (Hierarchy *) calloc(1, sizeof(Hierarchy));
+    hierarchy->inclusion = inclusion;
+    hierarchy->instructionLevel = hierarchy->dataLevel = -1;
+    return hierarchy;
+}
+
+// Appends a level. "l1i" and "l1d" are the first levels; any other name is the next outer level,
+// in the order added. The first level sets the line size. Returns 1 on success
+int addLevel(char *name, int cacheSize, int associativity, int replacementPolicy, int writePolicy, int blockSize, int indexing, Hierarchy *hierarchy) {
+    if(hierarchy->count > 0 && blockSize != hierarchy->blockSize) return 0;
+    int numSets = (associativity > 0 && validBlockSize(blockSize)) ? cacheSize / (associativity * blockSize) : 0;
+    if(hierarchy->count == MAX_LEVELS || numSets < 1 || strlen(name) >= sizeof(hierarchy->levels[0].name)) return 0;
+    if(hierarchy->inclusion == EXCLUSIVE && writePolicy != WRITE_BACK) return 0;
+    if(!validPolicy(replacementPolicy, associativity) || replacementPolicy == OPT) return 0;
+
+    int index = hierarchy->count++;
+    Level *level = &hierarchy->levels[index];
+    strcpy(level->name, name);
+    level->cacheSize = cacheSize;
+    level->cache = createCacheExtended(associativity, numSets, replacementPolicy, writePolicy, blockSize, WRITE_ALLOCATE, indexing);
+    hierarchy->blockSize = blockSize;
+    hierarchy->blockShift = level->cache->blockShift;
+    level->next = -1;
+    if(strcmp(name, "l1i") == 0) hierarchy->instructionLevel = index;
+    else if(strcmp(name, "l1d") == 0) hierarchy->dataLevel = index;
+    return 1;
+}
+
+// Connects every level to the one it misses to. Returns 1 if the hierarchy has an L1D
+int linkHierarchy(Hierarchy *hierarchy) {
+    if(hierarchy->dataLevel < 0) return 0;
+    if(hierarchy->instructionLevel < 0) hierarchy->instructionLevel = hierarchy->dataLevel;
+
+    // Outer levels chain in order; both L1s miss to the first of them
+    int previous = -1;
+    for(int i = hierarchy->count - 1; i >= 0; i--) {
+        if(i == hierarchy->instructionLevel || i == hierarchy->dataLevel) continue;
+        hierarchy->levels[i].next = previous;
+        previous = i;
+    }
+    hierarchy->levels[hierarchy->dataLevel].next = previous;
+    if(hierarchy->instructionLevel != hierarchy->dataLevel) hierarchy->levels[hierarchy->instructionLevel].next = previous;
+    return 1;
+}
+
+// Feeds one trace record to the hierarchy
+void simulateHierarchyAccess(char operation, unsigned long long int address, Hierarchy *hierarchy) {
+    unsigned long long int block = address >> hierarchy->blockShift;
+    if(operation == 'I') demandAccess(hierarchy->instructionLevel, block, 0, 0, hierarchy);
+    else if(operation == 'W') demandAccess(hierarchy->dataLevel, block, 1, 0, hierarchy);
+    else if(operation == 'R') demandAccess(hierarchy->dataLevel, block, 0, 0, hierarchy);
+}
+
+// A read or write of a line at a level, from the core or from an inner level's miss. Returns the
+// dirty bit of a line an exclusive level hands up to the requester (0 otherwise)
+int demandAccess(int level, unsigned long long int block, int write, int fromInner, Hierarchy *hierarchy) {
+    if(level < 0) {
+        hierarchy->memoryReads++;
+        return 0;
+    }
+    Level *current = &hierarchy->levels[level];
+    Cache *cache = current->cache;
+    int setNumber = indexSet(block, cache);
+    size_t base = (size_t) setNumber * cache->associativty;
+    if(write) current->stats.writes++;
+    else current->stats.reads++;
+
+    // Hit
+    int way = searchSet(block, setNumber, cache);
+    if(way >= 0) {
+        current->stats.hits++;
+
+        // Exclusive outer levels give the line up
+        if(hierarchy->inclusion == EXCLUSIVE && fromInner) {
+            int dirty = cache->dirty[base + way];
+            invalidateWay(setNumber, way, cache);
+            current->stats.invalidations++;
+            return dirty;
+        }
+
+        cache->policy->hit(setNumber, way, cache);
+        if(write && cache->writePolicy == WRITE_BACK) cache->dirty[base + way] = DIRTY;
+        else if(write) writeLine(current->next, block, hierarchy);
+        return 0;
+    }
+
+    // Miss. Write through levels don't allocate on writes
+    current->stats.misses++;
+    if(write && cache->writePolicy == WRITE_THROUGH) {
+        writeLine(current->next, block, hierarchy);
+        return 0;
+    }
+
+    // Fetch the line; exclusive outer levels pass it straight through to the requester
+    int dirty = demandAccess(current->next, block, 0, 1, hierarchy);
+    if(hierarchy->inclusion == EXCLUSIVE && fromInner) return dirty;
+    insertLine(level, block, dirty || write, hierarchy);
+    return 0;
+}
+
+// A whole line written into a level by an inner level (a writeback or write-through data)
+void writeLine(int level, unsigned long long int block, Hierarchy *hierarchy) {
+    if(level < 0) {
+        hierarchy->memoryWrites++;
+        return;
+    }
+    Level *current = &hierarchy->levels[level];
+    Cache *cache = current->cache;
+    int setNumber = indexSet(block, cache);
+    current->stats.lineWrites++;
+
+    // The full line is supplied, so write back levels allocate without a fetch
+    int way = searchSet(block, setNumber, cache);
+    if(cache->writePolicy == WRITE_THROUGH) writeLine(current->next, block, hierarchy);
+    else if(way >= 0) cache->dirty[(size_t) setNumber * cache->associativty + way] = DIRTY;
+    else insertLine(level, block, 1, hierarchy);
+}
+
+// Fills a line into a level, then sends its victim on: back-invalidated first when inclusive,
+// down to the next level when exclusive (even if clean), otherwise written back only if dirty
+void insertLine(int level, unsigned long long int block, int dirty, Hierarchy *hierarchy) {
+    if(level < 0) {
+        if(dirty) hierarchy->memoryWrites++;
+        return;
+    }
+    Level *current = &hierarchy->levels[level];
+    Cache *cache = current->cache;
+    int setNumber = indexSet(block, cache);
+    size_t base = (size_t) setNumber * cache->associativty;
+
+    // An exclusive victim may land on a line the level already holds
+    int way = (hierarchy->inclusion == EXCLUSIVE) ? searchSet(block, setNumber, cache) : -1;
+    if(way >= 0) {
+        if(dirty) cache->dirty[base + way] = DIRTY;
+        return;
+    }
+
+    // Fill before moving the victim, so nothing the victim triggers can disturb this set mid-update
+    way = findVictim(setNumber, cache);
+    unsigned long long int victim = cache->tags[base + way];
+    int victimDirty = victim != INVALID_TAG && cache->dirty[base + way] == DIRTY;
+    fillWay(block, setNumber, way, cache);
+    if(dirty) cache->dirty[base + way] = DIRTY;
+    if(victim == INVALID_TAG) return;
+
+    current->stats.evictions++;
+    if(hierarchy->inclusion == INCLUSIVE) victimDirty |= backInvalidate(level, victim, hierarchy);
+    if(victimDirty) current->stats.writebacks++;
+    if(hierarchy->inclusion == EXCLUSIVE) {
+        // The receiving level takes the whole line, clean or dirty, like a writeback
+        if(current->next >= 0) hierarchy->levels[current->next].stats.lineWrites++;
+        insertLine(current->next, victim, victimDirty, hierarchy);
+    }
+    else if(victimDirty) writeLine(current->next, victim, hierarchy);
+}
+
+// Removes a line from every level inside the indicated one. Returns 1 if any removed copy was dirty
+int backInvalidate(int level, unsigned long long int block, Hierarchy *hierarchy) {
+    int dirty = 0;
+    for(int i = 0; i < hierarchy->count; i++) {
+        if(hierarchy->levels[i].next != level) continue;
+        Level *inner = &hierarchy->levels[i];
+        int setNumber = indexSet(block, inner->cache);
+        int way = searchSet(block, setNumber, inner->cache);
+        if(way >= 0) {
+            dirty |= inner->cache->dirty[(size_t) setNumber * inner->cache->associativty + way] == DIRTY;
+            invalidateWay(setNumber, way, inner->cache);
+            inner->stats.invalidations++;
+        }
+        dirty |= backInvalidate(i, block, hierarchy);
+    }
+    return dirty;
+}
+
+// One line per level, innermost first, then the memory traffic
+void printHierarchyStats(Hierarchy *hierarchy) {
+    char *inclusion[] = {"inclusive", "exclusive", "nine"};
+    printf("Hierarchy: %s\n", inclusion[hierarchy->inclusion]);
+    printf("Level\tSize\tAssoc\tPolicy\tWB\tReads\tWrites\tMisses\tMissRatio\tLineWrites\tEvictions\tWritebacks\tInvalidations\n");
+    for(int i = 0; i < hierarchy->count; i++) {
+        Level *level = &hierarchy->levels[i];
+        LevelStats *stats = &level->stats;
+        long long int accesses = stats->hits + stats->misses;
+        printf("%s\t%d\t%d\t%d\t%d\t%lld\t%lld\t%lld\t%.6f\t%lld\t%lld\t%lld\t%lld\n", level->name, level->cacheSize, level->cache->associativty, level->cache->replacementPolicy, level->cache->writePolicy,
+            stats->reads, stats->writes, stats->misses, (accesses > 0) ? (double) stats->misses / (double) accesses : 0.0, stats->lineWrites, stats->evictions, stats->writebacks, stats->invalidations);
+    }
+    printf("Memory\tReads: %lld\tWrites: %lld\tTraffic: %lld bytes\n", hierarchy->memoryReads, hierarchy->memoryWrites, (hierarchy->memoryReads + hierarchy->memoryWrites) * hierarchy->blockSize);
+}
+
+// De-allocate the hierarchy and its caches
+Hierarchy *deleteHierarchy(Hierarchy *hierarchy) {
+    for(int i = 0; i < hierarchy->count; i++) clearCache(hierarchy->levels[i].cache);
+    free(hierarchy);
+    return NULL;
+}
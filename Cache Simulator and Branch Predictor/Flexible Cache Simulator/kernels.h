@@ -0,0 +1,215 @@
+// Esperandieu Elbon II - UCFID: 5401262
+// EEL4768 Computer Architecture - Suboh Suboh - Fall 2023
+// Specialized Cache Kernels
+//
+// accessCacheSet decides the replacement policy, write policy, write allocation and every
+// optional feature (prefetching, per-set counters, intervals) on each access, and sizes its way
+// loops from the cache at run time. A kernel replays a whole batch through one cache with all of
+// those fixed at compile time: kernelAccess is always inlined with constant parameters, so each
+// DEFINE_KERNEL instance is a branch-free-per-configuration copy whose way loops the compiler
+// unrolls. selectKernel picks the instance matching a cache, or genericKernel
+// (simulateCacheAccess) for anything else: other block sizes, index functions, policies and
+// associativities, non power of two set counts, and caches with a prefetcher or recording.
+// Kernels keep the cache in exactly the state accessCacheSet would, so both paths can be mixed
+// (checkpoints, resume). SIM_KERNEL=generic forces the generic path.
+//
+// Instantiated for 64B blocks, modulo indexing, associativity 1-16, LRU, FIFO, PLRU and SRRIP,
+// write back and write through, and the mixed and write allocate miss models.
+
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__GNUC__)
+#define KERNEL_UNROLL _Pragma("GCC unroll 16")
+#define KERNEL_INLINE static inline __attribute__((always_inline))
+#else
+#define KERNEL_UNROLL
+#define KERNEL_INLINE static inline
+#endif
+
+#define KERNEL_BLOCK_SHIFT 6    // 64B blocks (BLOCK_SIZE)
+
+typedef void (*CacheKernel)(Access *batch, int count, Cache *cache);
+
+// A kernel and the configuration it was compiled for
+typedef struct KernelEntry {
+    int associativity, replacementPolicy, writePolicy, allocation;
+    CacheKernel kernel;
+} KernelEntry;
+
+// Kernel Functions
+void genericKernel(Access *batch, int count, Cache *cache);
+CacheKernel selectKernel(Cache *cache);
+
+// First way of the set holding key, or -1. Searched from the top so the unrolled loop needs no
+// early exit
+KERNEL_INLINE int kernelFind(const unsigned long long int *tags, int ways, unsigned long long int key) {
+    int way = -1;
+    KERNEL_UNROLL
+    for(int w = ways - 1; w >= 0; w--) way = (tags[w] == key) ? w : way;
+    return way;
+}
+
+// promoteWay: every age below oldAge grows by one, the way becomes the newest
+KERNEL_INLINE void kernelPromote(unsigned short *age, int ways, int way, unsigned short oldAge) {
+    KERNEL_UNROLL
+    for(int w = 0; w < ways; w++) age[w] += (unsigned short) (age[w] < oldAge);
+    age[way] = 0;
+}
+
+// plruTouch
+KERNEL_INLINE void kernelPlruTouch(unsigned char *tree, int ways, int way) {
+    int node = 1;
+    KERNEL_UNROLL
+    for(int half = ways >> 1; half > 0; half >>= 1) {
+        int right = (way & half) != 0;
+        tree[node] = (unsigned char) !right;
+        node = 2 * node + right;
+    }
+}
+
+// plruVictim
+KERNEL_INLINE int kernelPlruVictim(const unsigned char *tree, int ways) {
+    int node = 1, way = 0;
+    KERNEL_UNROLL
+    for(int half = ways >> 1; half > 0; half >>= 1) {
+        way = 2 * way + tree[node];
+        node = 2 * node + tree[node];
+    }
+    return way;
+}
+
+// rripVictim
+KERNEL_INLINE int kernelRripVictim(unsigned char *rrpv, int ways) {
+    int oldest = 0;
+    for(int w = 0; w < ways; w++) {
+        if(rrpv[w] == RRPV_MAX) return w;
+        if(rrpv[w] > rrpv[oldest]) oldest = w;
+    }
+    int step = RRPV_MAX - rrpv[oldest];
+    KERNEL_UNROLL
+    for(int w = 0; w < ways; w++) rrpv[w] += step;
+    return oldest;
+}
+
+// accessCacheSet for a cache without prefetcher or recording, every parameter a constant
+KERNEL_INLINE void kernelAccess(char operation, unsigned long long int address, Cache *cache, const int ways, const int shift, const int policy, const int writePolicy, const int allocation) {
+    unsigned long long int tag = address >> shift;
+    int setNumber = (int) (tag & cache->setMask);
+    size_t base = (size_t) setNumber * ways;
+    unsigned long long int *tags = cache->tags + base;
+    unsigned char *dirty = cache->dirty + base, *state = cache->state + base;
+    unsigned short *age = cache->age + base;
+    Stats *stats = &cache->stats;
+    int write = operation == 'W';
+
+    // Hit
+    int way = kernelFind(tags, ways, tag);
+    if(way >= 0) {
+        if(write && writePolicy == WRITE_THROUGH) stats->writes++;
+        stats->hits++;
+        if(policy == LRU && allocation == WRITE_MIXED) {
+            dirty[way] = write && writePolicy == WRITE_BACK && cache->size[setNumber] > 1;
+            kernelPromote(age, ways, way, age[way]);
+            return;
+        }
+        if(policy == LRU) kernelPromote(age, ways, way, age[way]);
+        else if(policy == PLRU) kernelPlruTouch(state, ways, way);
+        else if(policy == SRRIP) state[way] = 0;
+        if(write && writePolicy == WRITE_BACK) dirty[way] = DIRTY;
+        return;
+    }
+
+    // Miss
+    stats->misses++;
+    if(write && allocation == WRITE_MIXED) {
+        stats->writes++;
+        stats->reads++;
+    }
+    else if(write) {
+        stats->reads++;
+        if(writePolicy == WRITE_THROUGH) stats->writes++;
+    }
+    else if(operation == 'R') stats->reads++;
+
+    // Victim: an empty way first, then the policy's choice
+    if(cache->size[setNumber] < ways) {
+        way = kernelFind(tags, ways, INVALID_TAG);
+        if(way < 0) way = 0;
+        cache->size[setNumber]++;
+    }
+    else {
+        if(policy == LRU || policy == FIFO) {
+            way = 0;
+            KERNEL_UNROLL
+            for(int w = ways - 1; w >= 0; w--) way = (age[w] == ways - 1) ? w : way;
+        }
+        else if(policy == PLRU) way = kernelPlruVictim(state, ways);
+        else way = kernelRripVictim(state, ways);
+        if(writePolicy == WRITE_BACK && dirty[way] == DIRTY) stats->writes++;
+    }
+
+    // Fill
+    tags[way] = tag;
+    dirty[way] = (write && allocation == WRITE_ALLOCATE && writePolicy == WRITE_BACK) ? DIRTY : 0;
+    if(policy == LRU || policy == FIFO) kernelPromote(age, ways, way, age[way]);
+    else if(policy == PLRU) kernelPlruTouch(state, ways, way);
+    else state[way] = RRPV_MAX - 1;
+}
+
+// Defines kernel_<Ways>_<Policy>_<Write>_<Allocation> over a batch
+#define DEFINE_KERNEL(WAYS, POLICY, WRITE, ALLOCATION) \
+    void kernel_##WAYS##_##POLICY##_##WRITE##_##ALLOCATION(Access *batch, int count, Cache *cache) { \
+        for(int i = 0; i < count; i++) kernelAccess(batch[i].operation, batch[i].address, cache, WAYS, KERNEL_BLOCK_SHIFT, POLICY, WRITE, ALLOCATION); \
+    }
+#define KERNEL_ENTRY(WAYS, POLICY, WRITE, ALLOCATION) {WAYS, POLICY, WRITE, ALLOCATION, kernel_##WAYS##_##POLICY##_##WRITE##_##ALLOCATION}
+
+// Every policy, write policy and miss model at one associativity
+#define DEFINE_KERNELS(WAYS) \
+    DEFINE_KERNEL(WAYS, LRU, WRITE_BACK, WRITE_MIXED) DEFINE_KERNEL(WAYS, LRU, WRITE_BACK, WRITE_ALLOCATE) \
+    DEFINE_KERNEL(WAYS, LRU, WRITE_THROUGH, WRITE_MIXED) DEFINE_KERNEL(WAYS, LRU, WRITE_THROUGH, WRITE_ALLOCATE) \
+    DEFINE_KERNEL(WAYS, FIFO, WRITE_BACK, WRITE_MIXED) DEFINE_KERNEL(WAYS, FIFO, WRITE_BACK, WRITE_ALLOCATE) \
+    DEFINE_KERNEL(WAYS, FIFO, WRITE_THROUGH, WRITE_MIXED) DEFINE_KERNEL(WAYS, FIFO, WRITE_THROUGH, WRITE_ALLOCATE) \
+    DEFINE_KERNEL(WAYS, PLRU, WRITE_BACK, WRITE_MIXED) DEFINE_KERNEL(WAYS, PLRU, WRITE_BACK, WRITE_ALLOCATE) \
+    DEFINE_KERNEL(WAYS, PLRU, WRITE_THROUGH, WRITE_MIXED) DEFINE_KERNEL(WAYS, PLRU, WRITE_THROUGH, WRITE_ALLOCATE) \
+    DEFINE_KERNEL(WAYS, SRRIP, WRITE_BACK, WRITE_MIXED) DEFINE_KERNEL(WAYS, SRRIP, WRITE_BACK, WRITE_ALLOCATE) \
+    DEFINE_KERNEL(WAYS, SRRIP, WRITE_THROUGH, WRITE_MIXED) DEFINE_KERNEL(WAYS, SRRIP, WRITE_THROUGH, WRITE_ALLOCATE)
+#define KERNEL_ENTRIES(WAYS) \
+    KERNEL_ENTRY(WAYS, LRU, WRITE_BACK, WRITE_MIXED), KERNEL_ENTRY(WAYS, LRU, WRITE_BACK, WRITE_ALLOCATE), \
+    KERNEL_ENTRY(WAYS, LRU, WRITE_THROUGH, WRITE_MIXED), KERNEL_ENTRY(WAYS, LRU, WRITE_THROUGH, WRITE_ALLOCATE), \
+    KERNEL_ENTRY(WAYS, FIFO, WRITE_BACK, WRITE_MIXED), KERNEL_ENTRY(WAYS, FIFO, WRITE_BACK, WRITE_ALLOCATE), \
+    KERNEL_ENTRY(WAYS, FIFO, WRITE_THROUGH, WRITE_MIXED), KERNEL_ENTRY(WAYS, FIFO, WRITE_THROUGH, WRITE_ALLOCATE), \
+    KERNEL_ENTRY(WAYS, PLRU, WRITE_BACK, WRITE_MIXED), KERNEL_ENTRY(WAYS, PLRU, WRITE_BACK, WRITE_ALLOCATE), \
+    KERNEL_ENTRY(WAYS, PLRU, WRITE_THROUGH, WRITE_MIXED), KERNEL_ENTRY(WAYS, PLRU, WRITE_THROUGH, WRITE_ALLOCATE), \
+    KERNEL_ENTRY(WAYS, SRRIP, WRITE_BACK, WRITE_MIXED), KERNEL_ENTRY(WAYS, SRRIP, WRITE_BACK, WRITE_ALLOCATE), \
+    KERNEL_ENTRY(WAYS, SRRIP, WRITE_THROUGH, WRITE_MIXED), KERNEL_ENTRY(WAYS, SRRIP, WRITE_THROUGH, WRITE_ALLOCATE)
+
+DEFINE_KERNELS(1)
+DEFINE_KERNELS(2)
+DEFINE_KERNELS(4)
+DEFINE_KERNELS(8)
+DEFINE_KERNELS(16)
+
+KernelEntry cacheKernels[] = {
+    KERNEL_ENTRIES(1), KERNEL_ENTRIES(2), KERNEL_ENTRIES(4), KERNEL_ENTRIES(8), KERNEL_ENTRIES(16)
+};
+#define NUM_KERNELS (int) (sizeof(cacheKernels) / sizeof(cacheKernels[0]))
+
+// Any cache, one access at a time
+void genericKernel(Access *batch, int count, Cache *cache) {
+    for(int i = 0; i < count; i++) simulateCacheAccess(batch[i].operation, batch[i].address, cache);
+}
+
+// The specialized kernel for the cache's configuration, or genericKernel
+CacheKernel selectKernel(Cache *cache) {
+    char *forced = getenv("SIM_KERNEL");
+    if(forced != NULL && strcmp(forced, "generic") == 0) return genericKernel;
+    if(cache->blockShift != KERNEL_BLOCK_SHIFT || cache->indexing != INDEX_MODULO || !cache->powerOfTwoSets) return genericKernel;
+    if(cache->prefetch != NULL || cache->setStats != NULL || cache->intervalLength > 0) return genericKernel;
+    for(int i = 0; i < NUM_KERNELS; i++) {
+        KernelEntry *entry = &cacheKernels[i];
+        if(entry->associativity == cache->associativty && entry->replacementPolicy == cache->replacementPolicy && entry->writePolicy == cache->writePolicy
+            && entry->allocation == cache->allocation) return entry->kernel;
+    }
+    return genericKernel;
+}
@@ -0,0 +1,360 @@
+// Esperandieu Elbon II - UCFID: 5401262
+// EEL4768 Computer Architecture - Suboh Suboh - Fall 2023
+// Multicore Simulation with Coherent Private L1s and a Shared LLC
+//
+// Each core runs its own trace through a private write back L1D; every L1 misses to one shared
+// LLC, which is inclusive and doubles as the coherence directory (a sharer bit per core on each
+// LLC line). L1 lines carry MESI states:
+//   - A read miss fills Exclusive when no other core holds the line, Shared otherwise. A remote
+//     Exclusive or Modified copy is downgraded to Shared (Modified data is written into the LLC).
+//   - A write miss (read for ownership) or a write hit on a Shared line (upgrade) invalidates
+//     every other copy and leaves the line Modified. Exclusive lines upgrade silently.
+//   - A Modified L1 victim is written back into the LLC; evicting an LLC line back-invalidates
+//     every L1 copy, and it goes to memory if the LLC or any copy was dirty.
+// A sharing miss is an L1 miss on a line a remote write invalidated; each core remembers such
+// lines in a small direct-mapped filter, so a few are missed when the filter aliases. LLC lines
+// are charged to the core that brought them in, for per-core occupancy.
+// Traces are interleaved round robin (one access per core in turn) or by timestamp (the third
+// field of each record, see readTimedAccesses). Instruction fetches are treated as reads.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_CORES 32
+#define MESI_INVALID 0
+#define MESI_SHARED 1
+#define MESI_EXCLUSIVE 2
+#define MESI_MODIFIED 3
+#define INTERLEAVE_ROUND_ROBIN 0
+#define INTERLEAVE_TIMESTAMP 1
+#define SHARING_FILTER 4096     // Direct-mapped filter of remotely invalidated lines, power of 2
+#define OCCUPANCY_SAMPLE 4096   // Accesses between LLC occupancy samples
+#define MULTICORE_BATCH 4096    // Records decoded per core at a time
+
+// Per-core counters, 64-bit so long traces don't wrap
+typedef struct CoreStats CoreStats;
+struct CoreStats {
+    long long int reads, writes, hits, misses;
+    long long int sharingMisses;        // L1 misses on lines a remote write invalidated
+    long long int upgrades;             // Write hits on Shared lines
+    long long int invalidations;        // Copies lost to remote writes
+    long long int backInvalidations;    // Copies lost to LLC evictions
+    long long int writebacks;           // Modified L1 victims written into the LLC
+    long long int llcHits, llcMisses;   // Outcomes of this core's L1 misses at the LLC
+    long long int occupancy;            // LLC lines this core brought in, now
+    long long int occupancySum;         // Sum of occupancy samples, for the average
+};
+
+// One core: its L1, the MESI state of every L1 way and the sharing miss filter
+typedef struct Core Core;
+struct Core {
+    Cache *l1;
+    unsigned char *mesi;
+    unsigned long long int *invalidated;
+    CoreStats stats;
+};
+
+typedef struct Multicore Multicore;
+struct Multicore {
+    Core cores[MAX_CORES];
+    int count;
+    Cache *llc;
+    unsigned int *sharers;              // Per LLC way: bit c set when core c's L1 holds the line
+    unsigned char *owner;               // Per LLC way: core that brought the line in
+    int l1Size, llcSize, blockShift, blockSize;
+    long long int accesses, samples;
+    long long int llcEvictions, llcWritebacks, interventions;  // Interventions: remote E/M copies downgraded
+    long long int memoryReads, memoryWrites;
+};
+
+// Multicore Functions
+Multicore *createMulticore(int cores, int l1Size, int l1Associativity, int l1Policy, int llcSize, int llcAssociativity, int llcPolicy, int blockSize, int indexing);
+void simulateCoreAccess(int core, char operation, unsigned long long int address, Multicore *multicore);
+void runMulticore(TraceReader **traces, int interleave, Multicore *multicore);
+void printMulticoreStats(int interleave, Multicore *multicore);
+Multicore *deleteMulticore(Multicore *multicore);
+
+// Coherence Functions
+size_t llcFetch(int core, unsigned long long int block, Multicore *multicore);
+void fillL1(int core, unsigned long long int block, int state, Multicore *multicore);
+int dropCopy(int core, unsigned long long int block, int remoteWrite, Multicore *multicore);
+void downgradeCopy(int core, unsigned long long int block, size_t llcWay, Multicore *multicore);
+void invalidateOthers(int core, unsigned long long int block, size_t llcWay, Multicore *multicore);
+
+// Creates the cores' L1s and the LLC, both write back with the indicated block size and index
+// function. Returns NULL on bad parameters
+Multicore *createMulticore(int cores, int l1Size, int l1Associativity, int l1Policy, int llcSize, int llcAssociativity, int llcPolicy, int blockSize, int indexing) {
+    if(cores < 1 || cores > MAX_CORES || !validBlockSize(blockSize) || l1Associativity < 1 || llcAssociativity < 1) return NULL;
+    int l1Sets = l1Size / (l1Associativity * blockSize), llcSets = llcSize / (llcAssociativity * blockSize);
+    if(l1Sets < 1 || llcSets < 1 || !validPolicy(l1Policy, l1Associativity) || !validPolicy(llcPolicy, llcAssociativity)) return NULL;
+    if(l1Policy == OPT || llcPolicy == OPT) return NULL;
+
+    Multicore *multicore = (Multicore *) calloc(1, sizeof(Multicore));
+    multicore->count = cores;
+    multicore->l1Size = l1Size;
+    multicore->llcSize = llcSize;
+    for(int c = 0; c < cores; c++) {
+        Core *core = &multicore->cores[c];
+        core->l1 = createCacheExtended(l1Associativity, l1Sets, l1Policy, WRITE_BACK, blockSize, WRITE_ALLOCATE, indexing);
+        core->mesi = (unsigned char *) calloc((size_t) core->l1->numberOfSets * core->l1->associativty, sizeof(unsigned char));
+        core->invalidated = (unsigned long long int *) malloc(SHARING_FILTER * sizeof(unsigned long long int));
+        for(int i = 0; i < SHARING_FILTER; i++) core->invalidated[i] = INVALID_TAG;
+    }
+    multicore->llc = createCacheExtended(llcAssociativity, llcSets, llcPolicy, WRITE_BACK, blockSize, WRITE_ALLOCATE, indexing);
+    size_t ways = (size_t) multicore->llc->numberOfSets * multicore->llc->associativty;
+    multicore->sharers = (unsigned int *) calloc(ways, sizeof(unsigned int));
+    multicore->owner = (unsigned char *) calloc(ways, sizeof(unsigned char));
+    multicore->blockShift = multicore->llc->blockShift;
+    multicore->blockSize = multicore->llc->blockSize;
+    return multicore;
+}
+
+// Feeds one access of one core's trace to the system
+void simulateCoreAccess(int c, char operation, unsigned long long int address, Multicore *multicore) {
+    Core *core = &multicore->cores[c];
+    Cache *l1 = core->l1;
+    unsigned long long int block = address >> multicore->blockShift;
+    int write = operation == 'W';
+    if(write) core->stats.writes++;
+    else core->stats.reads++;
+
+    // Sample every core's LLC occupancy now and then
+    if(++multicore->accesses % OCCUPANCY_SAMPLE == 0) {
+        for(int i = 0; i < multicore->count; i++) multicore->cores[i].stats.occupancySum += multicore->cores[i].stats.occupancy;
+        multicore->samples++;
+    }
+
+    // L1 hit: only a write to a Shared line needs the other cores
+    int setNumber = indexSet(block, l1);
+    int way = searchSet(block, setNumber, l1);
+    if(way >= 0) {
+        size_t index = (size_t) setNumber * l1->associativty + way;
+        core->stats.hits++;
+        l1->policy->hit(setNumber, way, l1);
+        if(write && core->mesi[index] == MESI_SHARED) {
+            core->stats.upgrades++;
+            Cache *llc = multicore->llc;
+            int llcSet = indexSet(block, llc);
+            invalidateOthers(c, block, (size_t) llcSet * llc->associativty + searchSet(block, llcSet, llc), multicore);
+        }
+        if(write) {
+            core->mesi[index] = MESI_MODIFIED;
+            l1->dirty[index] = DIRTY;
+        }
+        return;
+    }
+
+    // L1 miss. A line this core lost to a remote write makes it a sharing miss
+    core->stats.misses++;
+    unsigned long long int *filter = &core->invalidated[block & (SHARING_FILTER - 1)];
+    if(*filter == block) {
+        core->stats.sharingMisses++;
+        *filter = INVALID_TAG;
+    }
+
+    // The LLC supplies the line and says who else holds it
+    size_t llcWay = llcFetch(c, block, multicore);
+    unsigned int others = multicore->sharers[llcWay] & ~(1u << c);
+    if(write) {
+        invalidateOthers(c, block, llcWay, multicore);
+        fillL1(c, block, MESI_MODIFIED, multicore);
+    }
+    else {
+        for(int i = 0; i < multicore->count; i++) {
+            if(others & (1u << i)) downgradeCopy(i, block, llcWay, multicore);
+        }
+        fillL1(c, block, others ? MESI_SHARED : MESI_EXCLUSIVE, multicore);
+    }
+    multicore->sharers[llcWay] |= 1u << c;
+}
+
+// Looks a line up in the LLC for a core's L1 miss, filling it from memory if needed. Returns the
+// LLC way index (set * associativity + way) holding the line
+size_t llcFetch(int c, unsigned long long int block, Multicore *multicore) {
+    Cache *llc = multicore->llc;
+    CoreStats *stats = &multicore->cores[c].stats;
+    int setNumber = indexSet(block, llc);
+    size_t base = (size_t) setNumber * llc->associativty;
+    int way = searchSet(block, setNumber, llc);
+    if(way >= 0) {
+        stats->llcHits++;
+        llc->policy->hit(setNumber, way, llc);
+        return base + way;
+    }
+
+    // Miss: the victim leaves every L1 before the new line takes its way
+    stats->llcMisses++;
+    multicore->memoryReads++;
+    way = findVictim(setNumber, llc);
+    size_t index = base + way;
+    unsigned long long int victim = llc->tags[index];
+    if(victim != INVALID_TAG) {
+        int dirty = llc->dirty[index] == DIRTY;
+        for(int i = 0; i < multicore->count; i++) {
+            if(multicore->sharers[index] & (1u << i)) dirty |= dropCopy(i, victim, 0, multicore);
+        }
+        multicore->llcEvictions++;
+        multicore->cores[multicore->owner[index]].stats.occupancy--;
+        if(dirty) {
+            multicore->llcWritebacks++;
+            multicore->memoryWrites++;
+        }
+    }
+    fillWay(block, setNumber, way, llc);
+    multicore->sharers[index] = 0;
+    multicore->owner[index] = (unsigned char) c;
+    stats->occupancy++;
+    return index;
+}
+
+// Fills a line into a core's L1 in the indicated state. A Modified victim is written into the
+// LLC; any victim leaves the directory
+void fillL1(int c, unsigned long long int block, int state, Multicore *multicore) {
+    Core *core = &multicore->cores[c];
+    Cache *l1 = core->l1, *llc = multicore->llc;
+    int setNumber = indexSet(block, l1);
+    int way = findVictim(setNumber, l1);
+    size_t index = (size_t) setNumber * l1->associativty + way;
+    unsigned long long int victim = l1->tags[index];
+    if(victim != INVALID_TAG) {
+        int llcSet = indexSet(victim, llc);
+        size_t llcWay = (size_t) llcSet * llc->associativty + searchSet(victim, llcSet, llc);
+        if(core->mesi[index] == MESI_MODIFIED) {
+            core->stats.writebacks++;
+            llc->dirty[llcWay] = DIRTY;
+        }
+        multicore->sharers[llcWay] &= ~(1u << c);
+    }
+    fillWay(block, setNumber, way, l1);
+    core->mesi[index] = (unsigned char) state;
+    if(state == MESI_MODIFIED) l1->dirty[index] = DIRTY;
+}
+
+// Removes a core's copy of a line, for a remote write or an LLC eviction. The caller fixes the
+// directory. Returns 1 if the copy was Modified
+int dropCopy(int c, unsigned long long int block, int remoteWrite, Multicore *multicore) {
+    Core *core = &multicore->cores[c];
+    Cache *l1 = core->l1;
+    int setNumber = indexSet(block, l1);
+    int way = searchSet(block, setNumber, l1);
+    if(way < 0) return 0;
+    size_t index = (size_t) setNumber * l1->associativty + way;
+    int modified = core->mesi[index] == MESI_MODIFIED;
+    invalidateWay(setNumber, way, l1);
+    core->mesi[index] = MESI_INVALID;
+    if(remoteWrite) {
+        core->stats.invalidations++;
+        core->invalidated[block & (SHARING_FILTER - 1)] = block;
+    }
+    else core->stats.backInvalidations++;
+    return modified;
+}
+
+// Turns another core's Exclusive or Modified copy Shared, writing Modified data into the LLC
+void downgradeCopy(int c, unsigned long long int block, size_t llcWay, Multicore *multicore) {
+    Core *core = &multicore->cores[c];
+    Cache *l1 = core->l1;
+    int setNumber = indexSet(block, l1);
+    int way = searchSet(block, setNumber, l1);
+    if(way < 0) return;
+    size_t index = (size_t) setNumber * l1->associativty + way;
+    if(core->mesi[index] == MESI_SHARED) return;
+    if(core->mesi[index] == MESI_MODIFIED) multicore->llc->dirty[llcWay] = DIRTY;
+    multicore->interventions++;
+    core->mesi[index] = MESI_SHARED;
+    l1->dirty[index] = 0;
+}
+
+// Invalidates every copy of a line but the writer's; Modified data lands in the LLC
+void invalidateOthers(int c, unsigned long long int block, size_t llcWay, Multicore *multicore) {
+    unsigned int others = multicore->sharers[llcWay] & ~(1u << c);
+    for(int i = 0; i < multicore->count; i++) {
+        if(!(others & (1u << i))) continue;
+        if(dropCopy(i, block, 1, multicore)) {
+            multicore->llc->dirty[llcWay] = DIRTY;
+            multicore->interventions++;
+        }
+    }
+    multicore->sharers[llcWay] &= 1u << c;
+}
+
+// Interleaves one trace per core until every trace is exhausted
+void runMulticore(TraceReader **traces, int interleave, Multicore *multicore) {
+    int count = multicore->count, active = count;
+    Access *batches = (Access *) malloc((size_t) count * MULTICORE_BATCH * sizeof(Access));
+    unsigned long long int *times = (unsigned long long int *) malloc((size_t) count * MULTICORE_BATCH * sizeof(unsigned long long int));
+    int *sizes = (int *) calloc(count, sizeof(int)), *positions = (int *) calloc(count, sizeof(int));
+    char *done = (char *) calloc(count, sizeof(char));
+
+    int c = 0;
+    while(active > 0) {
+        // Refill any core that has run out of decoded records
+        for(int i = 0; i < count; i++) {
+            if(done[i] || positions[i] < sizes[i]) continue;
+            Access *batch = batches + (size_t) i * MULTICORE_BATCH;
+            sizes[i] = (interleave == INTERLEAVE_TIMESTAMP) ? readTimedAccesses(traces[i], batch, times + (size_t) i * MULTICORE_BATCH, MULTICORE_BATCH) : readAccesses(traces[i], batch, MULTICORE_BATCH);
+            positions[i] = 0;
+            if(sizes[i] <= 0) {
+                done[i] = 1;
+                active--;
+            }
+        }
+        if(active == 0) break;
+
+        // Round robin takes the next live core; timestamps take the earliest record (lowest core on ties)
+        if(interleave == INTERLEAVE_TIMESTAMP) {
+            c = -1;
+            for(int i = 0; i < count; i++) {
+                if(!done[i] && (c < 0 || times[(size_t) i * MULTICORE_BATCH + positions[i]] < times[(size_t) c * MULTICORE_BATCH + positions[c]])) c = i;
+            }
+        }
+        else while(done[c]) c = (c + 1) % count;
+
+        Access *access = &batches[(size_t) c * MULTICORE_BATCH + positions[c]++];
+        simulateCoreAccess(c, access->operation, access->address, multicore);
+        if(interleave == INTERLEAVE_ROUND_ROBIN) c = (c + 1) % count;
+    }
+    free(batches);
+    free(times);
+    free(sizes);
+    free(positions);
+    free(done);
+}
+
+// One line per core, then the LLC, coherence and memory traffic
+void printMulticoreStats(int interleave, Multicore *multicore) {
+    Cache *llc = multicore->llc;
+    printf("Multicore: %d cores, %s\n", multicore->count, (interleave == INTERLEAVE_TIMESTAMP) ? "timestamp" : "round robin");
+    printf("Core\tReads\tWrites\tMisses\tMissRatio\tSharingMisses\tUpgrades\tInvalidations\tBackInvalidations\tWritebacks\tLLCHits\tLLCMisses\tLLCLines\tAvgLLCLines\n");
+    long long int llcHits = 0, llcMisses = 0, invalidations = 0, upgrades = 0;
+    for(int c = 0; c < multicore->count; c++) {
+        CoreStats *stats = &multicore->cores[c].stats;
+        long long int accesses = stats->hits + stats->misses;
+        printf("%d\t%lld\t%lld\t%lld\t%.6f\t%lld\t%lld\t%lld\t%lld\t%lld\t%lld\t%lld\t%lld\t%.1f\n", c, stats->reads, stats->writes, stats->misses,
+            (accesses > 0) ? (double) stats->misses / (double) accesses : 0.0, stats->sharingMisses, stats->upgrades, stats->invalidations, stats->backInvalidations,
+            stats->writebacks, stats->llcHits, stats->llcMisses, stats->occupancy, (multicore->samples > 0) ? (double) stats->occupancySum / (double) multicore->samples : (double) stats->occupancy);
+        llcHits += stats->llcHits;
+        llcMisses += stats->llcMisses;
+        invalidations += stats->invalidations;
+        upgrades += stats->upgrades;
+    }
+    printf("LLC\tSize: %d\tAssoc: %d\tPolicy: %d\tHits: %lld\tMisses: %lld\tMissRatio: %.6f\tEvictions: %lld\tWritebacks: %lld\n", multicore->llcSize, llc->associativty, llc->replacementPolicy,
+        llcHits, llcMisses, (llcHits + llcMisses > 0) ? (double) llcMisses / (double) (llcHits + llcMisses) : 0.0, multicore->llcEvictions, multicore->llcWritebacks);
+    printf("Coherence\tInvalidations: %lld\tUpgrades: %lld\tInterventions: %lld\n", invalidations, upgrades, multicore->interventions);
+    printf("Memory\tReads: %lld\tWrites: %lld\tTraffic: %lld bytes\n", multicore->memoryReads, multicore->memoryWrites, (multicore->memoryReads + multicore->memoryWrites) * multicore->blockSize);
+}
+
+// De-allocate the cores, the LLC and the directory
+Multicore *deleteMulticore(Multicore *multicore) {
+    for(int c = 0; c < multicore->count; c++) {
+        clearCache(multicore->cores[c].l1);
+        free(multicore->cores[c].mesi);
+        free(multicore->cores[c].invalidated);
+    }
+    clearCache(multicore->llc);
+    free(multicore->sharers);
+    free(multicore->owner);
+    free(multicore);
+    return NULL;
+}
@@ -0,0 +1,142 @@
+// Esperandieu Elbon II - UCFID: 5401262
+// EEL4768 Computer Architecture - Suboh Suboh - Fall 2023
+// Set-Partitioned Parallel Cache Simulation
+//
+// Sets never interact, so each worker thread owns a contiguous range of every cache's sets.
+// The calling thread parses the trace and routes each access, in trace order, to the worker
+// owning its set through a single-producer single-consumer ring of batches. Every set sees
+// exactly the serial access sequence, and per-worker counters are summed at the end, so the
+// results match a serial run exactly. Build with -pthread.
+
+#include <stdlib.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+
+#define PARALLEL_BATCH 2048     // Accesses per ring slot
+#define PARALLEL_DEPTH 8        // Slots per worker ring
+#define MAX_THREADS 256
+#define PARALLEL_LINE 64        // Host cache line size in bytes, for padding the ring indices
+
+// An access already split into tag and set, tagged with the cache it belongs to
+typedef struct Routed {
+    unsigned long long int tag;
+    int setNumber;
+    short cache;
+    char operation;
+} Routed;
+
+// Worker: one SPSC ring of batches and private counters for each cache
+typedef struct Worker {
+    Routed *slots;                  // PARALLEL_DEPTH * PARALLEL_BATCH accesses
+    int sizes[PARALLEL_DEPTH];      // Accesses published in each slot
+    char headPad[PARALLEL_LINE];
+    atomic_ulong head;              // Slots consumed by the worker, alone on its cache line
+    char tailPad[PARALLEL_LINE - sizeof(atomic_ulong)];
+    atomic_ulong tail;              // Slots published by the reader
+    atomic_int done;                // Set by the reader after the last slot is published
+    Cache **caches;
+    Stats *stats;                   // Private counters, one per cache
+    int count;
+    pthread_t thread;
+} Worker;
+
+void *runWorker(void *arg);
+void publishSlot(Worker *worker, int fill);
+void waitForSlot(Worker *worker);
+int runParallelSweep(Cache **caches, int count, TraceReader *trace, int threads);
+
+// Worker thread: drain published slots until the reader is done
+void *runWorker(void *arg) {
+    Worker *worker = (Worker *) arg;
+    unsigned long head = 0;
+    for(;;) {
+        unsigned long tail = atomic_load_explicit(&worker->tail, memory_order_acquire);
+        if(head == tail) {
+            if(atomic_load_explicit(&worker->done, memory_order_acquire) && head == atomic_load_explicit(&worker->tail, memory_order_acquire)) break;
+            sched_yield();
+            continue;
+        }
+
+        // Simulate the slot, then hand it back to the reader
+        int slot = (int) (head % PARALLEL_DEPTH), size = worker->sizes[slot];
+        Routed *batch = worker->slots + (size_t) slot * PARALLEL_BATCH;
+        for(int i = 0; i < size; i++) accessCacheSet(batch[i].operation, batch[i].tag, batch[i].setNumber, worker->caches[batch[i].cache], &worker->stats[batch[i].cache]);
+        head++;
+        atomic_store_explicit(&worker->head, head, memory_order_release);
+    }
+    return NULL;
+}
+
+// Reader side: block until the worker has a free slot to fill
+void waitForSlot(Worker *worker) {
+    unsigned long tail = atomic_load_explicit(&worker->tail, memory_order_relaxed);
+    while(tail - atomic_load_explicit(&worker->head, memory_order_acquire) >= PARALLEL_DEPTH) sched_yield();
+}
+
+// Reader side: publish the slot being filled
+void publishSlot(Worker *worker, int fill) {
+    unsigned long tail = atomic_load_explicit(&worker->tail, memory_order_relaxed);
+    worker->sizes[tail % PARALLEL_DEPTH] = fill;
+    atomic_store_explicit(&worker->tail, tail + 1, memory_order_release);
+}
+
+// Simulates the rest of the trace on every cache with the indicated number of workers,
+// accumulating into each cache's own counters. Returns 1 on success
+int runParallelSweep(Cache **caches, int count, TraceReader *trace, int threads) {
+    if(threads > MAX_THREADS) threads = MAX_THREADS;
+    Worker *workers = (Worker *) calloc(threads, sizeof(Worker));
+    int *fill = (int *) calloc(threads, sizeof(int));
+    for(int w = 0; w < threads; w++) {
+        workers[w].slots = (Routed *) malloc((size_t) PARALLEL_DEPTH * PARALLEL_BATCH * sizeof(Routed));
+        atomic_init(&workers[w].head, 0);
+        atomic_init(&workers[w].tail, 0);
+        atomic_init(&workers[w].done, 0);
+        workers[w].caches = caches;
+        workers[w].stats = (Stats *) calloc(count, sizeof(Stats));
+        workers[w].count = count;
+        pthread_create(&workers[w].thread, NULL, runWorker, &workers[w]);
+    }
+
+    // Parse and route: set s of a cache with S sets belongs to worker s * threads / S
+    Access *batch = (Access *) malloc(PARALLEL_BATCH * sizeof(Access));
+    int size;
+    while((size = readAccesses(trace, batch, PARALLEL_BATCH)) > 0) {
+        for(int j = 0; j < size; j++) {
+            for(int i = 0; i < count; i++) {
+                unsigned long long int tag = batch[j].address >> caches[i]->blockShift;
+                int setNumber = indexSet(tag, caches[i]);
+                int w = (int) ((long long int) setNumber * threads / caches[i]->numberOfSets);
+                Worker *worker = &workers[w];
+                if(fill[w] == 0) waitForSlot(worker);
+
+                unsigned long tail = atomic_load_explicit(&worker->tail, memory_order_relaxed);
+                Routed *routed = worker->slots + (size_t) (tail % PARALLEL_DEPTH) * PARALLEL_BATCH + fill[w];
+                routed->tag = tag;
+                routed->setNumber = setNumber;
+                routed->cache = (short) i;
+                routed->operation = batch[j].operation;
+                if(++fill[w] == PARALLEL_BATCH) {
+                    publishSlot(worker, fill[w]);
+                    fill[w] = 0;
+                }
+            }
+        }
+    }
+
+    // Flush partial slots, stop the workers and merge their counters
+    for(int w = 0; w < threads; w++) {
+        if(fill[w] > 0) publishSlot(&workers[w], fill[w]);
+        atomic_store_explicit(&workers[w].done, 1, memory_order_release);
+    }
+    for(int w = 0; w < threads; w++) {
+        pthread_join(workers[w].thread, NULL);
+        for(int i = 0; i < count; i++) addStats(&workers[w].stats[i], &caches[i]->stats);
+        free(workers[w].slots);
+        free(workers[w].stats);
+    }
+    free(batch);
+    free(fill);
+    free(workers);
+    return 1;
+}
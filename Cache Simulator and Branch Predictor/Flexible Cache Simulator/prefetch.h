@@ -0,0 +1,277 @@
+// Esperandieu Elbon II - UCFID: 5401262
+// EEL4768 Computer Architecture - Suboh Suboh - Fall 2023
+// Hardware Prefetchers
+//
+// A prefetcher watches the demand block stream of one cache (the trace carries no PCs) and
+// calls prefetchBlock() for the lines it predicts. Prefetched lines are marked, so cachebase.h
+// counts the ones a demand access later hits (useful), the ones evicted untouched (unused) and
+// the demand misses on lines a prefetch pushed out (pollution). Prefetch fills count as reads.
+//   - Next line: on a miss or first hit to a prefetched line, fetch the next <degree> lines.
+//   - Stride: per 4KB region, the delta between successive blocks; once the same delta is seen
+//     twice in a row, fetch <degree> strides ahead.
+//   - Stream: trackers follow misses that move in one direction within a small window and run
+//     a frontier up to <degree> lines ahead of the latest access.
+//   - Best offset (Michaud, HPCA 2016): tests candidate offsets against a table of recent
+//     accesses, and prefetches with whichever scored best in the last learning phase.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define NO_PREFETCH 0
+#define NEXT_LINE 1
+#define STRIDE 2
+#define STREAM 3
+#define BEST_OFFSET 4
+#define NUM_PREFETCHERS 5
+#define MAX_DEGREE 64
+#define STRIDE_ENTRIES 64       // Direct-mapped region table, power of 2
+#define STRIDE_REGION 12        // log2 of the bytes a stride entry tracks
+#define STRIDE_CONFIDENT 1      // Repeats of a delta before it is trusted
+#define STREAM_TRACKERS 16
+#define STREAM_WINDOW 16        // A miss this many lines from a stream's last access joins it
+#define BO_RR_ENTRIES 256       // Recent requests table, power of 2
+#define BO_SCORE_MAX 31
+#define BO_ROUND_MAX 100
+#define BO_BAD_SCORE 1
+
+// Stride: one entry per recently touched region
+typedef struct StrideEntry {
+    unsigned long long int region, last;
+    long long int stride;
+    int confidence;
+} StrideEntry;
+
+typedef struct StridePrefetcher {
+    int degree, regionShift;
+    StrideEntry entries[STRIDE_ENTRIES];
+} StridePrefetcher;
+
+// Stream: a tracked stream and how far ahead it has been prefetched
+typedef struct StreamTracker {
+    unsigned long long int last, frontier, used;
+    int direction, confidence, valid;
+} StreamTracker;
+
+typedef struct StreamPrefetcher {
+    int degree;
+    unsigned long long int clock;
+    StreamTracker trackers[STREAM_TRACKERS];
+} StreamPrefetcher;
+
+// Best offset: candidate offsets, their scores this phase and the recent requests table
+static const int boOffsets[] = {1, 2, 3, 4, 5, 6, 8, 9, 10, 12, 15, 16, 18, 20, 24, 25, 27, 30, 32, 36, 40, 45, 48, 50, 54, 60, 64};
+#define BO_OFFSETS ((int) (sizeof(boOffsets) / sizeof(boOffsets[0])))
+
+typedef struct BestOffsetPrefetcher {
+    int degree, offset;             // Offset in use, 0 = prefetching off
+    int test, round;                // Offset under test and learning round
+    int scores[BO_OFFSETS];
+    unsigned long long int recent[BO_RR_ENTRIES];
+} BestOffsetPrefetcher;
+
+// Prefetcher Functions
+int parsePrefetcher(char *spec, int *kind, int *degree);
+const char *prefetcherName(int kind);
+void attachPrefetcher(Cache *cache, int kind, int degree);
+void nextLinePrefetch(unsigned long long int block, int result, Cache *cache);
+void stridePrefetch(unsigned long long int block, int result, Cache *cache);
+void streamPrefetch(unsigned long long int block, int result, Cache *cache);
+void bestOffsetPrefetch(unsigned long long int block, int result, Cache *cache);
+int recentIndex(unsigned long long int block);
+void printPrefetchStats(PrefetchStats *prefetch, Stats *stats);
+void printPrefetchLine(PrefetchStats *prefetch, Stats *stats);
+
+// Parses "<nextline|stride|stream|bestoffset>[:<degree>]". Returns 1 on success
+int parsePrefetcher(char *spec, int *kind, int *degree) {
+    static const int defaults[NUM_PREFETCHERS] = {0, 1, 2, 4, 1};
+    char *colon = strchr(spec, ':');
+    size_t length = colon ? (size_t) (colon - spec) : strlen(spec);
+    *kind = NO_PREFETCH;
+    for(int k = NEXT_LINE; k < NUM_PREFETCHERS; k++) {
+        if(strlen(prefetcherName(k)) == length && strncmp(spec, prefetcherName(k), length) == 0) *kind = k;
+    }
+    if(*kind == NO_PREFETCH) return 0;
+    *degree = colon ? (int) strtol(colon + 1, NULL, 0) : defaults[*kind];
+    return *degree >= 1 && *degree <= MAX_DEGREE;
+}
+
+// Option name of a prefetcher
+const char *prefetcherName(int kind) {
+    static const char *names[NUM_PREFETCHERS] = {"none", "nextline", "stride", "stream", "bestoffset"};
+    return (kind >= 0 && kind < NUM_PREFETCHERS) ? names[kind] : "none";
+}
+
+// Gives a cache a prefetcher and the per-way bookkeeping that tracks its lines
+void attachPrefetcher(Cache *cache, int kind, int degree) {
+    size_t ways = (size_t) cache->numberOfSets * cache->associativty;
+    if(kind == NO_PREFETCH) return;
+    cache->prefetched = (unsigned char *) calloc(ways, sizeof(unsigned char));
+    cache->issuedAt = (unsigned long long int *) calloc(ways, sizeof(unsigned long long int));
+    cache->evicted = (unsigned long long int *) malloc(POLLUTION_FILTER * sizeof(unsigned long long int));
+    for(int i = 0; i < POLLUTION_FILTER; i++) cache->evicted[i] = INVALID_TAG;
+
+    if(kind == NEXT_LINE) {
+        int *state = (int *) malloc(sizeof(int));
+        *state = degree;
+        cache->prefetcher = state;
+        cache->prefetch = nextLinePrefetch;
+    }
+    else if(kind == STRIDE) {
+        StridePrefetcher *state = (StridePrefetcher *) calloc(1, sizeof(StridePrefetcher));
+        state->degree = degree;
+        state->regionShift = (STRIDE_REGION > cache->blockShift) ? STRIDE_REGION - cache->blockShift : 0;
+        for(int i = 0; i < STRIDE_ENTRIES; i++) state->entries[i].region = INVALID_TAG;
+        cache->prefetcher = state;
+        cache->prefetch = stridePrefetch;
+    }
+    else if(kind == STREAM) {
+        StreamPrefetcher *state = (StreamPrefetcher *) calloc(1, sizeof(StreamPrefetcher));
+        state->degree = degree;
+        cache->prefetcher = state;
+        cache->prefetch = streamPrefetch;
+    }
+    else {
+        BestOffsetPrefetcher *state = (BestOffsetPrefetcher *) calloc(1, sizeof(BestOffsetPrefetcher));
+        state->degree = degree;
+        state->offset = 1;
+        for(int i = 0; i < BO_RR_ENTRIES; i++) state->recent[i] = INVALID_TAG;
+        cache->prefetcher = state;
+        cache->prefetch = bestOffsetPrefetch;
+    }
+}
+
+// Next line: sequential lines after a miss or a first hit on a prefetched line
+void nextLinePrefetch(unsigned long long int block, int result, Cache *cache) {
+    if(result == HIT) return;
+    int degree = *(int *) cache->prefetcher;
+    for(int k = 1; k <= degree; k++) prefetchBlock(block + k, cache);
+}
+
+// Stride: train on every access, prefetch once a region's delta repeats
+void stridePrefetch(unsigned long long int block, int result, Cache *cache) {
+    (void) result;
+    StridePrefetcher *state = (StridePrefetcher *) cache->prefetcher;
+    unsigned long long int region = block >> state->regionShift;
+    StrideEntry *entry = &state->entries[region & (STRIDE_ENTRIES - 1)];
+
+    // New region: start over from this block
+    if(entry->region != region) {
+        entry->region = region;
+        entry->last = block;
+        entry->stride = 0;
+        entry->confidence = 0;
+        return;
+    }
+    long long int delta = (long long int) (block - entry->last);
+    if(delta == 0) return;
+    if(delta == entry->stride) {
+        if(entry->confidence < 3) entry->confidence++;
+    }
+    else {
+        entry->stride = delta;
+        entry->confidence = 0;
+    }
+    entry->last = block;
+    if(entry->confidence < STRIDE_CONFIDENT) return;
+    for(int k = 1; k <= state->degree; k++) prefetchBlock(block + (unsigned long long int) (entry->stride * k), cache);
+}
+
+// Stream: follow misses (and prefetched hits) moving in one direction, keep the frontier ahead
+void streamPrefetch(unsigned long long int block, int result, Cache *cache) {
+    if(result == HIT) return;
+    StreamPrefetcher *state = (StreamPrefetcher *) cache->prefetcher;
+    state->clock++;
+
+    // Find the stream this access continues, else replace the least recently used tracker
+    StreamTracker *tracker = NULL, *oldest = &state->trackers[0];
+    for(int i = 0; i < STREAM_TRACKERS; i++) {
+        StreamTracker *t = &state->trackers[i];
+        if(t->valid && block != t->last && block + STREAM_WINDOW >= t->last && block <= t->last + STREAM_WINDOW) {
+            tracker = t;
+            break;
+        }
+        if(!t->valid || (oldest->valid && t->used < oldest->used)) oldest = t;
+    }
+    if(tracker == NULL) {
+        oldest->valid = 1;
+        oldest->last = oldest->frontier = block;
+        oldest->direction = oldest->confidence = 0;
+        oldest->used = state->clock;
+        return;
+    }
+
+    // Two steps the same way make a stream
+    int direction = (block > tracker->last) ? 1 : -1;
+    if(direction == tracker->direction) tracker->confidence = 1;
+    else {
+        tracker->direction = direction;
+        tracker->confidence = 0;
+        tracker->frontier = block;
+    }
+    tracker->last = block;
+    tracker->used = state->clock;
+    if(!tracker->confidence) return;
+
+    // Advance the frontier to degree lines past this access
+    unsigned long long int target = block + (unsigned long long int) ((long long int) direction * state->degree);
+    if(direction > 0 ? tracker->frontier < block : tracker->frontier > block) tracker->frontier = block;
+    while(tracker->frontier != target) {
+        tracker->frontier += (unsigned long long int) (long long int) direction;
+        prefetchBlock(tracker->frontier, cache);
+    }
+}
+
+// Recent requests table slot of a block
+int recentIndex(unsigned long long int block) {
+    return (int) ((block ^ (block >> 8)) & (BO_RR_ENTRIES - 1));
+}
+
+// Best offset: score one candidate offset per trigger, switch offsets at the end of each phase
+void bestOffsetPrefetch(unsigned long long int block, int result, Cache *cache) {
+    if(result == HIT) return;
+    BestOffsetPrefetcher *state = (BestOffsetPrefetcher *) cache->prefetcher;
+
+    // Would the offset under test have prefetched this block in time?
+    unsigned long long int base = block - (unsigned long long int) boOffsets[state->test];
+    int endPhase = 0;
+    if(state->recent[recentIndex(base)] == base && ++state->scores[state->test] >= BO_SCORE_MAX) endPhase = 1;
+    if(++state->test == BO_OFFSETS) {
+        state->test = 0;
+        if(++state->round >= BO_ROUND_MAX) endPhase = 1;
+    }
+    if(endPhase) {
+        int best = 0;
+        for(int i = 1; i < BO_OFFSETS; i++) if(state->scores[i] > state->scores[best]) best = i;
+        state->offset = (state->scores[best] > BO_BAD_SCORE) ? boOffsets[best] : 0;
+        memset(state->scores, 0, sizeof(state->scores));
+        state->test = state->round = 0;
+    }
+
+    // Prefetch fills complete immediately here, so the trigger itself goes in the table
+    state->recent[recentIndex(block)] = block;
+    if(state->offset == 0) return;
+    for(int k = 1; k <= state->degree; k++) prefetchBlock(block + (unsigned long long int) state->offset * k, cache);
+}
+
+// Single test report of a cache's prefetch counters
+void printPrefetchStats(PrefetchStats *prefetch, Stats *stats) {
+    long long int covered = prefetch->useful + stats->misses;
+    printf("Prefetches: \t%lld\n", prefetch->issued);
+    printf("Accuracy: \t%.6f\n", prefetch->issued ? (double) prefetch->useful / prefetch->issued : 0.0);
+    printf("Coverage: \t%.6f\n", covered ? (double) prefetch->useful / covered : 0.0);
+    printf("Late: \t\t%.6f\n", prefetch->useful ? (double) prefetch->late / prefetch->useful : 0.0);
+    printf("Distance: \t%.1f\n", prefetch->useful ? (double) prefetch->distance / prefetch->useful : 0.0);
+    printf("Unused: \t%lld\n", prefetch->unused);
+    printf("Pollution: \t%lld\n", prefetch->pollution);
+}
+
+// Sweep report line under a configuration: issued, accuracy, coverage, late, unused, pollution
+void printPrefetchLine(PrefetchStats *prefetch, Stats *stats) {
+    long long int covered = prefetch->useful + stats->misses;
+    printf("\t\tprefetch:\t%lld", prefetch->issued);
+    printf("\t%.6f", prefetch->issued ? (double) prefetch->useful / prefetch->issued : 0.0);
+    printf("\t%.6f", covered ? (double) prefetch->useful / covered : 0.0);
+    printf("\t%.6f", prefetch->useful ? (double) prefetch->late / prefetch->useful : 0.0);
+    printf("\t%lld\t%lld\n", prefetch->unused, prefetch->pollution);
+}
@@ -0,0 +1,119 @@
+// Esperandieu Elbon II - UCFID: 5401262
+// EEL4768 Computer Architecture - Suboh Suboh - Fall 2023
+// Interval Statistics and Per-Set Heat Maps
+//
+// With recording enabled a cache snapshots its counters every intervalLength demand accesses
+// (one copy of Stats per interval) and counts hits, misses and evictions per set (one branch
+// per access). Interval rows show program phases; set rows show conflict-hot sets that an
+// index hash or more associativity would relieve.
+//
+// CSV output is two files, <prefix>-intervals.csv and <prefix>-sets.csv, with the sweep
+// position of each configuration in the first column. The binary dump <prefix>.bin holds, per
+// configuration: int config, int sets, long long intervalLength, int intervals, then the
+// intervals as Stats deltas and the sets as SetStats, all in native byte order after an
+// 8 byte RECORD_MAGIC header.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define DEFAULT_INTERVAL 1000000
+#define RECORD_MAGIC "CSIMREC1"
+
+// Open output of one recorded run
+typedef struct Recorder {
+    FILE *intervals, *sets;         // CSV files, or NULL
+    FILE *binary;                   // Binary dump, or NULL
+} Recorder;
+
+// Record Functions
+void enableRecording(Cache *cache, long long int intervalLength);
+Stats intervalDelta(Cache *cache, int interval);
+int recordedIntervals(Cache *cache);
+int openRecorder(char *prefix, int binary, Recorder *recorder);
+void writeRecord(Recorder *recorder, int config, Cache *cache);
+void closeRecorder(Recorder *recorder);
+
+// Turns on interval snapshots and per-set counters for a cache
+void enableRecording(Cache *cache, long long int intervalLength) {
+    cache->setStats = (SetStats *) calloc(cache->numberOfSets, sizeof(SetStats));
+    cache->intervalLength = intervalLength;
+    cache->intervalClock = 0;
+}
+
+// Intervals recorded so far, counting a trailing partial interval
+int recordedIntervals(Cache *cache) {
+    return cache->intervalCount + (cache->intervalClock > 0);
+}
+
+// Counters of one interval: the difference between its snapshot and the one before
+Stats intervalDelta(Cache *cache, int interval) {
+    Stats end = (interval < cache->intervalCount) ? cache->intervals[interval] : cache->stats, delta = end;
+    if(interval > 0) {
+        Stats *start = &cache->intervals[interval - 1];
+        delta.hits -= start->hits;
+        delta.misses -= start->misses;
+        delta.reads -= start->reads;
+        delta.writes -= start->writes;
+    }
+    return delta;
+}
+
+// Opens the CSV pair (with headers) or the binary dump for a prefix. Returns 1 on success
+int openRecorder(char *prefix, int binary, Recorder *recorder) {
+    char path[1024];
+    memset(recorder, 0, sizeof(Recorder));
+    if(binary) {
+        snprintf(path, sizeof(path), "%s.bin", prefix);
+        recorder->binary = fopen(path, "wb");
+        if(!recorder->binary) return 0;
+        fwrite(RECORD_MAGIC, 1, 8, recorder->binary);
+        return 1;
+    }
+    snprintf(path, sizeof(path), "%s-intervals.csv", prefix);
+    recorder->intervals = fopen(path, "w");
+    snprintf(path, sizeof(path), "%s-sets.csv", prefix);
+    recorder->sets = fopen(path, "w");
+    if(!recorder->intervals || !recorder->sets) {
+        closeRecorder(recorder);
+        return 0;
+    }
+    fprintf(recorder->intervals, "config,interval,accesses,hits,misses,missRatio,reads,writes\n");
+    fprintf(recorder->sets, "config,set,hits,misses,evictions\n");
+    return 1;
+}
+
+// Writes one cache's intervals and sets
+void writeRecord(Recorder *recorder, int config, Cache *cache) {
+    int count = recordedIntervals(cache);
+    if(recorder->binary) {
+        fwrite(&config, sizeof(int), 1, recorder->binary);
+        fwrite(&cache->numberOfSets, sizeof(int), 1, recorder->binary);
+        fwrite(&cache->intervalLength, sizeof(long long int), 1, recorder->binary);
+        fwrite(&count, sizeof(int), 1, recorder->binary);
+        for(int i = 0; i < count; i++) {
+            Stats delta = intervalDelta(cache, i);
+            fwrite(&delta, sizeof(Stats), 1, recorder->binary);
+        }
+        fwrite(cache->setStats, sizeof(SetStats), cache->numberOfSets, recorder->binary);
+        return;
+    }
+    for(int i = 0; i < count; i++) {
+        Stats delta = intervalDelta(cache, i);
+        long long int accesses = delta.hits + delta.misses;
+        fprintf(recorder->intervals, "%d,%d,%lld,%lld,%lld,%.6f,%lld,%lld\n", config, i, accesses, delta.hits, delta.misses,
+            (accesses > 0) ? (double) delta.misses / (double) accesses : 0.0, delta.reads, delta.writes);
+    }
+    for(int s = 0; s < cache->numberOfSets; s++) {
+        SetStats *set = &cache->setStats[s];
+        fprintf(recorder->sets, "%d,%d,%lld,%lld,%lld\n", config, s, set->hits, set->misses, set->evictions);
+    }
+}
+
+// Closes whatever the recorder has open
+void closeRecorder(Recorder *recorder) {
+    if(recorder->intervals) fclose(recorder->intervals);
+    if(recorder->sets) fclose(recorder->sets);
+    if(recorder->binary) fclose(recorder->binary);
+    memset(recorder, 0, sizeof(Recorder));
+}
@@ -0,0 +1,476 @@
+// Esperandieu Elbon II - UCFID: 5401262
+// EEL4768 Computer Architecture - Suboh Suboh - Fall 2023
+// Reuse Distance and Working Set Analysis
+//
+// One pass over a cache trace yields:
+//   - the reuse (LRU stack) distance histogram in blocks, log2 buckets, and from it the fully
+//     associative LRU miss ratio of every power of two cache size
+//   - the working set (distinct blocks) of every window of <Interval> accesses
+//   - reads and writes per aligned region
+// Distances use a Fenwick tree over access times holding a 1 at each block's latest access:
+// the distance of a reuse is the number of 1s after the block's previous access. Times are
+// renumbered (compacted) whenever the tree fills, so memory stays proportional to the blocks
+// tracked and each access costs O(log M) for M distinct blocks.
+//
+// Sampling follows SHARDS: a block is tracked only if a hash of its address falls below a
+// threshold, giving a rate R; each sampled access counts 1/R times at distance d/R. A fixed
+// rate bounds nothing, so the bounded mode starts at R = 1 and, whenever more than <Blocks>
+// blocks are tracked, drops the blocks with the largest hashes and lowers the threshold to match.
+// Region counts are always exact.
+//
+// Output is four CSV files: <prefix>-reuse.csv, <prefix>-mrc.csv, <prefix>-workingset.csv and
+// <prefix>-regions.csv.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define REUSE_EXACT 0
+#define REUSE_FIXED_RATE 1
+#define REUSE_BOUNDED 2
+#define SHARDS_MODULUS (1ULL << 24)         // Sampling hashes are 24 bits
+#define REUSE_BUCKETS 65                    // Bucket 0: distance 0, bucket k: [2^(k-1), 2^k)
+#define REUSE_INITIAL_CAPACITY (1 << 16)    // Power of 2
+#define DEFAULT_REGION_SIZE (1 << 20)
+
+// A tracked block: its latest access time (0 marks an empty entry) and latest window
+typedef struct ReuseEntry {
+    unsigned long long int block;
+    unsigned long long int last;
+    long long int window;
+} ReuseEntry;
+
+// Access counts of one region (reads + writes == 0 marks an empty entry)
+typedef struct RegionEntry {
+    unsigned long long int region;
+    long long int reads, writes;
+} RegionEntry;
+
+// A tracked block in the bounded mode's max-heap of sampling hashes
+typedef struct SampledBlock {
+    unsigned long long int hash, block;
+} SampledBlock;
+
+// Counters of one working set window
+typedef struct WindowStats {
+    long long int accesses, reads, writes;
+    double blocks;                  // Distinct blocks (estimated when sampled)
+} WindowStats;
+
+typedef struct ReuseProfile {
+    int blockShift, regionShift, mode;
+    unsigned long long int threshold;   // Blocks whose sampling hash is below it are tracked
+    long long int maxBlocks;            // Bounded mode's limit on tracked blocks
+
+    // Tracked blocks: open addressing, linear probing, kept under half full
+    ReuseEntry *entries;
+    size_t capacity, count;
+
+    // Fenwick tree over times 1 .. positions, and the block accessed at each time
+    int *tree;
+    unsigned long long int *blockAt;
+    size_t positions, clock;
+
+    // Bounded mode: tracked blocks by sampling hash, largest first
+    SampledBlock *heap;
+    size_t heapCount;
+
+    // Weighted histogram, cold (first) accesses, and trace totals
+    double histogram[REUSE_BUCKETS], cold;
+    long long int accesses, reads, writes;
+
+    // Working set windows
+    long long int windowLength;
+    WindowStats *windows;
+    int windowCount, windowCapacity;
+    WindowStats current;
+
+    // Regions: open addressing, kept under half full
+    RegionEntry *regions;
+    size_t regionCapacity, regionCount;
+} ReuseProfile;
+
+// Reuse Functions
+ReuseProfile *createReuseProfile(int blockSize, int regionSize, long long int windowLength, int mode, double rate, long long int maxBlocks);
+int parseReuseSampling(char *spec, int *mode, double *rate, long long int *maxBlocks);
+unsigned long long int sampleHash(unsigned long long int block);
+size_t reuseSlot(unsigned long long int key, size_t capacity);
+ReuseEntry *findReuseEntry(unsigned long long int block, ReuseProfile *profile);
+void growReuseEntries(ReuseProfile *profile);
+void removeReuseEntry(ReuseEntry *entry, ReuseProfile *profile);
+void fenwickAdd(size_t position, int delta, ReuseProfile *profile);
+long long int fenwickPrefix(size_t position, ReuseProfile *profile);
+void compactReuse(ReuseProfile *profile);
+void pushSampledBlock(unsigned long long int hash, unsigned long long int block, ReuseProfile *profile);
+SampledBlock popSampledBlock(ReuseProfile *profile);
+void shrinkSample(ReuseProfile *profile);
+int reuseBucket(double distance);
+RegionEntry *findRegion(unsigned long long int region, ReuseProfile *profile);
+void countRegion(char operation, unsigned long long int address, ReuseProfile *profile);
+void closeWindow(ReuseProfile *profile);
+void recordReuse(char operation, unsigned long long int address, ReuseProfile *profile);
+double reuseRate(ReuseProfile *profile);
+double reuseBlocks(ReuseProfile *profile);
+int compareRegions(const void *a, const void *b);
+int writeReuseProfile(char *prefix, ReuseProfile *profile);
+void printReuseSummary(ReuseProfile *profile);
+ReuseProfile *deleteReuseProfile(ReuseProfile *profile);
+
+// Creates an empty profile. rate is the fixed sampling rate, maxBlocks the bounded mode's limit
+ReuseProfile *createReuseProfile(int blockSize, int regionSize, long long int windowLength, int mode, double rate, long long int maxBlocks) {
+    ReuseProfile *profile = (ReuseProfile *) calloc(1, sizeof(ReuseProfile));
+    profile->blockShift = blockShiftOf(blockSize);
+    profile->regionShift = blockShiftOf(regionSize);
+    profile->mode = mode;
+    profile->threshold = (mode == REUSE_FIXED_RATE) ? (unsigned long long int) (rate * (double) SHARDS_MODULUS) : SHARDS_MODULUS;
+    if(profile->threshold < 1) profile->threshold = 1;
+    profile->maxBlocks = maxBlocks;
+    profile->capacity = REUSE_INITIAL_CAPACITY;
+    profile->entries = (ReuseEntry *) calloc(profile->capacity, sizeof(ReuseEntry));
+    profile->positions = REUSE_INITIAL_CAPACITY;
+    profile->tree = (int *) calloc(profile->positions + 1, sizeof(int));
+    profile->blockAt = (unsigned long long int *) malloc((profile->positions + 1) * sizeof(unsigned long long int));
+    if(mode == REUSE_BOUNDED) profile->heap = (SampledBlock *) malloc((size_t) (maxBlocks + 1) * sizeof(SampledBlock));
+    profile->windowLength = windowLength;
+    profile->regionCapacity = 1024;
+    profile->regions = (RegionEntry *) calloc(profile->regionCapacity, sizeof(RegionEntry));
+    return profile;
+}
+
+// Parses "exact", "rate:<R>" (0 < R <= 1) or "max:<Blocks>". Returns 1 on success
+int parseReuseSampling(char *spec, int *mode, double *rate, long long int *maxBlocks) {
+    if(strcmp(spec, "exact") == 0) {
+        *mode = REUSE_EXACT;
+        return 1;
+    }
+    if(strncmp(spec, "rate:", 5) == 0) {
+        *mode = REUSE_FIXED_RATE;
+        *rate = strtod(spec + 5, NULL);
+        return *rate > 0.0 && *rate <= 1.0;
+    }
+    if(strncmp(spec, "max:", 4) == 0) {
+        *mode = REUSE_BOUNDED;
+        *maxBlocks = strtoll(spec + 4, NULL, 0);
+        return *maxBlocks > 0;
+    }
+    return 0;
+}
+
+// 24 bit sampling hash (splitmix64 finalizer), independent of the table hash
+unsigned long long int sampleHash(unsigned long long int block) {
+    block ^= block >> 30;
+    block *= 0xBF58476D1CE4E5B9ULL;
+    block ^= block >> 27;
+    block *= 0x94D049BB133111EBULL;
+    block ^= block >> 31;
+    return block >> 40;
+}
+
+// Home slot of a key in a power of two table
+size_t reuseSlot(unsigned long long int key, size_t capacity) {
+    return (size_t) ((key * 0x9E3779B97F4A7C15ULL) >> 20) & (capacity - 1);
+}
+
+// The block's entry, or the empty entry where it would go
+ReuseEntry *findReuseEntry(unsigned long long int block, ReuseProfile *profile) {
+    size_t mask = profile->capacity - 1, i = reuseSlot(block, profile->capacity);
+    while(profile->entries[i].last != 0 && profile->entries[i].block != block) i = (i + 1) & mask;
+    return &profile->entries[i];
+}
+
+// Doubles the block table
+void growReuseEntries(ReuseProfile *profile) {
+    ReuseEntry *old = profile->entries;
+    size_t oldCapacity = profile->capacity;
+    profile->capacity *= 2;
+    profile->entries = (ReuseEntry *) calloc(profile->capacity, sizeof(ReuseEntry));
+    for(size_t i = 0; i < oldCapacity; i++) {
+        if(old[i].last != 0) *findReuseEntry(old[i].block, profile) = old[i];
+    }
+    free(old);
+}
+
+// Deletes an entry, shifting later entries of its probe run back so lookups need no tombstones
+void removeReuseEntry(ReuseEntry *entry, ReuseProfile *profile) {
+    size_t mask = profile->capacity - 1, hole = (size_t) (entry - profile->entries), j = hole;
+    profile->entries[hole].last = 0;
+    profile->count--;
+    for(;;) {
+        j = (j + 1) & mask;
+        if(profile->entries[j].last == 0) return;
+        size_t home = reuseSlot(profile->entries[j].block, profile->capacity);
+
+        // Entry j may fill the hole unless its home lies cyclically in (hole, j]
+        int stays = (hole <= j) ? (home > hole && home <= j) : (home > hole || home <= j);
+        if(stays) continue;
+        profile->entries[hole] = profile->entries[j];
+        profile->entries[j].last = 0;
+        hole = j;
+    }
+}
+
+void fenwickAdd(size_t position, int delta, ReuseProfile *profile) {
+    for(; position <= profile->positions; position += position & (~position + 1)) profile->tree[position] += delta;
+}
+
+// Tracked blocks whose latest access is at or before position
+long long int fenwickPrefix(size_t position, ReuseProfile *profile) {
+    long long int sum = 0;
+    for(; position > 0; position -= position & (~position + 1)) sum += profile->tree[position];
+    return sum;
+}
+
+// Renumbers the latest accesses 1 .. count in time order and rebuilds the tree with at least as
+// many free times as tracked blocks
+void compactReuse(ReuseProfile *profile) {
+    size_t live = 0;
+    for(size_t t = 1; t <= profile->clock; t++) {
+        ReuseEntry *entry = findReuseEntry(profile->blockAt[t], profile);
+        if(entry->last != t) continue;
+        profile->blockAt[++live] = profile->blockAt[t];
+        entry->last = live;
+    }
+
+    size_t positions = REUSE_INITIAL_CAPACITY;
+    while(positions < 2 * live) positions *= 2;
+    if(positions != profile->positions) {
+        profile->positions = positions;
+        profile->tree = (int *) realloc(profile->tree, (positions + 1) * sizeof(int));
+        profile->blockAt = (unsigned long long int *) realloc(profile->blockAt, (positions + 1) * sizeof(unsigned long long int));
+    }
+
+    // Linear-time build: every time up to live holds a 1
+    for(size_t t = 1; t <= positions; t++) profile->tree[t] = (t <= live);
+    for(size_t t = 1; t <= positions; t++) {
+        size_t parent = t + (t & (~t + 1));
+        if(parent <= positions) profile->tree[parent] += profile->tree[t];
+    }
+    profile->clock = live;
+}
+
+void pushSampledBlock(unsigned long long int hash, unsigned long long int block, ReuseProfile *profile) {
+    size_t i = profile->heapCount++;
+    while(i > 0 && profile->heap[(i - 1) / 2].hash < hash) {
+        profile->heap[i] = profile->heap[(i - 1) / 2];
+        i = (i - 1) / 2;
+    }
+    profile->heap[i].hash = hash;
+    profile->heap[i].block = block;
+}
+
+// Removes and returns the tracked block with the largest hash
+SampledBlock popSampledBlock(ReuseProfile *profile) {
+    SampledBlock top = profile->heap[0], last = profile->heap[--profile->heapCount];
+    size_t i = 0;
+    for(;;) {
+        size_t child = 2 * i + 1;
+        if(child >= profile->heapCount) break;
+        if(child + 1 < profile->heapCount && profile->heap[child + 1].hash > profile->heap[child].hash) child++;
+        if(profile->heap[child].hash <= last.hash) break;
+        profile->heap[i] = profile->heap[child];
+        i = child;
+    }
+    if(profile->heapCount > 0) profile->heap[i] = last;
+    return top;
+}
+
+// Bounded mode: lowers the threshold until no more than maxBlocks blocks are tracked
+void shrinkSample(ReuseProfile *profile) {
+    while((long long int) profile->count > profile->maxBlocks || (profile->heapCount > 0 && profile->heap[0].hash >= profile->threshold)) {
+        SampledBlock dropped = popSampledBlock(profile);
+        if(dropped.hash < profile->threshold) profile->threshold = dropped.hash;
+        ReuseEntry *entry = findReuseEntry(dropped.block, profile);
+        fenwickAdd((size_t) entry->last, -1, profile);
+        removeReuseEntry(entry, profile);
+    }
+}
+
+// Histogram bucket of a (possibly scaled) distance
+int reuseBucket(double distance) {
+    int bucket = 0;
+    while(bucket < REUSE_BUCKETS - 1 && distance >= (double) (1ULL << bucket)) bucket++;
+    return bucket;
+}
+
+// The region's entry, or the empty entry where it would go
+RegionEntry *findRegion(unsigned long long int region, ReuseProfile *profile) {
+    size_t mask = profile->regionCapacity - 1, i = reuseSlot(region, profile->regionCapacity);
+    while(profile->regions[i].reads + profile->regions[i].writes != 0 && profile->regions[i].region != region) i = (i + 1) & mask;
+    return &profile->regions[i];
+}
+
+// Counts the access against its region
+void countRegion(char operation, unsigned long long int address, ReuseProfile *profile) {
+    if(2 * (profile->regionCount + 1) > profile->regionCapacity) {
+        RegionEntry *old = profile->regions;
+        size_t oldCapacity = profile->regionCapacity;
+        profile->regionCapacity *= 2;
+        profile->regions = (RegionEntry *) calloc(profile->regionCapacity, sizeof(RegionEntry));
+        for(size_t i = 0; i < oldCapacity; i++) {
+            if(old[i].reads + old[i].writes != 0) *findRegion(old[i].region, profile) = old[i];
+        }
+        free(old);
+    }
+    unsigned long long int region = address >> profile->regionShift;
+    RegionEntry *entry = findRegion(region, profile);
+    if(entry->reads + entry->writes == 0) {
+        entry->region = region;
+        profile->regionCount++;
+    }
+    if(operation == 'W') entry->writes++;
+    else entry->reads++;
+}
+
+// Stores the current working set window and starts the next
+void closeWindow(ReuseProfile *profile) {
+    if(profile->windowCount == profile->windowCapacity) {
+        profile->windowCapacity = (profile->windowCapacity == 0) ? 64 : 2 * profile->windowCapacity;
+        profile->windows = (WindowStats *) realloc(profile->windows, profile->windowCapacity * sizeof(WindowStats));
+    }
+    profile->windows[profile->windowCount++] = profile->current;
+    memset(&profile->current, 0, sizeof(WindowStats));
+}
+
+// One trace access. Instruction fetches and other operations count as reads
+void recordReuse(char operation, unsigned long long int address, ReuseProfile *profile) {
+    if(profile->current.accesses == profile->windowLength) closeWindow(profile);
+    int write = operation == 'W';
+    profile->accesses++;
+    profile->reads += !write;
+    profile->writes += write;
+    profile->current.accesses++;
+    profile->current.reads += !write;
+    profile->current.writes += write;
+    countRegion(operation, address, profile);
+
+    unsigned long long int block = address >> profile->blockShift, hash = 0;
+    if(profile->mode != REUSE_EXACT && (hash = sampleHash(block)) >= profile->threshold) return;
+    double weight = (double) SHARDS_MODULUS / (double) profile->threshold;
+
+    if(2 * (profile->count + 1) > profile->capacity) growReuseEntries(profile);
+    if(profile->clock == profile->positions) compactReuse(profile);
+    ReuseEntry *entry = findReuseEntry(block, profile);
+
+    // Reuse: every block accessed since the previous access is stacked above this one
+    if(entry->last != 0) {
+        long long int distance = (long long int) profile->count - fenwickPrefix((size_t) entry->last, profile);
+        fenwickAdd((size_t) entry->last, -1, profile);
+        profile->histogram[reuseBucket((double) distance * weight)] += weight;
+    }
+    else {
+        entry->block = block;
+        entry->window = -1;
+        profile->count++;
+        profile->cold += weight;
+        if(profile->mode == REUSE_BOUNDED) pushSampledBlock(hash, block, profile);
+    }
+    entry->last = ++profile->clock;
+    profile->blockAt[profile->clock] = block;
+    fenwickAdd(profile->clock, 1, profile);
+    if(entry->window != profile->windowCount) {
+        entry->window = profile->windowCount;
+        profile->current.blocks += weight;
+    }
+    if(profile->mode == REUSE_BOUNDED && (long long int) profile->count > profile->maxBlocks) shrinkSample(profile);
+}
+
+// Current sampling rate
+double reuseRate(ReuseProfile *profile) {
+    return (double) profile->threshold / (double) SHARDS_MODULUS;
+}
+
+// Distinct blocks in the trace (estimated when sampled)
+double reuseBlocks(ReuseProfile *profile) {
+    return profile->cold;
+}
+
+// Lowest address first
+int compareRegions(const void *a, const void *b) {
+    const RegionEntry *x = (const RegionEntry *) a, *y = (const RegionEntry *) b;
+    return (x->region > y->region) - (x->region < y->region);
+}
+
+// Writes the four CSV files. Returns 1 on success
+int writeReuseProfile(char *prefix, ReuseProfile *profile) {
+    char path[1024];
+    FILE *files[4];
+    const char *suffixes[4] = {"reuse", "mrc", "workingset", "regions"};
+    int ok = 1;
+    for(int f = 0; f < 4; f++) {
+        snprintf(path, sizeof(path), "%s-%s.csv", prefix, suffixes[f]);
+        files[f] = fopen(path, "w");
+        ok = ok && files[f] != NULL;
+    }
+    if(!ok) {
+        for(int f = 0; f < 4; f++) if(files[f]) fclose(files[f]);
+        return 0;
+    }
+    double total = (double) profile->accesses, weighted = profile->cold, *histogram = profile->histogram;
+    for(int b = 0; b < REUSE_BUCKETS; b++) weighted += histogram[b];
+    if(weighted <= 0.0) weighted = 1.0;
+
+    // Histogram up to the last used bucket, then the cold accesses
+    int used = 0;
+    for(int b = 0; b < REUSE_BUCKETS; b++) if(histogram[b] > 0.0) used = b + 1;
+    double cumulative = 0.0;
+    fprintf(files[0], "bucket,minDistance,maxDistance,accesses,fraction,cumulative\n");
+    for(int b = 0; b < used; b++) {
+        cumulative += histogram[b];
+        fprintf(files[0], "%d,%llu,%llu,%.0f,%.6f,%.6f\n", b, (b == 0) ? 0ULL : 1ULL << (b - 1), (b == 0) ? 0ULL : (1ULL << b) - 1,
+            histogram[b], histogram[b] / weighted, cumulative / weighted);
+    }
+    fprintf(files[0], "cold,,,%.0f,%.6f,1.000000\n", profile->cold, profile->cold / weighted);
+
+    // A fully associative LRU cache of 2^k blocks hits every distance below 2^k: buckets 0 .. k
+    fprintf(files[1], "cacheBytes,blocks,missRatio\n");
+    cumulative = 0.0;
+    for(int k = 0; k < REUSE_BUCKETS - 1; k++) {
+        cumulative += histogram[k];
+        fprintf(files[1], "%llu,%llu,%.6f\n", (1ULL << k) << profile->blockShift, 1ULL << k, 1.0 - cumulative / weighted);
+        if((double) (1ULL << k) >= reuseBlocks(profile)) break;
+    }
+
+    // Windows, the last one partial
+    fprintf(files[2], "window,accesses,reads,writes,blocks,bytes\n");
+    for(int w = 0; w <= profile->windowCount; w++) {
+        WindowStats *window = (w < profile->windowCount) ? &profile->windows[w] : &profile->current;
+        if(window->accesses == 0) continue;
+        fprintf(files[2], "%d,%lld,%lld,%lld,%.0f,%.0f\n", w, window->accesses, window->reads, window->writes, window->blocks, window->blocks * (double) (1 << profile->blockShift));
+    }
+
+    // Regions in address order
+    RegionEntry *regions = (RegionEntry *) malloc((profile->regionCount > 0 ? profile->regionCount : 1) * sizeof(RegionEntry));
+    size_t n = 0;
+    for(size_t i = 0; i < profile->regionCapacity; i++) if(profile->regions[i].reads + profile->regions[i].writes != 0) regions[n++] = profile->regions[i];
+    qsort(regions, n, sizeof(RegionEntry), compareRegions);
+    fprintf(files[3], "region,base,reads,writes,readFraction,shareOfAccesses\n");
+    for(size_t i = 0; i < n; i++) {
+        long long int accesses = regions[i].reads + regions[i].writes;
+        fprintf(files[3], "%llu,%llx,%lld,%lld,%.6f,%.6f\n", regions[i].region, regions[i].region << profile->regionShift, regions[i].reads, regions[i].writes,
+            (double) regions[i].reads / (double) accesses, (total > 0.0) ? (double) accesses / total : 0.0);
+    }
+    free(regions);
+
+    for(int f = 0; f < 4; f++) ok = (fclose(files[f]) == 0) && ok;
+    return ok;
+}
+
+// One line of totals
+void printReuseSummary(ReuseProfile *profile) {
+    printf("Accesses: %lld\tReads: %lld\tWrites: %lld\tBlocks: %.0f\tFootprint: %.0f bytes\tRegions: %zu\t", profile->accesses, profile->reads, profile->writes,
+        reuseBlocks(profile), reuseBlocks(profile) * (double) (1 << profile->blockShift), profile->regionCount);
+    if(profile->mode == REUSE_EXACT) printf("Sampling: exact\n");
+    else printf("Sampling: rate %.6f, %zu blocks tracked\n", reuseRate(profile), profile->count);
+}
+
+// De-allocate the profile
+ReuseProfile *deleteReuseProfile(ReuseProfile *profile) {
+    free(profile->entries);
+    free(profile->tree);
+    free(profile->blockAt);
+    free(profile->heap);
+    free(profile->windows);
+    free(profile->regions);
+    free(profile);
+    return NULL;
+}
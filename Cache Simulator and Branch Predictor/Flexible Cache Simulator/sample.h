@@ -0,0 +1,413 @@
+// Esperandieu Elbon II - UCFID: 5401262
+// EEL4768 Computer Architecture - Suboh Suboh - Fall 2023
+// Sampled Simulation with Functional Warming
+//
+// Only the accesses inside sample windows are simulated in detail and counted. Between windows
+// the caches are either functionally warmed (tags, replacement and dirty state updated, nothing
+// counted) or, with functional warming off, left alone until a short detailed warmup before
+// the next window. Skipped accesses are still parsed, so the big win is on binary traces.
+//   - Periodic: every <Period> accesses, the last <Detail> of them form a window. Windows are a
+//     systematic sample of one population, so the spread of their miss ratios gives the error.
+//   - SimPoint: a first pass cuts the trace into <Interval>-access intervals and describes each
+//     by a histogram of the 4KB pages it touches (the trace carries no PCs for basic block
+//     vectors). k-means groups similar intervals, and the intervals nearest each centroid are
+//     simulated. Clusters act as strata weighted by their share of accesses; a cluster with a
+//     single representative adds no variance term, so ask for two or more per cluster.
+// Estimates are rates per access scaled by the trace length, with 95% confidence half widths.
+// Build with -lm.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#define SAMPLE_NONE 0
+#define SAMPLE_PERIODIC 1
+#define SAMPLE_SIMPOINT 2
+#define SIMPOINT_DIMENSIONS 32
+#define SIMPOINT_CLUSTERS 8
+#define SIMPOINT_PER_CLUSTER 2
+#define KMEANS_ITERATIONS 25
+#define CONFIDENCE_Z 1.96
+
+// A detailed window of accesses [start, end) and the stratum it represents
+typedef struct SampleWindow {
+    long long int start, end;
+    int stratum;
+} SampleWindow;
+
+// What to sample and, once planned, where
+typedef struct SamplePlan {
+    int mode;
+    long long int period, detail;       // Periodic
+    long long int interval;             // SimPoint interval length
+    int clusters, perCluster;           // SimPoint
+    long long int warmup;               // Detailed warming before each window
+    int functional;                     // Functionally warm between windows
+
+    SampleWindow *windows;              // SimPoint windows in trace order
+    int windowCount, strata;
+    double *strataWeight;               // Share of all accesses in each stratum
+    double *strataUnits;                // Intervals in each stratum
+} SamplePlan;
+
+// Sampled estimate for one cache
+typedef struct SampleEstimate {
+    double missRatio, missHalf;         // Miss ratio and its 95% half width
+    double reads, readsHalf;            // Memory reads over the whole trace
+    double writes, writesHalf;          // Memory writes over the whole trace
+    long long int accesses, detailed;   // Trace length and accesses simulated in detail
+    int samples;
+} SampleEstimate;
+
+// Sample Functions
+int parseSamplePlan(char *spec, SamplePlan *plan);
+int planSimPoints(SamplePlan *plan, char *traceFile);
+double vectorDistance(double *a, double *b);
+SampleWindow *sampleWindow(SamplePlan *plan, int index, SampleWindow *scratch);
+void warmCacheAccess(char operation, unsigned long long int address, Cache *cache);
+int runSampledSweep(Cache **caches, int count, TraceReader *trace, SamplePlan *plan, Stats *results, SampleEstimate *estimates);
+void closeSampleWindow(Cache **caches, int count, Stats *before, long long int length, Stats **windows, long long int **lengths, int *closed, int *capacity);
+void estimateSample(SamplePlan *plan, Stats *windows, long long int *lengths, int windowCount, long long int total, SampleEstimate *estimate);
+void deleteSamplePlan(SamplePlan *plan);
+void printSampleEstimate(SampleEstimate *estimate);
+void printSampleLine(SampleEstimate *estimate);
+
+// Parses "periodic:<Period>:<Detail>" or "simpoint:<Interval>[:<Clusters>[:<Per Cluster>]]".
+// Warmup and functional warming are left as they are. Returns 1 on success
+int parseSamplePlan(char *spec, SamplePlan *plan) {
+    long long int fields[3] = {0, SIMPOINT_CLUSTERS, SIMPOINT_PER_CLUSTER};
+    char *cursor = strchr(spec, ':');
+    int n = 0;
+    while(cursor != NULL && n < 3) {
+        fields[n++] = strtoll(cursor + 1, NULL, 0);
+        cursor = strchr(cursor + 1, ':');
+    }
+    plan->windows = NULL;
+    plan->strataWeight = plan->strataUnits = NULL;
+    plan->windowCount = plan->strata = 0;
+    if(strncmp(spec, "periodic:", 9) == 0 && n == 2) {
+        plan->mode = SAMPLE_PERIODIC;
+        plan->period = fields[0];
+        plan->detail = fields[1];
+        return plan->detail >= 1 && plan->detail <= plan->period;
+    }
+    if(strncmp(spec, "simpoint:", 9) == 0 && n >= 1) {
+        plan->mode = SAMPLE_SIMPOINT;
+        plan->interval = fields[0];
+        plan->clusters = (int) fields[1];
+        plan->perCluster = (int) fields[2];
+        return plan->interval >= 1 && plan->clusters >= 1 && plan->perCluster >= 1;
+    }
+    return 0;
+}
+
+// Squared distance between two interval vectors
+double vectorDistance(double *a, double *b) {
+    double sum = 0.0;
+    for(int d = 0; d < SIMPOINT_DIMENSIONS; d++) sum += (a[d] - b[d]) * (a[d] - b[d]);
+    return sum;
+}
+
+// First pass for SimPoint: profile every interval, cluster them and pick the windows.
+// Returns 1 on success
+int planSimPoints(SamplePlan *plan, char *traceFile) {
+    TraceReader *trace = openTrace(traceFile);
+    if(!trace) return 0;
+
+    // Page histogram of each interval
+    int count = 0, capacity = 64;
+    double *vectors = (double *) calloc((size_t) capacity * SIMPOINT_DIMENSIONS, sizeof(double));
+    long long int *lengths = (long long int *) calloc(capacity, sizeof(long long int));
+    Access *batch = (Access *) malloc(4096 * sizeof(Access));
+    int size;
+    long long int total = 0;
+    while((size = readAccesses(trace, batch, 4096)) > 0) {
+        for(int j = 0; j < size; j++) {
+            int interval = (int) (total++ / plan->interval);
+            if(interval == capacity) {
+                capacity *= 2;
+                vectors = (double *) realloc(vectors, (size_t) capacity * SIMPOINT_DIMENSIONS * sizeof(double));
+                lengths = (long long int *) realloc(lengths, capacity * sizeof(long long int));
+                memset(vectors + (size_t) interval * SIMPOINT_DIMENSIONS, 0, (size_t) (capacity - interval) * SIMPOINT_DIMENSIONS * sizeof(double));
+                memset(lengths + interval, 0, (capacity - interval) * sizeof(long long int));
+            }
+            unsigned long long int page = batch[j].address >> 12;
+            vectors[(size_t) interval * SIMPOINT_DIMENSIONS + (int) ((page * 0x9E3779B97F4A7C15ULL) >> 59)] += 1.0;
+            lengths[interval]++;
+            if(interval + 1 > count) count = interval + 1;
+        }
+    }
+    free(batch);
+    closeTrace(trace);
+    if(count == 0) {
+        free(vectors);
+        free(lengths);
+        return 0;
+    }
+    for(int i = 0; i < count; i++) {
+        for(int d = 0; d < SIMPOINT_DIMENSIONS; d++) vectors[(size_t) i * SIMPOINT_DIMENSIONS + d] /= (double) lengths[i];
+    }
+
+    // k-means, seeded deterministically with the intervals farthest from the centroids so far
+    int k = (plan->clusters < count) ? plan->clusters : count;
+    double *centroids = (double *) malloc((size_t) k * SIMPOINT_DIMENSIONS * sizeof(double));
+    double *nearest = (double *) malloc(count * sizeof(double));
+    int *cluster = (int *) calloc(count, sizeof(int));
+    memcpy(centroids, vectors, SIMPOINT_DIMENSIONS * sizeof(double));
+    for(int i = 0; i < count; i++) nearest[i] = vectorDistance(vectors + (size_t) i * SIMPOINT_DIMENSIONS, centroids);
+    for(int c = 1; c < k; c++) {
+        int far = 0;
+        for(int i = 1; i < count; i++) if(nearest[i] > nearest[far]) far = i;
+        memcpy(centroids + (size_t) c * SIMPOINT_DIMENSIONS, vectors + (size_t) far * SIMPOINT_DIMENSIONS, SIMPOINT_DIMENSIONS * sizeof(double));
+        for(int i = 0; i < count; i++) {
+            double distance = vectorDistance(vectors + (size_t) i * SIMPOINT_DIMENSIONS, centroids + (size_t) c * SIMPOINT_DIMENSIONS);
+            if(distance < nearest[i]) nearest[i] = distance;
+        }
+    }
+    int *members = (int *) calloc(k, sizeof(int));
+    for(int iteration = 0; iteration < KMEANS_ITERATIONS; iteration++) {
+        int changed = 0;
+        for(int i = 0; i < count; i++) {
+            int best = 0;
+            nearest[i] = vectorDistance(vectors + (size_t) i * SIMPOINT_DIMENSIONS, centroids);
+            for(int c = 1; c < k; c++) {
+                double distance = vectorDistance(vectors + (size_t) i * SIMPOINT_DIMENSIONS, centroids + (size_t) c * SIMPOINT_DIMENSIONS);
+                if(distance < nearest[i]) {
+                    nearest[i] = distance;
+                    best = c;
+                }
+            }
+            changed |= (iteration == 0 || cluster[i] != best);
+            cluster[i] = best;
+        }
+        if(!changed) break;
+
+        // Move each centroid to the mean of its members; an emptied cluster keeps its centroid
+        memset(members, 0, k * sizeof(int));
+        for(int i = 0; i < count; i++) members[cluster[i]]++;
+        for(int c = 0; c < k; c++) {
+            if(members[c] > 0) memset(centroids + (size_t) c * SIMPOINT_DIMENSIONS, 0, SIMPOINT_DIMENSIONS * sizeof(double));
+        }
+        for(int i = 0; i < count; i++) {
+            for(int d = 0; d < SIMPOINT_DIMENSIONS; d++) centroids[(size_t) cluster[i] * SIMPOINT_DIMENSIONS + d] += vectors[(size_t) i * SIMPOINT_DIMENSIONS + d] / members[cluster[i]];
+        }
+    }
+
+    // Strata: one per cluster, weighted by its accesses. Windows: the intervals nearest each centroid
+    plan->strata = k;
+    plan->strataWeight = (double *) calloc(k, sizeof(double));
+    plan->strataUnits = (double *) calloc(k, sizeof(double));
+    plan->windows = (SampleWindow *) calloc(count, sizeof(SampleWindow));
+    char *chosen = (char *) calloc(count, sizeof(char));
+    for(int i = 0; i < count; i++) {
+        plan->strataWeight[cluster[i]] += (double) lengths[i] / (double) total;
+        plan->strataUnits[cluster[i]] += 1.0;
+    }
+    for(int c = 0; c < k; c++) {
+        for(int pick = 0; pick < plan->perCluster; pick++) {
+            int best = -1;
+            for(int i = 0; i < count; i++) {
+                if(cluster[i] == c && !chosen[i] && (best < 0 || nearest[i] < nearest[best])) best = i;
+            }
+            if(best < 0) break;
+            chosen[best] = 1;
+        }
+    }
+    plan->windowCount = 0;
+    for(int i = 0; i < count; i++) {
+        if(!chosen[i]) continue;
+        SampleWindow *window = &plan->windows[plan->windowCount++];
+        window->start = (long long int) i * plan->interval;
+        window->end = window->start + lengths[i];
+        window->stratum = cluster[i];
+    }
+
+    free(chosen);
+    free(members);
+    free(cluster);
+    free(nearest);
+    free(centroids);
+    free(lengths);
+    free(vectors);
+    return 1;
+}
+
+// The index-th window of a plan: periodic windows are generated, SimPoint windows looked up.
+// Returns NULL past the last window
+SampleWindow *sampleWindow(SamplePlan *plan, int index, SampleWindow *scratch) {
+    if(plan->mode == SAMPLE_SIMPOINT) return (index < plan->windowCount) ? &plan->windows[index] : NULL;
+    scratch->end = (long long int) (index + 1) * plan->period;
+    scratch->start = scratch->end - plan->detail;
+    scratch->stratum = 0;
+    return scratch;
+}
+
+// Functional warming: update the cache's contents and replacement state, counting nothing
+void warmCacheAccess(char operation, unsigned long long int address, Cache *cache) {
+    Stats scratch;
+    unsigned long long int tag = address >> cache->blockShift;
+    accessCacheSet(operation, tag, indexSet(tag, cache), cache, &scratch);
+}
+
+// Runs the trace through every cache under a sample plan, writing estimated totals to
+// results[i] and the estimate with its error bounds to estimates[i]. Returns 0 if no window was
+// simulated (the trace ended before the first one), leaving nothing to estimate from
+int runSampledSweep(Cache **caches, int count, TraceReader *trace, SamplePlan *plan, Stats *results, SampleEstimate *estimates) {
+    int capacity = 64, closed = 0;
+    Stats *windows = (Stats *) malloc((size_t) capacity * count * sizeof(Stats));
+    Stats *before = (Stats *) malloc(count * sizeof(Stats));
+    long long int *lengths = (long long int *) malloc(capacity * sizeof(long long int));
+    Access *batch = (Access *) malloc(4096 * sizeof(Access));
+    SampleWindow scratch, *window = sampleWindow(plan, 0, &scratch);
+    long long int t = 0, detailed = 0;
+    int size;
+    while((size = readAccesses(trace, batch, 4096)) > 0) {
+        int j = 0;
+        while(j < size) {
+            // Find how far the current phase runs within this batch
+            long long int until = t + (size - j);
+            int phase = 0;      // 0 = skip, 1 = warm, 2 = detailed
+            if(window == NULL) phase = plan->functional;
+            else if(t >= window->start) {
+                phase = 2;
+                until = window->end;
+                if(t == window->start) for(int i = 0; i < count; i++) before[i] = caches[i]->stats;
+            }
+            else if(plan->functional || t >= window->start - plan->warmup) {
+                phase = 1;
+                until = window->start;
+            }
+            else until = window->start - plan->warmup;
+            int run = (int) ((until - t < size - j) ? until - t : size - j);
+
+            for(int i = 0; i < count && phase > 0; i++) {
+                Cache *cache = caches[i];
+                if(phase == 2) for(int k = j; k < j + run; k++) simulateCacheAccess(batch[k].operation, batch[k].address, cache);
+                else for(int k = j; k < j + run; k++) warmCacheAccess(batch[k].operation, batch[k].address, cache);
+            }
+            if(phase == 2) detailed += run;
+            j += run;
+            t += run;
+
+            // Close a finished window
+            if(window != NULL && t == window->end) {
+                closeSampleWindow(caches, count, before, window->end - window->start, &windows, &lengths, &closed, &capacity);
+                window = sampleWindow(plan, closed, &scratch);
+            }
+        }
+    }
+
+    // A trace ending inside a window keeps what was simulated of it
+    if(window != NULL && t > window->start) closeSampleWindow(caches, count, before, t - window->start, &windows, &lengths, &closed, &capacity);
+
+    // Estimate each cache from its windows
+    Stats *column = (Stats *) malloc((closed > 0 ? closed : 1) * sizeof(Stats));
+    for(int i = 0; i < count; i++) {
+        for(int w = 0; w < closed; w++) column[w] = windows[(size_t) w * count + i];
+        estimateSample(plan, column, lengths, closed, t, &estimates[i]);
+        estimates[i].detailed = detailed;
+        long long int misses = llround(estimates[i].missRatio * (double) t);
+        results[i].misses = misses;
+        results[i].hits = t - misses;
+        results[i].reads = llround(estimates[i].reads);
+        results[i].writes = llround(estimates[i].writes);
+    }
+    free(column);
+    free(batch);
+    free(lengths);
+    free(before);
+    free(windows);
+    return closed > 0;
+}
+
+// Appends, for every cache, the counters gathered since before[] as one more window
+void closeSampleWindow(Cache **caches, int count, Stats *before, long long int length, Stats **windows, long long int **lengths, int *closed, int *capacity) {
+    if(*closed == *capacity) {
+        *capacity *= 2;
+        *windows = (Stats *) realloc(*windows, (size_t) *capacity * count * sizeof(Stats));
+        *lengths = (long long int *) realloc(*lengths, *capacity * sizeof(long long int));
+    }
+    for(int i = 0; i < count; i++) {
+        Stats delta = caches[i]->stats;
+        delta.hits -= before[i].hits;
+        delta.misses -= before[i].misses;
+        delta.reads -= before[i].reads;
+        delta.writes -= before[i].writes;
+        (*windows)[(size_t) *closed * count + i] = delta;
+    }
+    (*lengths)[(*closed)++] = length;
+}
+
+// Stratified estimate of the per-access miss, read and write rates from a cache's windows
+void estimateSample(SamplePlan *plan, Stats *windows, long long int *lengths, int windowCount, long long int total, SampleEstimate *estimate) {
+    int strata = (plan->mode == SAMPLE_SIMPOINT) ? plan->strata : 1;
+    double rate[3] = {0.0, 0.0, 0.0}, variance[3] = {0.0, 0.0, 0.0}, covered = 0.0;
+    memset(estimate, 0, sizeof(SampleEstimate));
+    estimate->accesses = total;
+    estimate->samples = windowCount;
+
+    for(int h = 0; h < strata; h++) {
+        // Per-window rates in this stratum: mean and sample variance
+        double sum[3] = {0.0, 0.0, 0.0}, squares[3] = {0.0, 0.0, 0.0};
+        int n = 0;
+        for(int w = 0; w < windowCount; w++) {
+            if(plan->mode == SAMPLE_SIMPOINT && plan->windows[w].stratum != h) continue;
+            if(lengths[w] == 0) continue;
+            double y[3] = {(double) windows[w].misses / lengths[w], (double) windows[w].reads / lengths[w], (double) windows[w].writes / lengths[w]};
+            for(int m = 0; m < 3; m++) {
+                sum[m] += y[m];
+                squares[m] += y[m] * y[m];
+            }
+            n++;
+        }
+        if(n == 0) continue;
+
+        // Periodic windows sample total / detail units; a SimPoint stratum has its interval count
+        double weight = (plan->mode == SAMPLE_SIMPOINT) ? plan->strataWeight[h] : 1.0;
+        double units = (plan->mode == SAMPLE_SIMPOINT) ? plan->strataUnits[h] : (double) total / (double) plan->detail;
+        double correction = (units > n) ? 1.0 - n / units : 0.0;
+        covered += weight;
+        for(int m = 0; m < 3; m++) {
+            double mean = sum[m] / n;
+            rate[m] += weight * mean;
+            if(n > 1) variance[m] += weight * weight * correction * ((squares[m] - n * mean * mean) / (n - 1)) / n;
+        }
+    }
+
+    // Renormalize if a stratum had no window
+    if(covered <= 0.0) return;
+    for(int m = 0; m < 3; m++) {
+        rate[m] /= covered;
+        variance[m] /= covered * covered;
+    }
+    estimate->missRatio = rate[0];
+    estimate->missHalf = CONFIDENCE_Z * sqrt(variance[0] > 0.0 ? variance[0] : 0.0);
+    estimate->reads = rate[1] * total;
+    estimate->readsHalf = CONFIDENCE_Z * sqrt(variance[1] > 0.0 ? variance[1] : 0.0) * total;
+    estimate->writes = rate[2] * total;
+    estimate->writesHalf = CONFIDENCE_Z * sqrt(variance[2] > 0.0 ? variance[2] : 0.0) * total;
+}
+
+// Frees the windows and strata of a plan
+void deleteSamplePlan(SamplePlan *plan) {
+    free(plan->windows);
+    free(plan->strataWeight);
+    free(plan->strataUnits);
+    plan->windows = NULL;
+    plan->strataWeight = plan->strataUnits = NULL;
+}
+
+// Single test report of a sampled estimate's error bounds
+void printSampleEstimate(SampleEstimate *estimate) {
+    printf("Samples: \t%d (%.2f%% detailed)\n", estimate->samples, estimate->accesses ? 100.0 * estimate->detailed / estimate->accesses : 0.0);
+    printf("Miss Ratio CI: \t+/- %.6f\n", estimate->missHalf);
+    printf("Writes CI: \t+/- %.0f\n", estimate->writesHalf);
+    printf("Reads CI: \t+/- %.0f\n", estimate->readsHalf);
+}
+
+// Sweep report line under a configuration: samples, detailed share, then the three half widths
+void printSampleLine(SampleEstimate *estimate) {
+    printf("\t\tsampled:\t%d\t%.4f", estimate->samples, estimate->accesses ? (double) estimate->detailed / estimate->accesses : 0.0);
+    printf("\t%.6f\t%.0f\t%.0f\n", estimate->missHalf, estimate->writesHalf, estimate->readsHalf);
+}
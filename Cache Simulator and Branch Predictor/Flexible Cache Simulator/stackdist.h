@@ -0,0 +1,75 @@
+// Esperandieu Elbon II - UCFID: 5401262
+// EEL4768 Computer Architecture - Suboh Suboh - Fall 2023
+// LRU Stack Distance (Mattson) Profiling
+
+#include <stdlib.h>
+#include <string.h>
+
+// Per-set LRU stacks for one set count. Because LRU has the inclusion property, the depth at
+// which a block is found in its set's stack is the smallest associativity that would have hit,
+// so one pass yields the miss ratio of every associativity (1 .. depth) at this set count.
+typedef struct StackProfile {
+    int numberOfSets, depth;            // Set count and deepest tracked associativity
+    unsigned long long int *stacks;     // numberOfSets * depth block addresses, MRU first
+    int *sizes;                         // Valid entries in each set's stack
+    unsigned long long int *histogram;  // histogram[d] = hits at stack depth d, histogram[depth] = deeper or cold
+    unsigned long long int accesses;
+} StackProfile;
+
+StackProfile *createStackProfile(int numberOfSets, int depth);
+void recordStackAccess(unsigned long long int blockAddress, StackProfile *profile);
+double stackMissRatio(int associativity, StackProfile *profile);
+StackProfile *deleteStackProfile(StackProfile *profile);
+
+// Create a profile tracking stacks of the indicated depth in each of numberOfSets sets
+StackProfile *createStackProfile(int numberOfSets, int depth) {
+    StackProfile *profile = (StackProfile *) malloc(sizeof(StackProfile));
+    profile->numberOfSets = numberOfSets;
+    profile->depth = depth;
+    profile->stacks = (unsigned long long int *) malloc((size_t) numberOfSets * depth * sizeof(unsigned long long int));
+    profile->sizes = (int *) calloc(numberOfSets, sizeof(int));
+    profile->histogram = (unsigned long long int *) calloc(depth + 1, sizeof(unsigned long long int));
+    profile->accesses = 0;
+    return profile;
+}
+
+// Find the block in its set's stack, record the depth, and move it to the top
+void recordStackAccess(unsigned long long int blockAddress, StackProfile *profile) {
+    int setNumber = blockAddress % profile->numberOfSets;
+    unsigned long long int *stack = profile->stacks + (size_t) setNumber * profile->depth;
+    int size = profile->sizes[setNumber];
+
+    // Search from the top of the stack
+    int distance = 0;
+    while(distance < size && stack[distance] != blockAddress) distance++;
+    profile->histogram[distance < size ? distance : profile->depth]++;
+    profile->accesses++;
+
+    // Not found: grow the stack, dropping the bottom entry once full
+    if(distance == size) {
+        if(size < profile->depth) profile->sizes[setNumber]++;
+        else distance--;
+    }
+
+    // Push everything above the block down one and place it on top
+    memmove(stack + 1, stack, distance * sizeof(unsigned long long int));
+    stack[0] = blockAddress;
+}
+
+// Miss ratio of an LRU cache with this profile's set count and the indicated associativity,
+// 0 when the trace had no accesses
+double stackMissRatio(int associativity, StackProfile *profile) {
+    if(profile->accesses == 0) return 0.0;
+    unsigned long long int hits = 0;
+    for(int d = 0; d < associativity && d < profile->depth; d++) hits += profile->histogram[d];
+    return (double) (profile->accesses - hits) / (double) profile->accesses;
+}
+
+// De-allocate space allocated for the profile
+StackProfile *deleteStackProfile(StackProfile *profile) {
+    free(profile->stacks);
+    free(profile->sizes);
+    free(profile->histogram);
+    free(profile);
+    return NULL;
+}
@@ -0,0 +1,124 @@
+// Esperandieu Elbon II - UCFID: 5401262
+// EEL4768 Computer Architecture - Suboh Suboh - Fall 2023
+// Trace Converter: text traces <-> compact binary traces
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "traceio.h"
+
+#define CONVERT_BATCH 4096
+
+int encodeTrace(int kind, TraceReader *trace, FILE *out, int flags, int shift);
+int decodeTrace(TraceReader *trace, FILE *out);
+
+// argc # of arguments, start at 1 b/c 0 is program name
+// Encode: <cache|branch> <TEXT_TRACE> <BINARY_TRACE> [-z] [-shift <bits>]
+//         -z compresses each block, -shift drops low address bits (e.g. 6 for 64B blocks)
+// Decode: -d <BINARY_TRACE> <TEXT_TRACE> (no options)
+// Either path may be "-" for stdin/stdout; the input may be gzip or zstd compressed
+int main(int argc, char* argv[]) {
+
+    // Ensure valid # of arguments given
+    if(argc < 4) {
+        printf("Invalid number of arguments.\n");
+        return 1;
+    }
+
+    int decode = strcmp(argv[1], "-d") == 0, kind;
+    if(decode) kind = -1;
+    else if(strcmp(argv[1], "cache") == 0) kind = TRACE_KIND_CACHE;
+    else if(strcmp(argv[1], "branch") == 0) kind = TRACE_KIND_BRANCH;
+    else {
+        printf("Unknown trace kind: %s\n", argv[1]);
+        return 1;
+    }
+
+    // Encoding options; decoding takes none
+    if(decode && argc > 4) {
+        printf("Decoding takes no options.\n");
+        return 1;
+    }
+    int flags = 0, shift = 0;
+    for(int i = 4; i < argc; i++) {
+        if(strcmp(argv[i], "-z") == 0) flags |= TRACE_FLAG_COMPRESSED;
+        else if(strcmp(argv[i], "-shift") == 0 && i + 1 < argc) shift = (int) strtol(argv[++i], NULL, 0);
+        else {
+            printf("Unknown option: %s\n", argv[i]);
+            return 1;
+        }
+    }
+    if(shift < 0 || shift > 12) {
+        printf("Bad shift.\n");
+        return 1;
+    }
+
+    // Validate Paths
+    TraceReader *trace = openTrace(argv[2]);
+    if(!trace) {
+        printf("Bad Path.\n");
+        return 1;
+    }
+    FILE *out = (strcmp(argv[3], "-") == 0) ? stdout : fopen(argv[3], "wb");
+    if(!out) {
+        printf("Bad Path.\n");
+        closeTrace(trace);
+        return 1;
+    }
+
+    int ok = decode ? decodeTrace(trace, out) : encodeTrace(kind, trace, out, flags, shift);
+    closeTrace(trace);
+
+    // A failed write (e.g. a full disk) only shows up in the stream's error flag or at the close
+    ok = ok && fflush(out) == 0 && !ferror(out);
+    if(out != stdout) ok = (fclose(out) == 0) && ok;
+    if(!ok) printf("Bad Path.\n");
+    return ok ? 0 : 1;
+}
+
+// Re-encode every record of a text (or binary) trace in binary form
+int encodeTrace(int kind, TraceReader *trace, FILE *out, int flags, int shift) {
+    TraceWriter *writer = createTraceWriter(out, kind, flags, shift);
+    int size;
+    if(kind == TRACE_KIND_CACHE) {
+        Access *batch = (Access *) malloc(CONVERT_BATCH * sizeof(Access));
+        while((size = readAccesses(trace, batch, CONVERT_BATCH)) > 0) {
+            for(int i = 0; i < size; i++) writeTraceRecord(batch[i].address, batch[i].operation, writer);
+        }
+        free(batch);
+    }
+    else {
+        Branch *batch = (Branch *) malloc(CONVERT_BATCH * sizeof(Branch));
+        while((size = readBranches(trace, batch, CONVERT_BATCH)) > 0) {
+            for(int i = 0; i < size; i++) writeTraceRecord(batch[i].address, batch[i].outcome == 't', writer);
+        }
+        free(batch);
+    }
+    closeTraceWriter(writer);
+    return 1;
+}
+
+// Write a binary trace back out in the text format the simulators were written for
+int decodeTrace(TraceReader *trace, FILE *out) {
+    if(!trace->binary) {
+        printf("Not a binary trace.\n");
+        return 0;
+    }
+
+    int size;
+    if(trace->header.kind == TRACE_KIND_CACHE) {
+        Access *batch = (Access *) malloc(CONVERT_BATCH * sizeof(Access));
+        while((size = readAccesses(trace, batch, CONVERT_BATCH)) > 0) {
+            for(int i = 0; i < size; i++) fprintf(out, "%c %llx\n", batch[i].operation, batch[i].address);
+        }
+        free(batch);
+    }
+    else {
+        Branch *batch = (Branch *) malloc(CONVERT_BATCH * sizeof(Branch));
+        while((size = readBranches(trace, batch, CONVERT_BATCH)) > 0) {
+            for(int i = 0; i < size; i++) fprintf(out, "%llx %c\n", batch[i].address, batch[i].outcome);
+        }
+        free(batch);
+    }
+    return 1;
+}
@@ -0,0 +1,222 @@
+// Esperandieu Elbon II - UCFID: 5401262
+// EEL4768 Computer Architecture - Suboh Suboh - Fall 2023
+// Synthetic Trace Generator
+//
+// Writes deterministic text traces with a known access or branch pattern, for benchmarking the
+// simulators and checking their results. The same pattern, record count and seed always give
+// the same trace. About one access in four is a write.
+//
+// Cache patterns:  stream[:<Footprint>]  sequential 8 byte words, wrapping at the footprint
+//                  random[:<Footprint>]  uniform 8 byte words in the footprint
+//                  stride[:<Stride>]     one word every <Stride> bytes over a 64MB footprint
+//                  chase[:<Nodes>]       pointer chasing: one random cycle through 64B nodes
+// Branch patterns: loop[:<Trip>]         a loop nest with a periodic branch in its body
+//                  correlated[:<Depth>]  random branches, then one that is the XOR of the
+//                                        last <Depth> of them
+//                  calls[:<Depth>]       extended records (see traceio.h): 16 functions, each
+//                                        a loop around a switch (an indirect jump), most calling
+//                                        another, nesting at most <Depth> (default 8) deep
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define DEFAULT_FOOTPRINT (1 << 26)
+#define CHASE_NODE 64
+#define CACHE_BASE 0x10000000ULL
+#define BRANCH_BASE 0x400000ULL
+#define FUNCTION_BASE 0x800000ULL
+#define FUNCTION_SIZE 0x1004     // Not a power of 2, so functions spread over the BTB sets
+#define FUNCTIONS 16
+
+unsigned long long int seedState;
+
+unsigned long long int nextRandom();
+void writeAccess(FILE *out, unsigned long long int address);
+void writeBranch(FILE *out, unsigned long long int address, int taken);
+void writeControl(FILE *out, unsigned long long int address, int taken, char type, unsigned long long int target);
+long long int generateFunction(FILE *out, int function, int depth, long long int left);
+int generateCache(FILE *out, char *pattern, long long int parameter, long long int records);
+int generateBranches(FILE *out, char *pattern, long long int parameter, long long int records);
+
+// argc # of arguments, start at 1 b/c 0 is program name
+// argv <Pattern>[:<Parameter>] <Records> <Seed> <TRACE_FILE>
+// TRACE_FILE may be "-" for stdout
+int main(int argc, char* argv[]) {
+
+    // Ensure valid # of arguments given
+    if(argc != 5) {
+        printf("Invalid number of arguments.\n");
+        return 1;
+    }
+
+    // Pattern and its optional parameter
+    char *pattern = argv[1], *colon = strchr(pattern, ':');
+    long long int parameter = 0;
+    if(colon) {
+        *colon = '\0';
+        parameter = strtoll(colon + 1, NULL, 0);
+        if(parameter < 1) {
+            printf("Bad pattern parameter.\n");
+            return 1;
+        }
+    }
+    long long int records = strtoll(argv[2], NULL, 0);
+    seedState = strtoull(argv[3], NULL, 0) * 0x9E3779B97F4A7C15ULL + 1;
+    if(records < 1) {
+        printf("Bad record count.\n");
+        return 1;
+    }
+
+    FILE *out = (strcmp(argv[4], "-") == 0) ? stdout : fopen(argv[4], "w");
+    if(!out) {
+        printf("Bad Path.\n");
+        return 1;
+    }
+    int ok = generateCache(out, pattern, parameter, records) || generateBranches(out, pattern, parameter, records);
+    if(!ok) printf("Unknown pattern: %s\n", pattern);
+    if(out != stdout) fclose(out);
+    return ok ? 0 : 1;
+}
+
+// xorshift64*: fast, and the same sequence on every platform
+unsigned long long int nextRandom() {
+    seedState ^= seedState >> 12;
+    seedState ^= seedState << 25;
+    seedState ^= seedState >> 27;
+    return seedState * 0x2545F4914F6CDD1DULL;
+}
+
+// One cache record, a write one time in four
+void writeAccess(FILE *out, unsigned long long int address) {
+    fprintf(out, "%c %llx\n", ((nextRandom() >> 32) & 3) == 0 ? 'W' : 'R', address);
+}
+
+// One branch record
+void writeBranch(FILE *out, unsigned long long int address, int taken) {
+    fprintf(out, "%llx %c\n", address, taken ? 't' : 'n');
+}
+
+// One extended branch record
+void writeControl(FILE *out, unsigned long long int address, int taken, char type, unsigned long long int target) {
+    fprintf(out, "%llx %c %c %llx\n", address, taken ? 't' : 'n', type, target);
+}
+
+// One call of a calls pattern function, at most left records. Returns the number written
+long long int generateFunction(FILE *out, int function, int depth, long long int left) {
+    unsigned long long int base = FUNCTION_BASE + (unsigned long long int) function * FUNCTION_SIZE;
+    long long int written = 0;
+    int trip = 2 + function % 5;
+    for(int i = 0; i < trip && written < left; i++) {
+        // Switch: an indirect jump to one of four cases
+        writeControl(out, base + 0x10, 1, 'i', base + 0x100 + (nextRandom() >> 62) * 0x40);
+        written++;
+
+        // On the first iteration, usually call another function (from its own call site)
+        if(i == 0 && depth > 0 && written < left && (nextRandom() >> 62) != 0) {
+            int callee = (int) ((nextRandom() >> 33) % FUNCTIONS);
+            unsigned long long int site = base + 0x200 + (unsigned long long int) callee * 0x10;
+            writeControl(out, site, 1, 'l', FUNCTION_BASE + (unsigned long long int) callee * FUNCTION_SIZE);
+            written++;
+            written += generateFunction(out, callee, depth - 1, left - written);
+            if(written < left) writeControl(out, FUNCTION_BASE + (unsigned long long int) callee * FUNCTION_SIZE + FUNCTION_SIZE - 4, 1, 'r', site + 4);
+            written++;
+        }
+
+        // Loop back edge
+        if(written < left) writeControl(out, base + 0x400, i < trip - 1, 'c', base + 0x10);
+        written++;
+    }
+    return written;
+}
+
+// Writes a cache pattern. Returns 0 if the pattern isn't a cache pattern
+int generateCache(FILE *out, char *pattern, long long int parameter, long long int records) {
+    if(strcmp(pattern, "stream") == 0 || strcmp(pattern, "random") == 0) {
+        unsigned long long int words = (unsigned long long int) (parameter ? parameter : DEFAULT_FOOTPRINT) / 8;
+        if(words == 0) words = 1;
+        int random = strcmp(pattern, "random") == 0;
+        for(long long int i = 0; i < records; i++) {
+            unsigned long long int word = random ? nextRandom() % words : (unsigned long long int) i % words;
+            writeAccess(out, CACHE_BASE + word * 8);
+        }
+        return 1;
+    }
+    if(strcmp(pattern, "stride") == 0) {
+        unsigned long long int stride = (unsigned long long int) (parameter ? parameter : 256), steps = DEFAULT_FOOTPRINT / stride;
+        if(steps == 0) steps = 1;
+        for(long long int i = 0; i < records; i++) writeAccess(out, CACHE_BASE + ((unsigned long long int) i % steps) * stride);
+        return 1;
+    }
+    if(strcmp(pattern, "chase") == 0) {
+        // Sattolo's shuffle makes next[] a single cycle through every node
+        long long int nodes = parameter ? parameter : (1 << 16);
+        long long int *next = (long long int *) malloc((size_t) nodes * sizeof(long long int));
+        for(long long int i = 0; i < nodes; i++) next[i] = i;
+        for(long long int i = nodes - 1; i > 0; i--) {
+            long long int j = (long long int) (nextRandom() % (unsigned long long int) i), swap = next[i];
+            next[i] = next[j];
+            next[j] = swap;
+        }
+        long long int node = 0;
+        for(long long int i = 0; i < records; i++) {
+            writeAccess(out, CACHE_BASE + (unsigned long long int) node * CHASE_NODE);
+            node = next[node];
+        }
+        free(next);
+        return 1;
+    }
+    return 0;
+}
+
+// Writes a branch pattern. Returns 0 if the pattern isn't a branch pattern
+int generateBranches(FILE *out, char *pattern, long long int parameter, long long int records) {
+    long long int written = 0;
+    if(strcmp(pattern, "loop") == 0) {
+        // Inner back edge taken trip - 1 times, a body branch taken every third iteration,
+        // and an outer back edge taken 7 times in 8
+        long long int trip = parameter ? parameter : 10, outer = 0, body = 0;
+        while(written < records) {
+            for(long long int i = 0; i < trip && written < records; i++) {
+                writeBranch(out, BRANCH_BASE + 0x40, (body++ % 3) == 0);
+                if(++written < records) writeBranch(out, BRANCH_BASE + 0x80, i < trip - 1);
+                written++;
+            }
+            if(written < records) writeBranch(out, BRANCH_BASE + 0xC0, (++outer % 8) != 0);
+            written++;
+        }
+        return 1;
+    }
+    if(strcmp(pattern, "correlated") == 0) {
+        // Random branches spread over 64 addresses, every <Depth>th followed by the XOR branch
+        long long int depth = parameter ? parameter : 2;
+        if(depth > 32) depth = 32;
+        while(written < records) {
+            int parity = 0;
+            for(long long int i = 0; i < depth && written < records; i++, written++) {
+                unsigned long long int value = nextRandom();
+                int taken = (int) ((value >> 40) & 1);
+                parity ^= taken;
+                writeBranch(out, BRANCH_BASE + 0x1000 + ((value >> 20) & 63) * 0x10, taken);
+            }
+            if(written++ < records) writeBranch(out, BRANCH_BASE + 0x2000, parity);
+        }
+        return 1;
+    }
+    if(strcmp(pattern, "calls") == 0) {
+        // The main loop: call a random function, then jump back
+        int depth = (int) (parameter ? parameter : 8);
+        while(written < records) {
+            int callee = (int) ((nextRandom() >> 33) % FUNCTIONS);
+            unsigned long long int site = BRANCH_BASE + 0x3000 + (unsigned long long int) callee * 0x10;
+            writeControl(out, site, 1, 'l', FUNCTION_BASE + (unsigned long long int) callee * FUNCTION_SIZE);
+            written++;
+            written += generateFunction(out, callee, depth - 1, records - written);
+            if(written < records) writeControl(out, FUNCTION_BASE + (unsigned long long int) callee * FUNCTION_SIZE + FUNCTION_SIZE - 4, 1, 'r', site + 4);
+            if(++written < records) writeControl(out, site + 8, 1, 'j', BRANCH_BASE + 0x3000);
+            written++;
+        }
+        return 1;
+    }
+    return 0;
+}
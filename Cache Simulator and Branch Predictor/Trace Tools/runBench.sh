@@ -0,0 +1,138 @@
+#!/bin/sh
+# Esperandieu Elbon II - UCFID: 5401262
+# EEL4768 Computer Architecture - Suboh Suboh - Fall 2023
+# Benchmark and Regression Suite
+#
+# Builds SIM, GSHARESIM, TRACEGEN and TRACECONV, generates the synthetic traces, runs every case
+# with -time and prints seconds and records/s per case. Results are compared with benchGolden.txt
+# (recorded at the default record count) and, optionally, rates with a saved baseline. A cache
+# trace with R, W, I and other operations is also converted to binary (plain and compressed),
+# and SIM must report the same results on every form.
+#
+# Usage: ./runBench.sh [-records <N>] [-update] [-save <File>] [-against <File> [-tolerance <Percent>]]
+#        -update rewrites benchGolden.txt, -save writes this run's rates to a baseline file,
+#        -against fails any case more than <Percent> (default 10) slower than the baseline
+# Exits 1 on output drift, a binary round trip mismatch or a rate regression.
+
+DIR=$(cd "$(dirname "$0")" && pwd)
+RECORDS=2000000
+DEFAULT_RECORDS=2000000
+GOLDEN="$DIR/benchGolden.txt"
+UPDATE=0
+SAVE=""
+AGAINST=""
+TOLERANCE=10
+
+while [ $# -gt 0 ]; do
+    case "$1" in
+        -records) RECORDS=$2; shift 2 ;;
+        -update) UPDATE=1; shift ;;
+        -save) SAVE=$2; shift 2 ;;
+        -against) AGAINST=$2; shift 2 ;;
+        -tolerance) TOLERANCE=$2; shift 2 ;;
+        *) echo "Unknown option: $1"; exit 1 ;;
+    esac
+done
+
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+
+############ Build ############
+gcc -O2 "$DIR/../Flexible Cache Simulator/SIM.c" -o "$WORK/SIM" -pthread -lm || exit 1
+gcc -O2 "$DIR/../Adaptive Branch Predictor/GSHARESIM.c" -o "$WORK/GSHARESIM" -pthread -lm || exit 1
+gcc -O2 "$DIR/TRACEGEN.c" -o "$WORK/TRACEGEN" || exit 1
+gcc -O2 "$DIR/TRACECONV.c" -o "$WORK/TRACECONV" -pthread || exit 1
+
+############ Traces ############
+for PATTERN in stream random stride chase loop correlated correlated:8 calls; do
+    "$WORK/TRACEGEN" $PATTERN $RECORDS 1 "$WORK/$PATTERN.trace" || exit 1
+done
+
+############ Cases ############
+# <Name> <Program> <Trace> <Arguments before the trace>
+cat > "$WORK/cases" << EOF
+stream-lru SIM stream 32768 8 0 1
+stream-drrip SIM stream 32768 8 6 1
+stream-plru-wt SIM stream 262144 16 2 0
+random-lru SIM random 32768 8 0 1
+random-drrip SIM random 32768 8 6 1
+random-plru-wt SIM random 262144 16 2 0
+stride-lru SIM stride 32768 8 0 1
+stride-drrip SIM stride 32768 8 6 1
+stride-plru-wt SIM stride 262144 16 2 0
+chase-lru SIM chase 32768 8 0 1
+chase-drrip SIM chase 32768 8 6 1
+chase-plru-wt SIM chase 262144 16 2 0
+chase-drrip-llc SIM chase 1048576 16 6 1
+loop-gshare GSHARESIM loop 12 10
+loop-tage GSHARESIM loop -p tage:8
+loop-perceptron GSHARESIM loop -p perceptron:8
+correlated-gshare GSHARESIM correlated 12 10
+correlated-tage GSHARESIM correlated -p tage:8
+correlated-perceptron GSHARESIM correlated -p perceptron:8
+correlated8-gshare GSHARESIM correlated:8 12 10
+correlated8-tage GSHARESIM correlated:8 -p tage:8
+correlated8-perceptron GSHARESIM correlated:8 -p perceptron:8
+calls-frontend GSHARESIM calls -frontend 12 8 512 4 16 8 spec
+EOF
+
+printf "%-24s %10s %14s\n" "Case" "Seconds" "Records/s"
+: > "$WORK/results"
+: > "$WORK/rates"
+while read NAME PROGRAM TRACE ARGS; do
+    "$WORK/$PROGRAM" -time $ARGS "$WORK/$TRACE.trace" > "$WORK/out" 2> "$WORK/time"
+    echo "$NAME: $(tr '\n\t' '  ' < "$WORK/out")" >> "$WORK/results"
+    SECONDS_TAKEN=$(sed -n 's/^Time: \([0-9.]*\) s.*/\1/p' "$WORK/time")
+    RATE=$(sed -n 's/.*Records\/s: \([0-9]*\).*/\1/p' "$WORK/time")
+    printf "%-24s %10s %14s\n" "$NAME" "$SECONDS_TAKEN" "$RATE"
+    echo "$NAME $RATE" >> "$WORK/rates"
+done < "$WORK/cases"
+
+STATUS=0
+
+############ Output drift ############
+if [ $UPDATE -eq 1 ]; then
+    cp "$WORK/results" "$GOLDEN"
+    echo "Golden results updated."
+elif [ "$RECORDS" != "$DEFAULT_RECORDS" ]; then
+    echo "Golden results skipped (recorded at $DEFAULT_RECORDS records)."
+elif diff "$GOLDEN" "$WORK/results" > "$WORK/drift"; then
+    echo "Results match the golden outputs."
+else
+    echo "Results differ from the golden outputs:"
+    cat "$WORK/drift"
+    STATUS=1
+fi
+
+############ Binary round trip ############
+awk 'NR % 3 == 0 { $1 = "I" } NR % 7 == 0 { $1 = "X" } { print }' "$WORK/random.trace" > "$WORK/mixed.trace"
+"$WORK/TRACECONV" cache "$WORK/mixed.trace" "$WORK/mixed.bin" || exit 1
+"$WORK/TRACECONV" cache "$WORK/mixed.trace" "$WORK/mixed.z.bin" -z || exit 1
+"$WORK/SIM" 16384 4 0 1 "$WORK/mixed.trace" > "$WORK/text.out"
+ROUND_TRIP=1
+for FORM in mixed.bin mixed.z.bin; do
+    "$WORK/SIM" 16384 4 0 1 "$WORK/$FORM" > "$WORK/binary.out"
+    cmp -s "$WORK/text.out" "$WORK/binary.out" || ROUND_TRIP=0
+done
+if [ $ROUND_TRIP -eq 1 ]; then
+    echo "Binary traces match their text form."
+else
+    echo "Binary traces differ from their text form."
+    STATUS=1
+fi
+
+############ Rate regressions ############
+if [ -n "$SAVE" ]; then
+    cp "$WORK/rates" "$SAVE"
+fi
+if [ -n "$AGAINST" ]; then
+    awk -v tolerance=$TOLERANCE '
+        NR == FNR { baseline[$1] = $2; next }
+        ($1 in baseline) && baseline[$1] > 0 && $2 < baseline[$1] * (1 - tolerance / 100) {
+            printf("Slower: %s %d records/s (baseline %d)\n", $1, $2, baseline[$1])
+            slower = 1
+        }
+        END { exit slower }' "$AGAINST" "$WORK/rates" || STATUS=1
+    [ $STATUS -eq 0 ] && echo "No case is more than $TOLERANCE% slower than $AGAINST."
+fi
+exit $STATUS
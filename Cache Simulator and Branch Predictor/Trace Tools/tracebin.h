@@ -0,0 +1,331 @@
+// Esperandieu Elbon II - UCFID: 5401262
+// EEL4768 Computer Architecture - Suboh Suboh - Fall 2023
+// Compact Binary Trace Format
+//
+// File:   16 byte header, then blocks until end of file
+// Header: "TRCB", kind (0 cache, 1 branch), version, flags, address shift, 8 reserved bytes
+// Block:  u32 raw length, u32 stored length, u32 record count (little endian), then the payload.
+//         The payload is compressed when stored length < raw length, otherwise it is stored raw.
+// Record: one varint per record. Cache records hold zigzag(address delta) << 2 | op, with op
+//         0 R, 1 W, 2 I, or 3 followed by the operation character as one raw byte, so every
+//         operation survives a round trip. Branch records hold zigzag(pc delta) << 1 | taken.
+//         Addresses are shifted right by the header's address shift first (0 keeps byte
+//         addresses), deltas restart from 0 at each block so blocks decode independently, and
+//         addresses must fit in 61 bits.
+// Version 1 cache records held only a write bit (zigzag(delta) << 1 | write); they still read,
+// as R and W.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define TRACE_MAGIC "TRCB"
+#define TRACE_KIND_CACHE 0
+#define TRACE_KIND_BRANCH 1
+#define TRACE_VERSION 2
+#define TRACE_VERSION_WRITE_BIT 1       // Cache records carry a write bit only
+#define TRACE_OP_OTHER 3                // Cache op code: the operation byte follows
+#define TRACE_FLAG_COMPRESSED 1
+#define TRACE_HEADER_SIZE 16
+#define TRACE_BLOCK_HEADER_SIZE 12
+#define TRACE_BLOCK_SIZE (1 << 18)      // Raw payload bytes per block
+#define TRACE_MAX_VARINT 10
+#define TRACE_MAX_RECORD (TRACE_MAX_VARINT + 1)
+
+// Header fields
+typedef struct TraceHeader {
+    int kind, version, flags, shift;
+} TraceHeader;
+
+// Trace Writer: buffers one block of encoded records at a time
+typedef struct TraceWriter {
+    FILE *file;
+    TraceHeader header;
+    unsigned char *raw, *packed;    // Encoded records, compressed copy
+    int rawLength, records;
+    unsigned long long int previous;
+} TraceWriter;
+
+TraceWriter *createTraceWriter(FILE *file, int kind, int flags, int shift);
+void writeTraceRecord(unsigned long long int address, int field, TraceWriter *writer);
+int operationCode(char operation);
+void flushTraceBlock(TraceWriter *writer);
+TraceWriter *closeTraceWriter(TraceWriter *writer);
+
+// Varint Functions
+int putVarint(unsigned long long int value, unsigned char *out);
+int getVarint(const unsigned char *in, const unsigned char *end, unsigned long long int *value);
+unsigned long long int zigzag(long long int value);
+long long int unzigzag(unsigned long long int value);
+
+// Header / Block Functions
+void writeTraceHeader(TraceHeader *header, unsigned char *out);
+int readTraceHeader(const unsigned char *in, size_t length, TraceHeader *header);
+void putU32(unsigned int value, unsigned char *out);
+unsigned int getU32(const unsigned char *in);
+
+// LZ Block Compression (LZ4-style sequences: token, literals, 16 bit offset, match length)
+int compressBlock(const unsigned char *in, int length, unsigned char *out, int capacity);
+int decompressBlock(const unsigned char *in, int length, unsigned char *out, int capacity);
+
+// Encodes value 7 bits at a time, low bits first. Returns bytes written
+int putVarint(unsigned long long int value, unsigned char *out) {
+    int n = 0;
+    while(value >= 0x80) {
+        out[n++] = (unsigned char) (value | 0x80);
+        value >>= 7;
+    }
+    out[n++] = (unsigned char) value;
+    return n;
+}
+
+// Decodes one varint. Returns bytes consumed, 0 if the input ends mid-varint
+int getVarint(const unsigned char *in, const unsigned char *end, unsigned long long int *value) {
+    unsigned long long int result = 0;
+    int shift = 0, n = 0;
+    while(in + n < end && n < TRACE_MAX_VARINT) {
+        unsigned char byte = in[n++];
+        result |= (unsigned long long int) (byte & 0x7F) << shift;
+        if(!(byte & 0x80)) {
+            *value = result;
+            return n;
+        }
+        shift += 7;
+    }
+    return 0;
+}
+
+// Maps signed deltas to unsigned so small negative steps stay short
+unsigned long long int zigzag(long long int value) {
+    return ((unsigned long long int) value << 1) ^ (unsigned long long int) (value >> 63);
+}
+
+long long int unzigzag(unsigned long long int value) {
+    return (long long int) (value >> 1) ^ -(long long int) (value & 1);
+}
+
+void putU32(unsigned int value, unsigned char *out) {
+    out[0] = (unsigned char) value;
+    out[1] = (unsigned char) (value >> 8);
+    out[2] = (unsigned char) (value >> 16);
+    out[3] = (unsigned char) (value >> 24);
+}
+
+unsigned int getU32(const unsigned char *in) {
+    return (unsigned int) in[0] | ((unsigned int) in[1] << 8) | ((unsigned int) in[2] << 16) | ((unsigned int) in[3] << 24);
+}
+
+void writeTraceHeader(TraceHeader *header, unsigned char *out) {
+    memset(out, 0, TRACE_HEADER_SIZE);
+    memcpy(out, TRACE_MAGIC, 4);
+    out[4] = (unsigned char) header->kind;
+    out[5] = (unsigned char) header->version;
+    out[6] = (unsigned char) header->flags;
+    out[7] = (unsigned char) header->shift;
+}
+
+// Returns 1 if the bytes start with a binary trace header this reader understands
+int readTraceHeader(const unsigned char *in, size_t length, TraceHeader *header) {
+    if(length < TRACE_HEADER_SIZE || memcmp(in, TRACE_MAGIC, 4) != 0) return 0;
+    header->kind = in[4];
+    header->version = in[5];
+    header->flags = in[6];
+    header->shift = in[7];
+    return (header->version == TRACE_VERSION || header->version == TRACE_VERSION_WRITE_BIT) && header->shift < 64;
+}
+
+// Hash of the 4 bytes at p, used to find match candidates
+#define LZ_HASH_BITS 14
+#define LZ_MIN_MATCH 4
+#define LZ_MAX_OFFSET 65535
+unsigned int lzHash(const unsigned char *p) {
+    unsigned int v;
+    memcpy(&v, p, 4);
+    return (v * 2654435761u) >> (32 - LZ_HASH_BITS);
+}
+
+// Writes a length nibble's overflow as 255-runs. Returns bytes written
+int lzPutLength(int length, unsigned char *out) {
+    int n = 0;
+    while(length >= 255) {
+        out[n++] = 255;
+        length -= 255;
+    }
+    out[n++] = (unsigned char) length;
+    return n;
+}
+
+// Greedy single-probe LZ77. The last sequence carries only literals. Returns the compressed
+// size, or 0 if it wouldn't fit in capacity (the caller then stores the block raw)
+int compressBlock(const unsigned char *in, int length, unsigned char *out, int capacity) {
+    int *table = (int *) malloc(sizeof(int) << LZ_HASH_BITS);
+    for(int i = 0; i < (1 << LZ_HASH_BITS); i++) table[i] = -1;
+
+    int ip = 0, anchor = 0, op = 0;
+    while(ip + LZ_MIN_MATCH <= length) {
+        unsigned int h = lzHash(in + ip);
+        int candidate = table[h];
+        table[h] = ip;
+        if(candidate < 0 || ip - candidate > LZ_MAX_OFFSET || memcmp(in + candidate, in + ip, LZ_MIN_MATCH) != 0) {
+            ip++;
+            continue;
+        }
+
+        // Extend the match
+        int matchLength = LZ_MIN_MATCH;
+        while(ip + matchLength < length && in[candidate + matchLength] == in[ip + matchLength]) matchLength++;
+
+        // Emit token, literals, offset and match length; worst case is bounded by the literal run
+        int literals = ip - anchor;
+        if(op + 1 + literals / 255 + 1 + literals + 2 + matchLength / 255 + 1 > capacity) {
+            free(table);
+            return 0;
+        }
+        unsigned char *token = out + op++;
+        *token = (unsigned char) (((literals < 15) ? literals : 15) << 4);
+        if(literals >= 15) op += lzPutLength(literals - 15, out + op);
+        memcpy(out + op, in + anchor, literals);
+        op += literals;
+        out[op++] = (unsigned char) (ip - candidate);
+        out[op++] = (unsigned char) ((ip - candidate) >> 8);
+        int extra = matchLength - LZ_MIN_MATCH;
+        *token |= (unsigned char) ((extra < 15) ? extra : 15);
+        if(extra >= 15) op += lzPutLength(extra - 15, out + op);
+
+        ip += matchLength;
+        anchor = ip;
+    }
+
+    // Final literal-only sequence
+    int literals = length - anchor;
+    if(op + 1 + literals / 255 + 1 + literals > capacity) {
+        free(table);
+        return 0;
+    }
+    out[op++] = (unsigned char) (((literals < 15) ? literals : 15) << 4);
+    if(literals >= 15) op += lzPutLength(literals - 15, out + op);
+    memcpy(out + op, in + anchor, literals);
+    op += literals;
+
+    free(table);
+    return op;
+}
+
+// Reverses compressBlock. Returns the decompressed size, or -1 on malformed input
+int decompressBlock(const unsigned char *in, int length, unsigned char *out, int capacity) {
+    int ip = 0, op = 0;
+    while(ip < length) {
+        int token = in[ip++];
+
+        // Literals
+        int literals = token >> 4;
+        if(literals == 15) {
+            int byte;
+            do {
+                if(ip >= length) return -1;
+                byte = in[ip++];
+                literals += byte;
+            } while(byte == 255);
+        }
+        if(ip + literals > length || op + literals > capacity) return -1;
+        memcpy(out + op, in + ip, literals);
+        ip += literals;
+        op += literals;
+        if(ip == length) break;
+
+        // Match
+        if(ip + 2 > length) return -1;
+        int offset = in[ip] | (in[ip + 1] << 8);
+        ip += 2;
+        int matchLength = token & 15;
+        if(matchLength == 15) {
+            int byte;
+            do {
+                if(ip >= length) return -1;
+                byte = in[ip++];
+                matchLength += byte;
+            } while(byte == 255);
+        }
+        matchLength += LZ_MIN_MATCH;
+        if(offset == 0 || offset > op || op + matchLength > capacity) return -1;
+
+        // Byte copy: matches may overlap their own output
+        for(int i = 0; i < matchLength; i++, op++) out[op] = out[op - offset];
+    }
+    return op;
+}
+
+// Start a binary trace on an open file by writing its header
+TraceWriter *createTraceWriter(FILE *file, int kind, int flags, int shift) {
+    TraceWriter *writer = (TraceWriter *) malloc(sizeof(TraceWriter));
+    writer->file = file;
+    writer->header.kind = kind;
+    writer->header.version = TRACE_VERSION;
+    writer->header.flags = flags;
+    writer->header.shift = shift;
+    writer->raw = (unsigned char *) malloc(TRACE_BLOCK_SIZE);
+    writer->packed = (unsigned char *) malloc(TRACE_BLOCK_SIZE);
+    writer->rawLength = writer->records = 0;
+    writer->previous = 0;
+
+    unsigned char header[TRACE_HEADER_SIZE];
+    writeTraceHeader(&writer->header, header);
+    fwrite(header, 1, TRACE_HEADER_SIZE, file);
+    return writer;
+}
+
+// 2 bit cache op code of an operation character
+int operationCode(char operation) {
+    if(operation == 'R') return 0;
+    if(operation == 'W') return 1;
+    if(operation == 'I') return 2;
+    return TRACE_OP_OTHER;
+}
+
+// Append one record: the address delta and, for cache traces, the operation character, for
+// branch traces the outcome (taken) bit
+void writeTraceRecord(unsigned long long int address, int field, TraceWriter *writer) {
+    if(writer->rawLength + TRACE_MAX_RECORD > TRACE_BLOCK_SIZE) flushTraceBlock(writer);
+    unsigned long long int shifted = address >> writer->header.shift;
+    unsigned long long int delta = zigzag((long long int) (shifted - writer->previous));
+    int code = (writer->header.kind == TRACE_KIND_CACHE) ? operationCode((char) field) : 0;
+    unsigned long long int value = (writer->header.kind == TRACE_KIND_CACHE) ? (delta << 2) | (unsigned long long int) code : (delta << 1) | (field != 0);
+    writer->rawLength += putVarint(value, writer->raw + writer->rawLength);
+    if(code == TRACE_OP_OTHER) writer->raw[writer->rawLength++] = (unsigned char) field;
+    writer->records++;
+    writer->previous = shifted;
+}
+
+// Write the buffered block, compressed if that makes it smaller, and start a new one
+void flushTraceBlock(TraceWriter *writer) {
+    if(writer->records == 0) return;
+    const unsigned char *payload = writer->raw;
+    int stored = writer->rawLength;
+    if(writer->header.flags & TRACE_FLAG_COMPRESSED) {
+        int packed = compressBlock(writer->raw, writer->rawLength, writer->packed, writer->rawLength - 1);
+        if(packed > 0) {
+            payload = writer->packed;
+            stored = packed;
+        }
+    }
+
+    unsigned char header[TRACE_BLOCK_HEADER_SIZE];
+    putU32((unsigned int) writer->rawLength, header);
+    putU32((unsigned int) stored, header + 4);
+    putU32((unsigned int) writer->records, header + 8);
+    fwrite(header, 1, TRACE_BLOCK_HEADER_SIZE, writer->file);
+    fwrite(payload, 1, (size_t) stored, writer->file);
+
+    writer->rawLength = writer->records = 0;
+    writer->previous = 0;
+}
+
+// Flush the last block and free the writer. The file is left open
+TraceWriter *closeTraceWriter(TraceWriter *writer) {
+    flushTraceBlock(writer);
+    fflush(writer->file);
+    free(writer->raw);
+    free(writer->packed);
+    free(writer);
+    return NULL;
+}
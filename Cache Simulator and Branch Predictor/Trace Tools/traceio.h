@@ -0,0 +1,615 @@
+// Esperandieu Elbon II - UCFID: 5401262
+// EEL4768 Computer Architecture - Suboh Suboh - Fall 2023
+// Shared Trace Reader for the Cache and Branch Predictor Simulators
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#ifdef _WIN32
+#include <io.h>
+#define TRACE_READ _read
+#define TRACE_CLOSE _close
+#define TRACE_OPEN_FLAGS (_O_RDONLY | _O_BINARY)
+#else
+#include <unistd.h>
+#include <sys/mman.h>
+#define TRACE_READ read
+#define TRACE_CLOSE close
+#define TRACE_OPEN_FLAGS O_RDONLY
+#endif
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include "tracebin.h"
+#include "tracezip.h"
+
+// Cache trace record: "<R|W> <hex address>"
+typedef struct Access Access;
+struct Access {
+    char operation;
+    unsigned long long int address;
+};
+
+// Branch trace record: "<hex address> <t|n>"
+typedef struct Branch Branch;
+struct Branch {
+    unsigned long long int address;
+    char outcome;
+};
+
+// Extended branch trace record: "<hex address> <t|n> <type> <hex target>", type one of
+// c conditional, j direct jump, i indirect jump, l call (branch and link), r return.
+// Only the front-end model reads these fields (readControls); every other reader skips records
+// that aren't conditional branches, so extended traces work everywhere. Binary traces carry
+// conditional branches only
+#define CONTROL_CONDITIONAL 'c'
+#define CONTROL_JUMP 'j'
+#define CONTROL_INDIRECT 'i'
+#define CONTROL_CALL 'l'
+#define CONTROL_RETURN 'r'
+typedef struct Control {
+    unsigned long long int target;      // 0 when the record has none
+    char type;
+} Control;
+
+// Trace Reader
+// Regular files are mapped and parsed in place. Pipes, FIFOs and stdin ("-") are streamed
+// through a large buffer; a partial line at the end of a read is carried into the next one.
+// Binary traces (tracebin.h) are recognized by their header and decoded a block at a time.
+// gzip and zstd traces are decompressed in a child process (tracezip.h).
+//
+// Streamed input is a pipeline: decompression (when needed) in the child, parsing on a parser
+// thread, simulation on the caller's thread. The parser fills batches of decoded records in a
+// single-producer single-consumer ring and readAccesses/readBranches copy out of it, so a slow
+// pipe, a decompressor and the simulator all make progress at once. Build with -pthread.
+#define TRACE_BUFFER_SIZE (1 << 20)
+#define TRACE_MAX_LINE 256  // A record this far from the end of the buffer forces a refill
+#define TRACE_RING_BATCH 8192   // Records per ring slot
+#define TRACE_RING_DEPTH 8      // Slots in flight between the parser and the simulator
+#define TRACE_RING_LINE 64      // Host cache line size in bytes, for padding the ring indices
+#define TRACE_NO_OFFSET (~0ULL) // traceOffset of a stream: resume by counting records
+
+// Decoded batches between the parser thread and the reader's caller
+typedef struct TraceRing {
+    char *slots;                        // TRACE_RING_DEPTH * TRACE_RING_BATCH records
+    int sizes[TRACE_RING_DEPTH];        // Records published in each slot
+    char headPad[TRACE_RING_LINE];
+    atomic_ulong head;                  // Slots consumed by the caller, alone on its cache line
+    char tailPad[TRACE_RING_LINE - sizeof(atomic_ulong)];
+    atomic_ulong tail;                  // Slots published by the parser
+    atomic_int done, stop;              // Parser reached the end / caller closed the trace
+    int branches;                       // Record kind: Branch if set, Access otherwise
+    int cursor;                         // Records of the head slot already copied out
+    pthread_t thread;
+} TraceRing;
+
+typedef struct TraceReader {
+    int fd, mapped, eof;
+    char *data;                 // Mapped file or stream buffer
+    size_t length, position;    // Valid bytes in data, parse cursor
+    unsigned long long int base; // File offset of data[0]
+    int binary;                 // Set when the trace has a binary header
+    TraceHeader header;
+    unsigned char *block;       // Decoded payload of the current binary block
+    size_t blockLength, blockPosition;
+    unsigned long long int previous; // Last decoded (shifted) address, for deltas
+    unsigned long long int time;    // Timestamp of the last timed record (readTimedAccesses)
+    Decompressor *decompressor; // Child decompressing a gzip or zstd trace, or NULL
+    TraceRing *ring;            // Parser pipeline of a streamed trace, started on first read
+} TraceReader;
+
+TraceReader *openTrace(const char *path);
+int fillTrace(TraceReader *reader);
+int loadTraceBlock(TraceReader *reader);
+int nextBinaryRecord(TraceReader *reader, int kind, unsigned long long int *address, int *field);
+int parseAccesses(TraceReader *reader, Access *batch, unsigned long long int *times, int max);
+int parseBranches(TraceReader *reader, Branch *batch, Control *controls, int max);
+void *runTraceParser(void *arg);
+int readRing(TraceReader *reader, char *batch, int max, int branches);
+int readAccesses(TraceReader *reader, Access *batch, int max);
+int readBranches(TraceReader *reader, Branch *batch, int max);
+int readTimedAccesses(TraceReader *reader, Access *batch, unsigned long long int *times, int max);
+int readControls(TraceReader *reader, Branch *batch, Control *controls, int max);
+Branch *readAllBranches(TraceReader *reader, long long int *count);
+unsigned long long int traceOffset(TraceReader *reader);
+int resumeTrace(TraceReader *reader, unsigned long long int offset, long long int records, int branches);
+TraceReader *closeTrace(TraceReader *reader);
+double traceSeconds();
+void startTraceTimer();
+void printTraceRate();
+
+// Throughput for -time: records handed out by readAccesses/readBranches since the timer started
+long long int traceRecords = 0;
+double traceStart = 0.0;
+
+// Hex digit values, 0xFF for anything that isn't a digit
+unsigned char hexValue[256];
+int hexValueReady = 0;
+
+// Fill the digit table once
+void initHexValue() {
+    memset(hexValue, 0xFF, sizeof(hexValue));
+    for(int c = '0'; c <= '9'; c++) hexValue[c] = c - '0';
+    for(int c = 'a'; c <= 'f'; c++) hexValue[c] = c - 'a' + 10;
+    for(int c = 'A'; c <= 'F'; c++) hexValue[c] = c - 'A' + 10;
+    hexValueReady = 1;
+}
+
+// Open a trace for reading. Returns NULL if the path can't be opened
+TraceReader *openTrace(const char *path) {
+    if(!hexValueReady) initHexValue();
+    int fd = (strcmp(path, "-") == 0) ? 0 : open(path, TRACE_OPEN_FLAGS);
+    if(fd < 0) return NULL;
+
+    TraceReader *reader = (TraceReader *) malloc(sizeof(TraceReader));
+    reader->fd = fd;
+    reader->mapped = 0;
+    reader->eof = 0;
+    reader->length = reader->position = 0;
+    reader->base = 0;
+    reader->data = NULL;
+    reader->binary = 0;
+    reader->block = NULL;
+    reader->blockLength = reader->blockPosition = 0;
+    reader->previous = 0;
+    reader->time = 0;
+    reader->decompressor = NULL;
+    reader->ring = NULL;
+
+#ifndef _WIN32
+    // Map regular files whole
+    struct stat info;
+    if(fstat(fd, &info) == 0 && S_ISREG(info.st_mode) && info.st_size > 0) {
+        void *map = mmap(NULL, (size_t) info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if(map != MAP_FAILED) {
+            madvise(map, (size_t) info.st_size, MADV_SEQUENTIAL);
+            reader->data = (char *) map;
+            reader->length = (size_t) info.st_size;
+            reader->mapped = 1;
+            reader->eof = 1;
+        }
+    }
+#endif
+
+    // Anything else is streamed
+    if(!reader->mapped) {
+        reader->data = (char *) malloc(TRACE_BUFFER_SIZE);
+        fillTrace(reader);
+    }
+
+    // Compressed traces are read back through a decompressor, rewinding a mapped file
+    int format = traceCompression((const unsigned char *) reader->data, reader->length);
+    if(format != TRACE_PLAIN) {
+        reader->decompressor = startDecompressor(format, fd, reader->mapped, reader->data, reader->length);
+#ifndef _WIN32
+        if(reader->mapped) munmap(reader->data, reader->length);
+        else free(reader->data);
+#else
+        free(reader->data);
+#endif
+        reader->data = NULL;
+        reader->mapped = 0;
+        if(!reader->decompressor) return closeTrace(reader);
+        reader->fd = reader->decompressor->output;
+        reader->data = (char *) malloc(TRACE_BUFFER_SIZE);
+        reader->eof = 0;
+        reader->length = reader->position = 0;
+        fillTrace(reader);
+    }
+
+    // Binary traces start with a header; text traces never do
+    if(readTraceHeader((const unsigned char *) reader->data, reader->length, &reader->header)) {
+        reader->binary = 1;
+        reader->position = TRACE_HEADER_SIZE;
+        reader->block = (unsigned char *) malloc(TRACE_BLOCK_SIZE);
+    }
+    return reader;
+}
+
+// Move the unparsed tail to the front of the buffer and read until it's full or the input ends.
+// Returns the number of unparsed bytes available
+int fillTrace(TraceReader *reader) {
+    if(reader->mapped || reader->eof) return (int) (reader->length - reader->position);
+
+    size_t remaining = reader->length - reader->position;
+    memmove(reader->data, reader->data + reader->position, remaining);
+    reader->base += reader->position;
+    reader->position = 0;
+    reader->length = remaining;
+
+    while(reader->length < TRACE_BUFFER_SIZE) {
+        long int got = (long int) TRACE_READ(reader->fd, reader->data + reader->length, (unsigned int) (TRACE_BUFFER_SIZE - reader->length));
+        if(got <= 0) {
+            reader->eof = 1;
+            break;
+        }
+        reader->length += (size_t) got;
+    }
+    return (int) reader->length;
+}
+
+// Decode the next binary block into reader->block. Returns 0 at the end of the trace or on a
+// truncated or malformed block
+int loadTraceBlock(TraceReader *reader) {
+    if(reader->length - reader->position < TRACE_BLOCK_HEADER_SIZE) fillTrace(reader);
+    if(reader->length - reader->position < TRACE_BLOCK_HEADER_SIZE) return 0;
+
+    const unsigned char *header = (const unsigned char *) reader->data + reader->position;
+    unsigned int raw = getU32(header), stored = getU32(header + 4);
+    if(raw > TRACE_BLOCK_SIZE || stored > raw) return 0;
+    if(reader->length - reader->position < TRACE_BLOCK_HEADER_SIZE + stored) {
+        fillTrace(reader);
+        if(reader->length - reader->position < TRACE_BLOCK_HEADER_SIZE + stored) return 0;
+    }
+
+    // Payload follows the block header, compressed if it's shorter than the raw length
+    const unsigned char *payload = (const unsigned char *) reader->data + reader->position + TRACE_BLOCK_HEADER_SIZE;
+    if(stored == raw) memcpy(reader->block, payload, raw);
+    else if(decompressBlock(payload, (int) stored, reader->block, TRACE_BLOCK_SIZE) != (int) raw) return 0;
+
+    reader->position += TRACE_BLOCK_HEADER_SIZE + stored;
+    reader->blockLength = raw;
+    reader->blockPosition = 0;
+    reader->previous = 0;
+    return 1;
+}
+
+// Decode one binary record of the indicated kind: field gets a cache record's operation
+// character or a branch record's taken bit. Returns 0 at the end of the trace
+int nextBinaryRecord(TraceReader *reader, int kind, unsigned long long int *address, int *field) {
+    static const char operations[3] = {'R', 'W', 'I'};
+    if(reader->header.kind != kind) return 0;
+    unsigned long long int value;
+    int n;
+    while((n = getVarint(reader->block + reader->blockPosition, reader->block + reader->blockLength, &value)) == 0) {
+        if(!loadTraceBlock(reader)) return 0;
+    }
+    reader->blockPosition += n;
+
+    // Version 2 cache records carry a 2 bit op code, everything else a single bit
+    int bits = (kind == TRACE_KIND_CACHE && reader->header.version != TRACE_VERSION_WRITE_BIT) ? 2 : 1;
+    int code = (int) (value & ((1u << bits) - 1));
+    if(code == TRACE_OP_OTHER) {
+        if(reader->blockPosition >= reader->blockLength) return 0;
+        *field = reader->block[reader->blockPosition++];
+    }
+    else if(kind == TRACE_KIND_CACHE) *field = (bits == 2) ? operations[code] : (code ? 'W' : 'R');
+    else *field = code;
+    reader->previous += (unsigned long long int) unzigzag(value >> bits);
+    *address = reader->previous << reader->header.shift;
+    return 1;
+}
+
+// Decode up to max cache records into batch. Lines without an operation and a hex address are
+// skipped. When times is given, each record's timestamp (a decimal third field) goes there; a
+// record without one is one tick after the record before. Returns the number decoded; 0 once
+// the trace is exhausted
+int parseAccesses(TraceReader *reader, Access *batch, unsigned long long int *times, int max) {
+    int count = 0;
+    if(reader->binary) {
+        int operation;
+        while(count < max && nextBinaryRecord(reader, TRACE_KIND_CACHE, &batch[count].address, &operation)) {
+            batch[count].operation = (char) operation;
+            if(times) times[count] = ++reader->time;
+            count++;
+        }
+        return count;
+    }
+
+    while(count < max) {
+        if(!reader->eof && reader->length - reader->position < TRACE_MAX_LINE) fillTrace(reader);
+        const unsigned char *p = (const unsigned char *) reader->data + reader->position;
+        const unsigned char *end = (const unsigned char *) reader->data + reader->length;
+
+        // Skip blank space up to the operation
+        while(p < end && (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n')) p++;
+        if(p == end) {
+            reader->position = reader->length;
+            if(reader->eof) break;
+            continue;
+        }
+        char operation = (char) *p++;
+        while(p < end && (*p == ' ' || *p == '\t')) p++;
+
+        // Address, with or without a 0x prefix
+        if(p + 1 < end && p[0] == '0' && (p[1] == 'x' || p[1] == 'X')) p += 2;
+        unsigned long long int address = 0;
+        const unsigned char *digits = p;
+        unsigned char value;
+        while(p < end && (value = hexValue[*p]) != 0xFF) {
+            address = (address << 4) | value;
+            p++;
+        }
+
+        // Timestamp
+        int valid = p != digits;
+        if(times && valid) {
+            while(p < end && (*p == ' ' || *p == '\t')) p++;
+            if(p < end && *p >= '0' && *p <= '9') {
+                unsigned long long int time = 0;
+                while(p < end && *p >= '0' && *p <= '9') time = time * 10 + (unsigned long long int) (*p++ - '0');
+                reader->time = time;
+            }
+            else reader->time++;
+            times[count] = reader->time;
+        }
+
+        // Ignore anything else on the line
+        while(p < end && *p != '\n') p++;
+        reader->position = (size_t) (p - (const unsigned char *) reader->data);
+        if(!valid) continue;
+
+        batch[count].operation = operation;
+        batch[count].address = address;
+        count++;
+    }
+    return count;
+}
+
+// Decode up to max branch records into batch. Lines without a hex address and an outcome are
+// skipped. When controls is given, each record's type and target go there (a record without
+// them is a conditional branch); otherwise records that aren't conditional branches are skipped.
+// Returns the number decoded; 0 once the trace is exhausted
+int parseBranches(TraceReader *reader, Branch *batch, Control *controls, int max) {
+    int count = 0;
+    if(reader->binary) {
+        int taken;
+        while(count < max && nextBinaryRecord(reader, TRACE_KIND_BRANCH, &batch[count].address, &taken)) {
+            batch[count].outcome = taken ? 't' : 'n';
+            if(controls) {
+                controls[count].type = CONTROL_CONDITIONAL;
+                controls[count].target = 0;
+            }
+            count++;
+        }
+        return count;
+    }
+
+    while(count < max) {
+        if(!reader->eof && reader->length - reader->position < TRACE_MAX_LINE) fillTrace(reader);
+        const unsigned char *p = (const unsigned char *) reader->data + reader->position;
+        const unsigned char *end = (const unsigned char *) reader->data + reader->length;
+
+        // Skip blank space up to the address
+        while(p < end && (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n')) p++;
+        if(p == end) {
+            reader->position = reader->length;
+            if(reader->eof) break;
+            continue;
+        }
+
+        // Address, with or without a 0x prefix
+        if(p + 1 < end && p[0] == '0' && (p[1] == 'x' || p[1] == 'X')) p += 2;
+        unsigned long long int address = 0;
+        const unsigned char *digits = p;
+        unsigned char value;
+        while(p < end && (value = hexValue[*p]) != 0xFF) {
+            address = (address << 4) | value;
+            p++;
+        }
+        int valid = p != digits;
+
+        // Outcome
+        while(p < end && (*p == ' ' || *p == '\t')) p++;
+        char outcome = (p < end) ? (char) *p : '\n';
+        valid = valid && outcome != '\n' && outcome != '\r';
+
+        // Type and target of an extended record
+        char type = CONTROL_CONDITIONAL;
+        unsigned long long int target = 0;
+        if(valid) {
+            p++;
+            while(p < end && (*p == ' ' || *p == '\t')) p++;
+            if(p < end && *p != '\n' && *p != '\r') {
+                type = (char) *p++;
+                while(p < end && (*p == ' ' || *p == '\t')) p++;
+                if(p + 1 < end && p[0] == '0' && (p[1] == 'x' || p[1] == 'X')) p += 2;
+                while(controls && p < end && (value = hexValue[*p]) != 0xFF) {
+                    target = (target << 4) | value;
+                    p++;
+                }
+            }
+        }
+
+        // Ignore anything else on the line
+        while(p < end && *p != '\n') p++;
+        reader->position = (size_t) (p - (const unsigned char *) reader->data);
+        if(!valid || (!controls && type != CONTROL_CONDITIONAL)) continue;
+
+        batch[count].address = address;
+        batch[count].outcome = outcome;
+        if(controls) {
+            controls[count].type = type;
+            controls[count].target = target;
+        }
+        count++;
+    }
+    return count;
+}
+
+// Parser thread: decode the stream into free ring slots until it ends or the trace is closed
+void *runTraceParser(void *arg) {
+    TraceReader *reader = (TraceReader *) arg;
+    TraceRing *ring = reader->ring;
+    size_t record = ring->branches ? sizeof(Branch) : sizeof(Access);
+    unsigned long tail = 0;
+    for(;;) {
+        while(tail - atomic_load_explicit(&ring->head, memory_order_acquire) >= TRACE_RING_DEPTH) {
+            if(atomic_load_explicit(&ring->stop, memory_order_relaxed)) return NULL;
+            sched_yield();
+        }
+        int slot = (int) (tail % TRACE_RING_DEPTH);
+        char *batch = ring->slots + (size_t) slot * TRACE_RING_BATCH * record;
+        int size = ring->branches ? parseBranches(reader, (Branch *) batch, NULL, TRACE_RING_BATCH) : parseAccesses(reader, (Access *) batch, NULL, TRACE_RING_BATCH);
+        if(size <= 0) break;
+        ring->sizes[slot] = size;
+        tail++;
+        atomic_store_explicit(&ring->tail, tail, memory_order_release);
+    }
+    atomic_store_explicit(&ring->done, 1, memory_order_release);
+    return NULL;
+}
+
+// Copy up to max records of a streamed trace out of the ring, starting the parser thread on the
+// first call. A trace is read as one kind only. Returns the number copied; 0 once it's exhausted
+int readRing(TraceReader *reader, char *batch, int max, int branches) {
+    TraceRing *ring = reader->ring;
+    if(!ring) {
+        ring = reader->ring = (TraceRing *) calloc(1, sizeof(TraceRing));
+        ring->branches = branches;
+        ring->slots = (char *) malloc((size_t) TRACE_RING_DEPTH * TRACE_RING_BATCH * (branches ? sizeof(Branch) : sizeof(Access)));
+        atomic_init(&ring->head, 0);
+        atomic_init(&ring->tail, 0);
+        atomic_init(&ring->done, 0);
+        atomic_init(&ring->stop, 0);
+        pthread_create(&ring->thread, NULL, runTraceParser, reader);
+    }
+    if(ring->branches != branches) return 0;
+
+    size_t record = branches ? sizeof(Branch) : sizeof(Access);
+    unsigned long head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    int count = 0;
+    while(count < max) {
+        if(head == atomic_load_explicit(&ring->tail, memory_order_acquire)) {
+            if(atomic_load_explicit(&ring->done, memory_order_acquire) && head == atomic_load_explicit(&ring->tail, memory_order_acquire)) break;
+            sched_yield();
+            continue;
+        }
+
+        // Copy what the caller has room for; hand the slot back once it's drained
+        int slot = (int) (head % TRACE_RING_DEPTH), take = ring->sizes[slot] - ring->cursor;
+        if(take > max - count) take = max - count;
+        memcpy(batch + (size_t) count * record, ring->slots + ((size_t) slot * TRACE_RING_BATCH + ring->cursor) * record, (size_t) take * record);
+        count += take;
+        ring->cursor += take;
+        if(ring->cursor == ring->sizes[slot]) {
+            ring->cursor = 0;
+            head++;
+            atomic_store_explicit(&ring->head, head, memory_order_release);
+        }
+    }
+    return count;
+}
+
+// Decode up to max cache records into batch: parsed in place for mapped traces, through the
+// parser pipeline for streams. Returns the number decoded; 0 once the trace is exhausted
+int readAccesses(TraceReader *reader, Access *batch, int max) {
+    int count = reader->mapped ? parseAccesses(reader, batch, NULL, max) : readRing(reader, (char *) batch, max, 0);
+    traceRecords += count;
+    return count;
+}
+
+// Decode up to max cache records and their timestamps (see parseAccesses). Timed reads are
+// always parsed in place, streams included. Returns the number decoded; 0 once it's exhausted
+int readTimedAccesses(TraceReader *reader, Access *batch, unsigned long long int *times, int max) {
+    if(reader->ring) return 0;
+    int count = parseAccesses(reader, batch, times, max);
+    traceRecords += count;
+    return count;
+}
+
+// Decode up to max branch records into batch, like readAccesses
+int readBranches(TraceReader *reader, Branch *batch, int max) {
+    int count = reader->mapped ? parseBranches(reader, batch, NULL, max) : readRing(reader, (char *) batch, max, 1);
+    traceRecords += count;
+    return count;
+}
+
+// Decode up to max branch records of any type with their types and targets (see parseBranches).
+// Parsed in place like readTimedAccesses. Returns the number decoded; 0 once it's exhausted
+int readControls(TraceReader *reader, Branch *batch, Control *controls, int max) {
+    if(reader->ring) return 0;
+    int count = parseBranches(reader, batch, controls, max);
+    traceRecords += count;
+    return count;
+}
+
+// Decode the rest of the trace into one array, for simulators that replay it many times.
+// Returns the array (free() it) and sets count
+Branch *readAllBranches(TraceReader *reader, long long int *count) {
+    long long int capacity = 1 << 16;
+    Branch *branches = (Branch *) malloc((size_t) capacity * sizeof(Branch));
+    *count = 0;
+    int size;
+    while((size = readBranches(reader, branches + *count, (int) ((capacity - *count < (1 << 20)) ? capacity - *count : (1 << 20)))) > 0) {
+        *count += size;
+        if(*count == capacity) {
+            capacity *= 2;
+            branches = (Branch *) realloc(branches, (size_t) capacity * sizeof(Branch));
+        }
+    }
+    return branches;
+}
+
+// Byte offset in the trace of the next unparsed record. Streams parse ahead of the caller, so
+// they report TRACE_NO_OFFSET
+unsigned long long int traceOffset(TraceReader *reader) {
+    if(!reader->mapped) return TRACE_NO_OFFSET;
+    return reader->base + reader->position;
+}
+
+// Positions a trace just past the records an earlier run consumed (see traceOffset). Mapped
+// text traces jump straight to the byte offset; streams and binary traces are read forward
+// record by record. Returns 1 on success
+int resumeTrace(TraceReader *reader, unsigned long long int offset, long long int records, int branches) {
+    if(reader->mapped && !reader->binary && offset != TRACE_NO_OFFSET) {
+        if(offset > reader->length) return 0;
+        reader->position = (size_t) offset;
+        return 1;
+    }
+    void *batch = malloc(4096 * (branches ? sizeof(Branch) : sizeof(Access)));
+    while(records > 0) {
+        int max = (records < 4096) ? (int) records : 4096;
+        int size = branches ? readBranches(reader, (Branch *) batch, max) : readAccesses(reader, (Access *) batch, max);
+        if(size <= 0) break;
+        records -= size;
+    }
+    free(batch);
+    return records == 0;
+}
+
+// Stop the pipeline, unmap or free the buffer and close the trace
+TraceReader *closeTrace(TraceReader *reader) {
+    if(reader->ring) {
+        // The parser may be blocked on a pipe that has nothing more to say
+        atomic_store_explicit(&reader->ring->stop, 1, memory_order_relaxed);
+        if(!atomic_load_explicit(&reader->ring->done, memory_order_acquire)) pthread_cancel(reader->ring->thread);
+        pthread_join(reader->ring->thread, NULL);
+        free(reader->ring->slots);
+        free(reader->ring);
+    }
+#ifndef _WIN32
+    if(reader->mapped) munmap(reader->data, reader->length);
+    else free(reader->data);
+#else
+    free(reader->data);
+#endif
+    if(reader->decompressor) stopDecompressor(reader->decompressor);
+    else if(reader->fd != 0) TRACE_CLOSE(reader->fd);
+    free(reader->block);
+    free(reader);
+    return NULL;
+}
+
+// Wall clock seconds
+double traceSeconds() {
+    struct timespec now;
+    timespec_get(&now, TIME_UTC);
+    return (double) now.tv_sec + (double) now.tv_nsec * 1e-9;
+}
+
+// Starts timing and reports the rate when the program exits
+void startTraceTimer() {
+    traceRecords = 0;
+    traceStart = traceSeconds();
+    atexit(printTraceRate);
+}
+
+// Elapsed time and records per second, on stderr so results on stdout stay comparable
+void printTraceRate() {
+    double elapsed = traceSeconds() - traceStart;
+    fprintf(stderr, "Time: %.3f s\tRecords: %lld\tRecords/s: %.0f\n", elapsed, traceRecords, (elapsed > 0.0) ? (double) traceRecords / elapsed : 0.0);
+}
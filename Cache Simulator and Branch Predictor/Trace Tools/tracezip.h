@@ -0,0 +1,159 @@
+// Esperandieu Elbon II - UCFID: 5401262
+// EEL4768 Computer Architecture - Suboh Suboh - Fall 2023
+// Compressed Trace Input
+//
+// gzip and zstd traces are recognized by their magic bytes and decompressed by the system gzip
+// or zstd tool running as a child process, so the simulators link no compression library and
+// decompression gets a core of its own. The trace reader parses the child's output pipe. A
+// regular file is handed to the child directly; for stdin and FIFOs a feeder thread forwards the
+// bytes read while sniffing the format, then the rest of the input. Not available on Windows.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#ifndef _WIN32
+#include <signal.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#endif
+
+#define TRACE_PLAIN 0
+#define TRACE_GZIP 1
+#define TRACE_ZSTD 2
+#define FEED_BUFFER_SIZE (1 << 16)
+
+// Child process decompressing one trace
+typedef struct Decompressor {
+    int format;
+    int input;                  // Compressed trace (0 for stdin)
+    int output;                 // Read end of the child's stdout
+#ifndef _WIN32
+    pid_t child;
+#endif
+    int feed;                   // Write end of the child's stdin, -1 when it reads the trace itself
+    int fed;                    // Set once the feeder has closed feed
+    char *pending;              // Bytes already taken from input, sent ahead of the rest
+    size_t pendingLength;
+    pthread_t feeder;
+} Decompressor;
+
+// Decompression Functions
+int traceCompression(const unsigned char *data, size_t length);
+Decompressor *startDecompressor(int format, int input, int seekable, const char *pending, size_t pendingLength);
+void *feedDecompressor(void *arg);
+int writeAll(int fd, const char *data, size_t length);
+void stopDecompressor(Decompressor *decompressor);
+
+// Format of a trace from its first bytes: TRACE_PLAIN, TRACE_GZIP or TRACE_ZSTD
+int traceCompression(const unsigned char *data, size_t length) {
+    if(length >= 2 && data[0] == 0x1F && data[1] == 0x8B) return TRACE_GZIP;
+    if(length >= 4 && data[0] == 0x28 && data[1] == 0xB5 && data[2] == 0x2F && data[3] == 0xFD) return TRACE_ZSTD;
+    return TRACE_PLAIN;
+}
+
+// Writes the whole buffer to fd. Returns 1 on success
+int writeAll(int fd, const char *data, size_t length) {
+#ifndef _WIN32
+    while(length > 0) {
+        ssize_t wrote = write(fd, data, length);
+        if(wrote <= 0) return 0;
+        data += wrote;
+        length -= (size_t) wrote;
+    }
+    return 1;
+#else
+    return 0;
+#endif
+}
+
+// Feeder thread: pending bytes first, then the rest of the input, then end of file
+void *feedDecompressor(void *arg) {
+#ifndef _WIN32
+    Decompressor *decompressor = (Decompressor *) arg;
+    int ok = writeAll(decompressor->feed, decompressor->pending, decompressor->pendingLength);
+    char *buffer = (char *) malloc(FEED_BUFFER_SIZE);
+    ssize_t got;
+    while(ok && (got = read(decompressor->input, buffer, FEED_BUFFER_SIZE)) > 0) ok = writeAll(decompressor->feed, buffer, (size_t) got);
+    free(buffer);
+    close(decompressor->feed);
+    decompressor->fed = 1;
+#endif
+    return NULL;
+}
+
+// Starts gzip -dc or zstd -dc on a compressed trace. A seekable input is rewound and read by the
+// child; otherwise the pending bytes and the rest of the input go through a feeder thread.
+// Returns NULL if the child can't be started
+Decompressor *startDecompressor(int format, int input, int seekable, const char *pending, size_t pendingLength) {
+#ifndef _WIN32
+    const char *program = (format == TRACE_ZSTD) ? "zstd" : "gzip";
+    int out[2], in[2] = {-1, -1};
+    if(seekable && lseek(input, 0, SEEK_SET) != 0) return NULL;
+    if(pipe(out) != 0) return NULL;
+    if(!seekable && pipe(in) != 0) {
+        close(out[0]);
+        close(out[1]);
+        return NULL;
+    }
+
+    // A child that exits early must not kill the simulator through the feeder's writes
+    signal(SIGPIPE, SIG_IGN);
+    pid_t child = fork();
+    if(child == 0) {
+        dup2(seekable ? input : in[0], 0);
+        dup2(out[1], 1);
+        close(out[0]);
+        close(out[1]);
+        if(!seekable) {
+            close(in[0]);
+            close(in[1]);
+        }
+        execlp(program, program, "-dcq", (char *) NULL);
+        fprintf(stderr, "Can't run %s to decompress the trace.\n", program);
+        _exit(127);
+    }
+    close(out[1]);
+    if(!seekable) close(in[0]);
+    if(child < 0) {
+        close(out[0]);
+        if(!seekable) close(in[1]);
+        return NULL;
+    }
+
+    Decompressor *decompressor = (Decompressor *) calloc(1, sizeof(Decompressor));
+    decompressor->format = format;
+    decompressor->input = input;
+    decompressor->output = out[0];
+    decompressor->child = child;
+    decompressor->feed = in[1];
+    decompressor->fed = seekable;
+    if(!seekable) {
+        decompressor->pending = (char *) malloc(pendingLength > 0 ? pendingLength : 1);
+        memcpy(decompressor->pending, pending, pendingLength);
+        decompressor->pendingLength = pendingLength;
+        pthread_create(&decompressor->feeder, NULL, feedDecompressor, decompressor);
+    }
+    return decompressor;
+#else
+    return NULL;
+#endif
+}
+
+// Ends the child and the feeder, whether or not the trace was read to the end
+void stopDecompressor(Decompressor *decompressor) {
+#ifndef _WIN32
+    close(decompressor->output);
+    kill(decompressor->child, SIGTERM);
+    waitpid(decompressor->child, NULL, 0);
+    if(decompressor->feed >= 0) {
+        pthread_cancel(decompressor->feeder);
+        pthread_join(decompressor->feeder, NULL);
+        if(!decompressor->fed) close(decompressor->feed);
+    }
+    if(decompressor->input != 0) close(decompressor->input);
+#endif
+    free(decompressor->pending);
+    free(decompressor);
+}